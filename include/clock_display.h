@@ -0,0 +1,33 @@
+#ifndef CLOCK_DISPLAY_H
+#define CLOCK_DISPLAY_H
+
+#include <stdint.h>
+#include "time_format.h"
+#include "tz_rules.h"
+
+// Text for the display at a tick edge, worked out from its inputs alone so
+// any moment can be replayed: the count up/down while a target is set,
+// otherwise the local time of day.
+
+typedef struct {
+    TimeCounters countUpDown;
+    TimeCounters clock;
+} DisplayCounters;
+
+// utc and target are Unix seconds, target 0 for none. out must hold at
+// least 24 chars.
+inline size_t formatDisplay(DisplayCounters *c, TzRules *zone, int64_t utc, int64_t target,
+                            bool twelveHour, bool colon, char *out) {
+    if (target > 0) {
+        int64_t seconds = target - utc;
+        if (seconds < 0) {
+            seconds = -seconds;
+        }
+        return formatCountUpDown(&c->countUpDown, seconds, colon, out);
+    }
+    // Only the cached offset is applied, the rule is re-evaluated when a
+    // transition passes.
+    return formatClock(&c->clock, tzLocal(zone, utc), twelveHour, out);
+}
+
+#endif // CLOCK_DISPLAY_H
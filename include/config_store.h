@@ -0,0 +1,123 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc32.h"
+
+// Binary settings record: a header and the settings packed behind it, numbers
+// as they are in RAM (little endian on both ESPs), each string as a length
+// byte and its characters. A record is only as long as the strings in it,
+// usually under 200 bytes, small enough for littlefs to store inline in its
+// metadata instead of in a data block of its own.
+//
+// The newest save is one file and the save before it another (see
+// saveConfigBinary()), so a boot reads one file and /restore has a previous
+// save to go back to.
+//
+// New fields are packed last with CONFIG_VERSION bumped. Older records end
+// earlier (size), the fields they didn't have unpack as zeros.
+
+#define CONFIG_MAGIC        0x43484331UL  // "CHC1"
+#define CONFIG_VERSION      1
+#define CONFIG_PAYLOAD_MAX  1536          // Everything at its longest, checked where it is packed
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;     // Bytes of payload
+    uint32_t crc;      // CRC-32 of the fields above and size bytes of payload
+    uint8_t  payload[CONFIG_PAYLOAD_MAX];
+} ConfigRecord;
+
+#define CONFIG_HEADER_SIZE offsetof(ConfigRecord, payload)
+
+inline uint32_t configRecordCrc(const ConfigRecord *rec) {
+    uint32_t crc = crc32Compute(rec, offsetof(ConfigRecord, crc));
+    return crc32Compute(rec->payload, rec->size, crc);
+}
+
+// Bytes of rec to write.
+inline size_t configRecordLength(const ConfigRecord *rec) {
+    return CONFIG_HEADER_SIZE + rec->size;
+}
+
+inline void configRecordSeal(ConfigRecord *rec, size_t size) {
+    rec->magic   = CONFIG_MAGIC;
+    rec->version = CONFIG_VERSION;
+    rec->size    = (uint16_t)size;
+    rec->crc     = configRecordCrc(rec);
+}
+
+// rec holds length bytes read from a file.
+inline bool configRecordValid(const ConfigRecord *rec, size_t length) {
+    if (length < CONFIG_HEADER_SIZE || rec->magic != CONFIG_MAGIC || rec->version > CONFIG_VERSION) return false;
+    if (rec->size > CONFIG_PAYLOAD_MAX || length < configRecordLength(rec)) return false;
+    return rec->crc == configRecordCrc(rec);
+}
+
+// Packs fields into a payload, in the order they are unpacked.
+typedef struct {
+    uint8_t *p;
+    uint8_t *start;
+} ConfigPacker;
+
+inline ConfigPacker configPacker(ConfigRecord *rec) {
+    return {rec->payload, rec->payload};
+}
+
+inline size_t configPacked(const ConfigPacker *pk) {
+    return (size_t)(pk->p - pk->start);
+}
+
+inline void configPackBytes(ConfigPacker *pk, const void *src, size_t size) {
+    memcpy(pk->p, src, size);
+    pk->p += size;
+}
+
+// s is a field of size bytes, so at most size - 1 characters.
+inline void configPackString(ConfigPacker *pk, const char *s, size_t size) {
+    size_t n = strnlen(s, size - 1);
+    *pk->p++ = (uint8_t)n;
+    configPackBytes(pk, s, n);
+}
+
+// Unpacks a valid record's fields. Where the payload ends, the remaining
+// fields are zeroed. torn is set if it ends inside a field or a string
+// doesn't fit its field, which a valid CRC makes a record of another layout.
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool           torn;
+} ConfigUnpacker;
+
+inline ConfigUnpacker configUnpacker(const ConfigRecord *rec) {
+    return {rec->payload, rec->payload + rec->size, false};
+}
+
+inline void configUnpackBytes(ConfigUnpacker *u, void *dst, size_t size) {
+    if ((size_t)(u->end - u->p) < size) {
+        u->torn = u->torn || u->p != u->end;
+        u->p = u->end;
+        memset(dst, 0, size);
+        return;
+    }
+    memcpy(dst, u->p, size);
+    u->p += size;
+}
+
+inline void configUnpackString(ConfigUnpacker *u, char *dst, size_t size) {
+    size_t n = u->p < u->end ? *u->p : 0;
+    if (u->p == u->end || n >= size || (size_t)(u->end - u->p) < 1 + n) {
+        u->torn = u->torn || u->p != u->end;
+        u->p = u->end;
+        dst[0] = '\0';
+        return;
+    }
+    memcpy(dst, u->p + 1, n);
+    dst[n] = '\0';
+    u->p += 1 + n;
+}
+
+#endif // CONFIG_STORE_H
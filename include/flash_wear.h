@@ -0,0 +1,82 @@
+#ifndef FLASH_WEAR_H
+#define FLASH_WEAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Write accounting for the LittleFS persistence. Every write session (open,
+// write, close) is reported with the file (an index below 32 the caller
+// gives it), the offset it started at and the bytes it wrote; what that
+// costs the flash is estimated from how littlefs works, as
+// it doesn't report what it programs:
+//  - A file reopened to append can't continue in its partly written last
+//    block. littlefs copies that block's data into a freshly erased block
+//    and appends there, so a 20 byte append can reprogram up to a block.
+//  - Data is programmed in FLASH_PROG_SIZE units, every block entered is
+//    erased first.
+//  - Closing, renaming or removing a file commits metadata: one program unit
+//    in a metadata pair, which is erased and compacted when it fills.
+//  - A file written whole and no larger than FLASH_INLINE_SIZE is stored
+//    inline in its metadata: its data goes out with the commit, no data
+//    block is erased for it. That it fills the pair sooner is left out.
+
+#define FLASH_BLOCK_SIZE  4096
+#define FLASH_PROG_SIZE   256     // ESP8266 core page size, larger than the ESP32's
+#define FLASH_INLINE_SIZE 256     // littlefs' inline limit, its cache size
+#define FLASH_ENDURANCE   100000  // Erase cycles of a typical SPI NOR block
+
+typedef struct {
+    uint64_t logicalBytes;   // Handed to write()
+    uint64_t physicalBytes;  // Estimated programmed, data and metadata
+    uint32_t erases;         // Estimated block erases
+    uint32_t sessions;       // Write sessions
+    uint32_t commits;        // Metadata commits
+    uint32_t files;          // Bit per file index written to
+} FlashWear;
+
+inline uint32_t flashRoundUp(uint32_t bytes, uint32_t unit) {
+    return (bytes + unit - 1) / unit * unit;
+}
+
+// A metadata commit. Each of a pair's blocks takes a block's worth of
+// commits before both are compacted, so an erase every half of that.
+inline void flashWearCommit(FlashWear *w) {
+    w->commits++;
+    w->physicalBytes += FLASH_PROG_SIZE;
+    if (w->commits % (FLASH_BLOCK_SIZE / FLASH_PROG_SIZE / 2) == 0) {
+        w->erases++;
+    }
+}
+
+// A write session of bytes at offset (0 for a new or truncated file) of
+// file, including the commit closing it.
+inline void flashWearWrite(FlashWear *w, uint8_t file, uint32_t offset, uint32_t bytes) {
+    w->logicalBytes += bytes;
+    w->sessions++;
+    w->files |= 1UL << (file & 31);
+    if (offset == 0 && bytes <= FLASH_INLINE_SIZE) {
+        w->physicalBytes += flashRoundUp(bytes, FLASH_PROG_SIZE);
+    } else {
+        uint32_t tail = offset % FLASH_BLOCK_SIZE;  // Copied from the last block
+        w->physicalBytes += flashRoundUp(tail + bytes, FLASH_PROG_SIZE);
+        w->erases += flashRoundUp(tail + bytes, FLASH_BLOCK_SIZE) / FLASH_BLOCK_SIZE;
+    }
+    flashWearCommit(w);
+}
+
+// Distinct files written to.
+inline uint8_t flashWearFiles(const FlashWear *w) {
+    return (uint8_t)__builtin_popcount(w->files);
+}
+
+// Days until the average block reaches FLASH_ENDURANCE erases, with wear
+// spread over all blocks of the filesystem. 0 if nothing was erased.
+inline double flashWearLifetimeDays(const FlashWear *w, uint32_t uptimeS, size_t fsBytes) {
+    if (w->erases == 0 || uptimeS == 0) {
+        return 0;
+    }
+    double erasesPerDay = (double)w->erases * 86400 / uptimeS;
+    return (double)(fsBytes / FLASH_BLOCK_SIZE) * FLASH_ENDURANCE / erasesPerDay;
+}
+
+#endif // FLASH_WEAR_H
@@ -0,0 +1,67 @@
+#ifndef FORM_PARSE_H
+#define FORM_PARSE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Parsing of the values browsers post from the settings form: checkboxes and
+// the date and time inputs.
+
+inline bool formBool(const char *value) {
+    return strcmp(value, "true") == 0 || strcmp(value, "on") == 0 || strcmp(value, "1") == 0;
+}
+
+inline bool parseFixedDigits(const char *p, uint8_t count, int *out) {
+    int v = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return false;
+        }
+        v = v * 10 + (p[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+// "YYYY-MM-DD" and "HH:MM[:SS]" into a local time tm (time inputs leave
+// out the seconds when they are zero). Returns the position after the time,
+// or nullptr if either part is malformed.
+inline const char *parseDateTime(const char *date, const char *time, struct tm *tm) {
+    int year, month, day, hour, minute, second = 0;
+    if (!parseFixedDigits(date, 4, &year) || date[4] != '-' || !parseFixedDigits(date + 5, 2, &month) ||
+        date[7] != '-' || !parseFixedDigits(date + 8, 2, &day) ||
+        !parseFixedDigits(time, 2, &hour) || time[2] != ':' || !parseFixedDigits(time + 3, 2, &minute)) {
+        return nullptr;
+    }
+    const char *end = time + 5;
+    if (*end == ':') {
+        if (!parseFixedDigits(end + 1, 2, &second)) {
+            return nullptr;
+        }
+        end += 3;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+        return nullptr;
+    }
+    memset(tm, 0, sizeof(*tm));
+    tm->tm_year = year - 1900;
+    tm->tm_mon = month - 1;
+    tm->tm_mday = day;
+    tm->tm_hour = hour;
+    tm->tm_min = minute;
+    tm->tm_sec = second;
+    tm->tm_isdst = -1;
+    return end;
+}
+
+// "YYYY-MM-DD HH:MM[:SS]", with a space or a T, as a local time tm.
+inline bool parseLocalDateTime(const char *dateTime, struct tm *tm) {
+    const char *end = nullptr;
+    if (strlen(dateTime) >= 16 && (dateTime[10] == ' ' || dateTime[10] == 'T')) {
+        end = parseDateTime(dateTime, dateTime + 11, tm);
+    }
+    return end && *end == '\0';
+}
+
+#endif // FORM_PARSE_H
@@ -0,0 +1,45 @@
+#ifndef HOST_COMPAT_H
+#define HOST_COMPAT_H
+
+// Arduino.h on the boards. Elsewhere (a plain g++ on a PC, for trying out the
+// logic in include/) the few Arduino pieces the portable headers use: flash
+// string access maps to the normal string functions and Print formats into
+// a write() the caller provides.
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define F(s)           (s)
+#define memcpy_P       memcpy
+#define strcmp_P       strcmp
+#define strcpy_P       strcpy
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t *data, size_t len) = 0;
+    size_t print(const char *s) {
+        return write((const uint8_t *)s, strlen(s));
+    }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (n < 0) {
+            return 0;
+        }
+        return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+    }
+};
+#endif
+
+#endif // HOST_COMPAT_H
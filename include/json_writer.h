@@ -0,0 +1,122 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Streaming JSON writer into a caller supplied buffer, for responses built
+// without a JsonDocument or any heap allocation. Commas between members and
+// elements are inserted automatically. Output that doesn't fit sets overflow
+// and is truncated; the buffer always stays NUL terminated.
+
+typedef struct {
+    char   *buf;
+    size_t  size;
+    size_t  len;
+    bool    needComma;
+    bool    overflow;
+} JsonWriter;
+
+inline void jsonInit(JsonWriter *w, char *buf, size_t size) {
+    w->buf       = buf;
+    w->size      = size;
+    w->len       = 0;
+    w->needComma = false;
+    w->overflow  = false;
+    buf[0] = '\0';
+}
+
+inline void jsonPut(JsonWriter *w, const char *s, size_t n) {
+    if (w->len + n >= w->size) {
+        n = w->size - 1 - w->len;
+        w->overflow = true;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+    w->buf[w->len] = '\0';
+}
+
+inline void jsonRaw(JsonWriter *w, const char *s) {
+    jsonPut(w, s, strlen(s));
+}
+
+inline void jsonSeparator(JsonWriter *w) {
+    if (w->needComma) {
+        jsonPut(w, ",", 1);
+    }
+    w->needComma = true;
+}
+
+inline void jsonQuoted(JsonWriter *w, const char *s) {
+    jsonPut(w, "\"", 1);
+    const char *run = s;
+    for (; *s; s++) {
+        uint8_t c = (uint8_t)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        jsonPut(w, run, s - run);
+        char esc[7];
+        switch (c) {
+            case '"':  jsonPut(w, "\\\"", 2); break;
+            case '\\': jsonPut(w, "\\\\", 2); break;
+            case '\n': jsonPut(w, "\\n", 2); break;
+            case '\r': jsonPut(w, "\\r", 2); break;
+            case '\t': jsonPut(w, "\\t", 2); break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                jsonPut(w, esc, 6);
+        }
+        run = s + 1;
+    }
+    jsonPut(w, run, s - run);
+    jsonPut(w, "\"", 1);
+}
+
+// --- Containers, key is nullptr for array elements and the root ---
+inline void jsonBegin(JsonWriter *w, const char *key, char open) {
+    jsonSeparator(w);
+    if (key) {
+        jsonQuoted(w, key);
+        jsonPut(w, ":", 1);
+    }
+    jsonPut(w, &open, 1);
+    w->needComma = false;
+}
+
+inline void jsonEnd(JsonWriter *w, char close) {
+    jsonPut(w, &close, 1);
+    w->needComma = true;
+}
+
+inline void jsonObjectBegin(JsonWriter *w, const char *key = nullptr) { jsonBegin(w, key, '{'); }
+inline void jsonObjectEnd(JsonWriter *w)                              { jsonEnd(w, '}'); }
+inline void jsonArrayBegin(JsonWriter *w, const char *key = nullptr)  { jsonBegin(w, key, '['); }
+inline void jsonArrayEnd(JsonWriter *w)                               { jsonEnd(w, ']'); }
+
+// --- Values, key is nullptr for array elements ---
+inline void jsonKey(JsonWriter *w, const char *key) {
+    jsonSeparator(w);
+    if (key) {
+        jsonQuoted(w, key);
+        jsonPut(w, ":", 1);
+    }
+}
+
+inline void jsonString(JsonWriter *w, const char *key, const char *value) {
+    jsonKey(w, key);
+    jsonQuoted(w, value);
+}
+
+inline void jsonInt(JsonWriter *w, const char *key, int64_t value) {
+    char num[21];
+    int n = snprintf(num, sizeof(num), "%lld", (long long)value);
+    jsonKey(w, key);
+    jsonPut(w, num, n);
+}
+
+inline void jsonBool(JsonWriter *w, const char *key, bool value) {
+    jsonKey(w, key);
+    jsonRaw(w, value ? "true" : "false");
+}
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,83 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "host_compat.h"
+
+// Fixed size timing histograms for /metrics. Recording is a few compares and
+// adds with no allocation or formatting; the Prometheus text is only written
+// when the endpoint is scraped.
+
+#define METRICS_BUCKETS 10  // Upper bounds of 16us * 4^i (16us .. 4.2s), plus +Inf
+
+typedef struct {
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs;
+    uint32_t buckets[METRICS_BUCKETS + 1];  // Not cumulative, the last one is +Inf
+} MetricsHistogram;
+
+// Request count and handler time of one web server route.
+typedef struct {
+    const char *path;
+    uint32_t    count;
+    uint32_t    maxUs;
+    uint64_t    sumUs;
+} MetricsRoute;
+
+inline uint32_t metricsBucketBound(uint8_t i) {
+    return 16UL << (2 * i);
+}
+
+inline void metricsRecord(MetricsHistogram *h, uint32_t us) {
+    uint8_t i = 0;
+    while (i < METRICS_BUCKETS && us > metricsBucketBound(i)) {
+        i++;
+    }
+    h->buckets[i]++;
+    h->count++;
+    h->sumUs += us;
+    if (us > h->maxUs) {
+        h->maxUs = us;
+    }
+}
+
+inline void metricsRouteRecord(MetricsRoute *r, uint32_t us) {
+    r->count++;
+    r->sumUs += us;
+    if (us > r->maxUs) {
+        r->maxUs = us;
+    }
+}
+
+// --- Prometheus text format ---
+inline void metricsHeader(Print &out, const char *name, const char *type, const char *help) {
+    out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// label is a single name="value" pair, or nullptr.
+inline void metricsValue(Print &out, const char *name, const char *label, double value) {
+    if (label) {
+        out.printf("%s{%s} %.6f\n", name, label, value);
+    } else {
+        out.printf("%s %.6f\n", name, value);
+    }
+}
+
+inline void metricsHistogram(Print &out, const char *name, const char *label, const MetricsHistogram *h) {
+    const char *sep = label ? "," : "";
+    label = label ? label : "";
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < METRICS_BUCKETS; i++) {
+        cumulative += h->buckets[i];
+        out.printf("%s_bucket{%s%sle=\"%.6f\"} %lu\n", name, label, sep, metricsBucketBound(i) / 1e6, (unsigned long)cumulative);
+    }
+    cumulative += h->buckets[METRICS_BUCKETS];
+    out.printf("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, label, sep, (unsigned long)cumulative);
+    if (*label) {
+        out.printf("%s_sum{%s} %.6f\n%s_count{%s} %lu\n", name, label, h->sumUs / 1e6, name, label, (unsigned long)h->count);
+    } else {
+        out.printf("%s_sum %.6f\n%s_count %lu\n", name, h->sumUs / 1e6, name, (unsigned long)h->count);
+    }
+}
+
+#endif // METRICS_H
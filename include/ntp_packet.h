@@ -0,0 +1,73 @@
+#ifndef NTP_PACKET_H
+#define NTP_PACKET_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Minimal SNTP (RFC 4330) client packet handling. Times are Unix
+// microseconds; on the wire they are 32.32 fixed point seconds since 1900.
+
+#define NTP_PACKET_SIZE   48
+#define NTP_PORT          123
+#define NTP_UNIX_OFFSET   2208988800LL  // Seconds from 1900 to 1970
+#define NTP_ERA_PIVOT     0x80000000UL  // Wire seconds below this are past 2036 (era 1)
+
+typedef struct {
+    int64_t offsetUs;  // Server clock - local clock
+    int64_t delayUs;   // Round trip minus server processing time
+    uint8_t stratum;   // Server stratum
+} NtpSample;
+
+inline void ntpWriteTimestamp(uint8_t *p, int64_t unixUs) {
+    uint32_t sec  = (uint32_t)(unixUs / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)((((uint64_t)(unixUs % 1000000) << 32) + 999999) / 1000000); // Rounded up so reads are exact
+    p[0] = sec >> 24;  p[1] = sec >> 16;  p[2] = sec >> 8;  p[3] = sec;
+    p[4] = frac >> 24; p[5] = frac >> 16; p[6] = frac >> 8; p[7] = frac;
+}
+
+inline int64_t ntpReadTimestamp(const uint8_t *p) {
+    uint32_t sec  = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    uint32_t frac = (uint32_t)p[4] << 24 | (uint32_t)p[5] << 16 | (uint32_t)p[6] << 8 | p[7];
+    int64_t secs = (int64_t)sec - NTP_UNIX_OFFSET;
+    if (sec < NTP_ERA_PIVOT) {
+        secs += 0x100000000LL;
+    }
+    return secs * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+// Client request, version 4 mode 3. The transmit timestamp is echoed back by
+// the server as the originate timestamp, which ties replies to requests.
+inline void ntpBuildRequest(uint8_t *pkt, int64_t txUnixUs) {
+    memset(pkt, 0, NTP_PACKET_SIZE);
+    pkt[0] = 0x23;  // LI 0, VN 4, mode 3
+    ntpWriteTimestamp(&pkt[40], txUnixUs);
+}
+
+// Validate a server reply to request and compute offset and delay.
+// t1: local send time, t4: local receive time.
+inline bool ntpParseReply(const uint8_t *pkt, size_t len, const uint8_t *request, int64_t t1, int64_t t4, NtpSample *out) {
+    if (len < NTP_PACKET_SIZE) return false;
+    if ((pkt[0] & 0x07) != 4) return false;            // Not a server reply
+    if ((pkt[0] >> 6) == 3) return false;              // Server clock unsynchronized
+    if (pkt[1] == 0 || pkt[1] > 15) return false;      // Kiss-o'-death or invalid stratum
+    if (memcmp(&pkt[24], &request[40], 8) != 0) return false; // Not our request
+    int64_t t2 = ntpReadTimestamp(&pkt[32]);           // Server receive
+    int64_t t3 = ntpReadTimestamp(&pkt[40]);           // Server transmit
+    out->offsetUs = ((t2 - t1) + (t3 - t4)) / 2;
+    out->delayUs  = (t4 - t1) - (t3 - t2);
+    out->stratum  = pkt[1];
+    return out->delayUs >= 0;
+}
+
+// A kiss-o'-death reply to request (stratum 0): the server wants the client
+// to back off (RATE) or stop using it (DENY, RSTR). code gets the four
+// letter kiss code.
+inline bool ntpIsKiss(const uint8_t *pkt, size_t len, const uint8_t *request, char *code) {
+    if (len < NTP_PACKET_SIZE || (pkt[0] & 0x07) != 4 || pkt[1] != 0) return false;
+    if (memcmp(&pkt[24], &request[40], 8) != 0) return false; // Not our request
+    memcpy(code, &pkt[12], 4);
+    code[4] = '\0';
+    return true;
+}
+
+#endif // NTP_PACKET_H
@@ -0,0 +1,56 @@
+#ifndef RUNTIME_JOURNAL_H
+#define RUNTIME_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "crc32.h"
+
+// Fixed size records for the append-only runtime journal. Replaying the
+// records in order rebuilds the state; a record with a bad CRC or a sequence
+// number that doesn't increase marks the end (a write torn by power loss).
+
+typedef enum {
+    JOURNAL_UPTIME      = 1,  // slot: log index, value: runtime in ms
+    JOURNAL_COUNTUPDOWN = 2,  // value: countupdown target (Unix seconds, 0 = off)
+    JOURNAL_WEAR        = 3,  // slot: counter (see flashWearEntries()), value: its total
+} JournalRecordType;
+
+// A record's content, before it is numbered and sealed.
+typedef struct {
+    uint8_t type;
+    uint8_t slot;
+    int64_t value;
+} JournalEntry;
+
+typedef struct {
+    uint32_t seq;
+    uint8_t  type;
+    uint8_t  slot;
+    uint16_t reserved;
+    uint32_t valueLo;
+    uint32_t valueHi;
+    uint32_t crc;       // CRC-32 of the fields above
+} JournalRecord;
+
+#define JOURNAL_RECORD_SIZE 20  // Also read by tools/flash_wear.py
+static_assert(sizeof(JournalRecord) == JOURNAL_RECORD_SIZE, "JournalRecord layout changed");
+
+inline void journalRecordInit(JournalRecord *rec, uint32_t seq, uint8_t type, uint8_t slot, int64_t value) {
+    rec->seq      = seq;
+    rec->type     = type;
+    rec->slot     = slot;
+    rec->reserved = 0;
+    rec->valueLo  = (uint32_t)((uint64_t)value);
+    rec->valueHi  = (uint32_t)((uint64_t)value >> 32);
+    rec->crc      = crc32Compute(rec, offsetof(JournalRecord, crc));
+}
+
+inline bool journalRecordValid(const JournalRecord *rec) {
+    return rec->crc == crc32Compute(rec, offsetof(JournalRecord, crc));
+}
+
+inline int64_t journalRecordValue(const JournalRecord *rec) {
+    return (int64_t)(((uint64_t)rec->valueHi << 32) | rec->valueLo);
+}
+
+#endif // RUNTIME_JOURNAL_H
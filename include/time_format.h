@@ -0,0 +1,160 @@
+#ifndef TIME_FORMAT_H
+#define TIME_FORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define SECONDS_PER_DAY   86400
+#define SECONDS_PER_YEAR  31557600 // 365.25 days
+#define FIFTEEN_DAYS      1296000
+
+// Two ASCII digits for every value 0-99, so a padded pair is a single copy.
+static const char DIGIT_PAIRS[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Broken-down view of a second count. Consecutive values are stepped with
+// carries instead of being re-divided, so the 64-bit divisions only happen
+// when the value jumps (first use, adjustments, clock corrections).
+typedef struct {
+    bool     valid;
+    int64_t  total;    // Seconds the fields below describe
+    uint8_t  sec;      // 0-59
+    uint8_t  min;      // 0-59
+    uint8_t  hour;     // 0-23, hour of day
+    uint32_t days;     // Whole days
+    uint32_t yearSec;  // Seconds into the current 365.25 day year
+    uint32_t years;    // Whole 365.25 day years
+} TimeCounters;
+
+inline void timeCountersSet(TimeCounters *tc, int64_t total) {
+    uint64_t t = total < 0 ? 0 : (uint64_t)total;
+    tc->valid   = true;
+    tc->total   = total;
+    tc->sec     = t % 60;
+    tc->min     = (t / 60) % 60;
+    tc->hour    = (t / 3600) % 24;
+    tc->days    = t / SECONDS_PER_DAY;
+    tc->yearSec = t % SECONDS_PER_YEAR;
+    tc->years   = t / SECONDS_PER_YEAR;
+}
+
+inline void timeCountersIncrement(TimeCounters *tc) {
+    tc->total++;
+    if (++tc->yearSec == SECONDS_PER_YEAR) {
+        tc->yearSec = 0;
+        tc->years++;
+    }
+    if (++tc->sec < 60) return;
+    tc->sec = 0;
+    if (++tc->min < 60) return;
+    tc->min = 0;
+    if (++tc->hour < 24) return;
+    tc->hour = 0;
+    tc->days++;
+}
+
+inline void timeCountersDecrement(TimeCounters *tc) {
+    tc->total--;
+    if (tc->yearSec-- == 0) {
+        tc->yearSec = SECONDS_PER_YEAR - 1;
+        tc->years--;
+    }
+    if (tc->sec-- > 0) return;
+    tc->sec = 59;
+    if (tc->min-- > 0) return;
+    tc->min = 59;
+    if (tc->hour-- > 0) return;
+    tc->hour = 23;
+    tc->days--;
+}
+
+inline void timeCountersUpdate(TimeCounters *tc, int64_t total) {
+    if (tc->valid && total == tc->total) {
+        return;
+    } else if (tc->valid && total > 0 && total == tc->total + 1) {
+        timeCountersIncrement(tc);
+    } else if (tc->valid && tc->total > 0 && total == tc->total - 1) {
+        timeCountersDecrement(tc);
+    } else {
+        timeCountersSet(tc, total);
+    }
+}
+
+// --- Digit writers, each returns the position after the last char written ---
+inline char *putDigits2(char *p, uint8_t v) {
+    memcpy(p, &DIGIT_PAIRS[v * 2], 2);
+    return p + 2;
+}
+
+inline char *putDigits(char *p, uint32_t v) {
+    char tmp[10];
+    char *t = tmp + sizeof(tmp);
+    while (v >= 100) {
+        t -= 2;
+        memcpy(t, &DIGIT_PAIRS[(v % 100) * 2], 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        t -= 2;
+        memcpy(t, &DIGIT_PAIRS[v * 2], 2);
+    } else {
+        *--t = '0' + v;
+    }
+    size_t n = tmp + sizeof(tmp) - t;
+    memcpy(p, t, n);
+    return p + n;
+}
+
+// Count up/down display. out must hold at least 24 chars.
+//   < 15 days:  H:MM:SS    (hours unbounded, up to 359)
+//   < 1 year:   D+HH:MM
+//   otherwise:  Y+D
+// With the colon hidden ':' becomes ' ' and '+' becomes '^'.
+inline size_t formatCountUpDown(TimeCounters *tc, int64_t seconds, bool colon, char *out) {
+    timeCountersUpdate(tc, seconds);
+    char *p = out;
+    if (seconds < FIFTEEN_DAYS) {
+        p = putDigits(p, tc->days * 24 + tc->hour);
+        *p++ = colon ? ':' : ' ';
+        p = putDigits2(p, tc->min);
+        *p++ = colon ? ':' : ' ';
+        p = putDigits2(p, tc->sec);
+    } else if (seconds < SECONDS_PER_YEAR) {
+        p = putDigits(p, tc->days);
+        *p++ = colon ? '+' : '^';
+        p = putDigits2(p, tc->hour);
+        *p++ = colon ? ':' : ' ';
+        p = putDigits2(p, tc->min);
+    } else {
+        p = putDigits(p, tc->years);
+        *p++ = colon ? '+' : '^';
+        p = putDigits(p, tc->yearSec / SECONDS_PER_DAY);
+    }
+    *p = '\0';
+    return p - out;
+}
+
+// Time of day display from local seconds (only the time of day is used).
+// out must hold at least 9 chars.
+inline size_t formatClock(TimeCounters *tc, int64_t localSeconds, bool twelveHour, char *out) {
+    timeCountersUpdate(tc, localSeconds);
+    char *p = out;
+    if (twelveHour) {
+        uint8_t hour = tc->hour % 12;
+        p = putDigits(p, hour == 0 ? 12 : hour);
+    } else {
+        p = putDigits2(p, tc->hour);
+    }
+    *p++ = ':';
+    p = putDigits2(p, tc->min);
+    *p++ = ':';
+    p = putDigits2(p, tc->sec);
+    *p = '\0';
+    return p - out;
+}
+
+#endif // TIME_FORMAT_H
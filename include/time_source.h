@@ -0,0 +1,133 @@
+#ifndef TIME_SOURCE_H
+#define TIME_SOURCE_H
+
+#include <stdint.h>
+
+// Single UTC timeline built on a free-running monotonic microsecond counter.
+// References (NTP, RTC, a manual set) feed corrections into it; small ones
+// are slewed in by running the timeline slightly fast or slow, so readings
+// never go backwards. Only large errors, or the first reference, step it.
+
+#define TIME_SLEW_PPM          50000    // Slew at up to 5% (50 ms per second)
+#define TIME_STEP_THRESHOLD_US 2000000  // Step instead of slewing beyond 2 s
+
+typedef enum {
+    TIME_SOURCE_NONE,    // Never set, counting from 1970
+    TIME_SOURCE_BUILD,   // Firmware build time (RTC lost power)
+    TIME_SOURCE_RTC,     // DS3231
+    TIME_SOURCE_MANUAL,  // Set from a browser via /set_time
+    TIME_SOURCE_NTP
+} TimeSourceKind;
+
+// Stratum follows NTP usage: 1 + the stratum of the reference. Sources with
+// no NTP stratum get fixed values reflecting how far they are trusted.
+#define TIME_STRATUM_RTC      4
+#define TIME_STRATUM_MANUAL   5
+#define TIME_STRATUM_BUILD    15
+#define TIME_STRATUM_NONE     16
+
+typedef struct {
+    int64_t        baseMonoUs;       // Monotonic time of the last anchor
+    int64_t        baseUtcUs;        // Timeline value at the anchor
+    int64_t        slewUs;           // Correction being slewed in from the anchor
+    int32_t        ratePpb;          // Rate correction for the monotonic timer's crystal error
+    int64_t        lastUtcUs;        // Last value handed out, for monotonicity
+    int64_t        lastSyncMonoUs;   // When a reference last corrected the timeline
+    int32_t        lastOffsetUs;     // Error measured by the last correction
+    uint32_t       steps;            // Corrections applied as steps
+    uint32_t       slews;            // Corrections applied as slews
+    TimeSourceKind source;
+    uint8_t        stratum;
+} TimeSource;
+
+inline void timeSourceInit(TimeSource *ts) {
+    ts->baseMonoUs     = 0;
+    ts->baseUtcUs      = 0;
+    ts->slewUs         = 0;
+    ts->ratePpb        = 0;
+    ts->lastUtcUs      = 0;
+    ts->lastSyncMonoUs = 0;
+    ts->lastOffsetUs   = 0;
+    ts->steps          = 0;
+    ts->slews          = 0;
+    ts->source         = TIME_SOURCE_NONE;
+    ts->stratum        = TIME_STRATUM_NONE;
+}
+
+// Part of the pending slew applied after elapsed microseconds.
+inline int64_t timeSourceSlewed(const TimeSource *ts, int64_t elapsed) {
+    int64_t applied = elapsed * TIME_SLEW_PPM / 1000000;
+    if (ts->slewUs >= 0) {
+        return applied > ts->slewUs ? ts->slewUs : applied;
+    }
+    return applied > -ts->slewUs ? ts->slewUs : -applied;
+}
+
+// Part of the last correction not yet slewed in at monoUs, 0 once the
+// timeline has caught up with its reference.
+inline int64_t timeSourceSlewRemaining(const TimeSource *ts, int64_t monoUs) {
+    return ts->slewUs - timeSourceSlewed(ts, monoUs - ts->baseMonoUs);
+}
+
+// Timeline value at monoUs, without the monotonic clamp.
+inline int64_t timeSourceAt(const TimeSource *ts, int64_t monoUs) {
+    int64_t elapsed = monoUs - ts->baseMonoUs;
+    return ts->baseUtcUs + elapsed + elapsed * ts->ratePpb / 1000000000 + timeSourceSlewed(ts, elapsed);
+}
+
+// Current UTC in microseconds. Never less than a previous reading unless a
+// reference stepped the timeline in between.
+inline int64_t timeSourceNow(TimeSource *ts, int64_t monoUs) {
+    int64_t t = timeSourceAt(ts, monoUs);
+    if (t < ts->lastUtcUs) {
+        t = ts->lastUtcUs;
+    }
+    ts->lastUtcUs = t;
+    return t;
+}
+
+// Feed a reference reading: at monoUs the true UTC was utcUs. Re-anchors the
+// timeline and either steps to the reference or slews the difference in.
+// Returns the measured offset (reference - timeline).
+inline int64_t timeSourceSync(TimeSource *ts, int64_t monoUs, int64_t utcUs, TimeSourceKind source, uint8_t stratum) {
+    int64_t current = timeSourceAt(ts, monoUs);
+    int64_t offset = utcUs - current;
+    ts->baseMonoUs = monoUs;
+    if (ts->source == TIME_SOURCE_NONE || offset > TIME_STEP_THRESHOLD_US || offset < -TIME_STEP_THRESHOLD_US) {
+        ts->baseUtcUs = utcUs;
+        ts->slewUs = 0;
+        ts->lastUtcUs = utcUs;
+        ts->steps++;
+    } else {
+        ts->baseUtcUs = current;
+        ts->slewUs = offset;
+        ts->slews++;
+    }
+    ts->lastSyncMonoUs = monoUs;
+    ts->lastOffsetUs = offset > INT32_MAX ? INT32_MAX : offset < INT32_MIN ? INT32_MIN : (int32_t)offset;
+    ts->source = source;
+    ts->stratum = stratum;
+    return offset;
+}
+
+// Change the rate correction from monoUs on, keeping the timeline continuous
+// and any slew in progress.
+inline void timeSourceSetRate(TimeSource *ts, int64_t monoUs, int32_t ratePpb) {
+    int64_t elapsed = monoUs - ts->baseMonoUs;
+    ts->baseUtcUs = timeSourceAt(ts, monoUs);
+    ts->slewUs -= timeSourceSlewed(ts, elapsed);
+    ts->baseMonoUs = monoUs;
+    ts->ratePpb = ratePpb;
+}
+
+inline const char *timeSourceName(TimeSourceKind source) {
+    switch (source) {
+        case TIME_SOURCE_BUILD:  return "build";
+        case TIME_SOURCE_RTC:    return "rtc";
+        case TIME_SOURCE_MANUAL: return "manual";
+        case TIME_SOURCE_NTP:    return "ntp";
+        default:                 return "none";
+    }
+}
+
+#endif // TIME_SOURCE_H
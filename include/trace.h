@@ -0,0 +1,126 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+// Hot path tracing on the CPU cycle counter. TRACE_SCOPE("name") records an
+// enter and an exit event into a fixed ring buffer; traceDump() writes the
+// buffer as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Off unless built with -D TRACE=true; otherwise the probes expand to
+// nothing. Names must be string literals, only the pointer is stored.
+
+#ifndef TRACE
+#define TRACE false
+#endif
+
+#if TRACE==true
+
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS 256  // Ring size, a power of two (16 bytes each)
+#endif
+#define TRACE_TASKS 8     // Tasks told apart in a dump, later ones share tid 0
+
+typedef struct {
+    uint32_t    cycles;
+    const char *name;
+    void       *task;   // Recording task, nullptr on the ESP8266
+    char        phase;  // 'B'egin or 'E'nd
+    uint8_t     core;   // Whose cycle counter cycles is
+} TraceEvent;
+
+static TraceEvent        traceEvents[TRACE_EVENTS];
+static volatile uint32_t traceHead    = 0;     // Total events claimed, the slot is head % TRACE_EVENTS
+static volatile bool     traceEnabled = true;  // Cleared while dumping
+
+inline void traceEvent(const char *name, char phase) {
+    if (!traceEnabled) {
+        return;
+    }
+    uint32_t cycles = ESP.getCycleCount();
+#if ESPVERS == 32
+    // The loop and the web server tasks can record at the same time.
+    uint32_t slot = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+    void *task = xTaskGetCurrentTaskHandle();
+    uint8_t core = xPortGetCoreID();
+#else
+    // Single core; web server callbacks never preempt the loop.
+    uint32_t slot = traceHead++;
+    void *task = nullptr;
+    uint8_t core = 0;
+#endif
+    TraceEvent *e = &traceEvents[slot % TRACE_EVENTS];
+    e->cycles = cycles;
+    e->name   = name;
+    e->task   = task;
+    e->phase  = phase;
+    e->core   = core;
+}
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : name(name) { traceEvent(name, 'B'); }
+    ~TraceScope() { traceEvent(name, 'E'); }
+private:
+    const char *name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name)   TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+// Writes the ring, oldest event first, and clears it. Each task is a thread
+// (tid) of its own, named after it; an unpinned task can record on either
+// core. Each core's cycle counter is separate and wraps every few seconds,
+// so timestamps are unwrapped per core assuming consecutive events on a
+// core are less than one wrap apart. Tasks are named from their handles at
+// dump time, the traced ones (loop, web server) live as long as the device.
+inline void traceDump(Print &out) {
+    traceEnabled = false;
+    uint32_t head = traceHead;
+    uint32_t count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    uint32_t last[2] = {0, 0};
+    uint64_t elapsed[2] = {0, 0};
+    bool seen[2] = {false, false};
+    void *tasks[TRACE_TASKS];
+    uint8_t taskCount = 0;
+    out.print(F("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    for (uint32_t i = 0; i < count; i++) {
+        const TraceEvent *e = &traceEvents[(head - count + i) % TRACE_EVENTS];
+        uint8_t core = e->core & 1;
+        if (seen[core]) {
+            elapsed[core] += (uint32_t)(e->cycles - last[core]);
+        }
+        seen[core] = true;
+        last[core] = e->cycles;
+        uint8_t tid = 0;
+        while (tid < taskCount && tasks[tid] != e->task) {
+            tid++;
+        }
+        if (tid == taskCount && taskCount < TRACE_TASKS) {
+            tasks[taskCount++] = e->task;
+        }
+        out.printf("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+                   i == 0 ? "" : ",", e->name, e->phase, (double)elapsed[core] / mhz, tid < TRACE_TASKS ? tid + 1 : 0);
+    }
+    for (uint8_t tid = 0; tid < taskCount; tid++) {
+#if ESPVERS == 32
+        const char *name = pcTaskGetName((TaskHandle_t)tasks[tid]);
+#else
+        const char *name = "loop";
+#endif
+        out.printf(",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", tid + 1, name);
+    }
+    out.print(F("]}\n"));
+    traceHead = 0;
+    traceEnabled = true;
+}
+
+#else
+
+#define TRACE_SCOPE(name) do {} while (0)
+
+#endif // TRACE==true
+
+#endif // TRACE_H
@@ -1,104 +1,820 @@
 #ifndef TZ_LOOKUP_H
 #define TZ_LOOKUP_H
 
+// Generated by tools/gen_tz_table.py from tzdata 2025b, do not edit.
+// Every IANA zone and alias mapped to the POSIX TZ string for its current
+// rules. Entries are sorted by name (strcmp order) for a binary search; names
+// and rules live in PROGMEM string pools referenced by offset.
+
+#include "host_compat.h"
+
+#define TZ_DATA_VERSION "2025b"
+#define TZ_ZONE_COUNT   598
+#define TZ_POSIX_MAX    44
+
 typedef struct {
-    const char* iana;
-    const char* posix;
-} TimeZoneMapping;
+    uint16_t name;   // Offset into tz_names
+    uint16_t posix;  // Offset into tz_posix
+} TimeZoneEntry;
 
-const TimeZoneMapping tz_mappings[] = {
-    {"Africa/Cairo", "EET-2EEST,M4.5.5/0,M10.5.5/0"},
-    {"Africa/Casablanca", "WET0WEST,M3.5.0/0,M10.5.0/0"},
-    {"Africa/Johannesburg", "SAST-2"},
-    {"America/Anchorage", "AKST9AKDT,M3.2.0,M11.1.0"},
-    {"America/Argentina/Buenos_Aires", "ART3"},
-    {"America/Chicago", "CST6CDT,M3.2.0,M11.1.0"},
-    {"America/Denver", "MST7MDT,M3.2.0,M11.1.0"},
-    {"America/Guatemala", "CST6"},
-    {"America/Halifax", "AST4ADT,M3.2.0,M11.1.0"},
-    {"America/Los_Angeles", "PST8PDT,M3.2.0,M11.1.0"},
-    {"America/Mexico_City", "CST6CDT,M4.1.0,M10.5.0"},
-    {"America/New_York", "EST5EDT,M3.2.0,M11.1.0"},
-    {"America/Phoenix", "MST7"},
-    {"America/Santiago", "CLT4CLST,M9.1.6/24,M4.1.6/24"},
-    {"America/Sao_Paulo", "BRT3"},
-    {"America/St_Johns", "NST3:30NDT,M3.2.0,M11.1.0"},
-    {"America/Toronto", "EST5EDT,M3.2.0,M11.1.0"},
-    {"America/Vancouver", "PST8PDT,M3.2.0,M11.1.0"},
-    {"Asia/Almaty", "ALMT-6"},
-    {"Asia/Amman", "EET-2EEST,M3.5.4/24,M10.5.5/1"},
-    {"Asia/Baghdad", "AST-3"},
-    {"Asia/Bangkok", "ICT-7"},
-    {"Asia/Beirut", "EET-2EEST,M3.5.0/0,M10.5.0/0"},
-    {"Asia/Dhaka", "BDT-6"},
-    {"Asia/Dubai", "GST-4"},
-    {"Asia/Ho_Chi_Minh", "ICT-7"},
-    {"Asia/Hong_Kong", "HKT-8"},
-    {"Asia/Jakarta", "WIB-7"},
-    {"Asia/Jerusalem", "IST-2IDT,M3.4.4/26,M10.5.0"},
-    {"Asia/Karachi", "PKT-5"},
-    {"Asia/Kathmandu", "NPT-5:45"},
-    {"Asia/Kolkata", "IST-5:30"},
-    {"Asia/Kuala_Lumpur", "MYT-8"},
-    {"Asia/Manila", "PST-8"},
-    {"Asia/Seoul", "KST-9"},
-    {"Asia/Shanghai", "CST-8"},
-    {"Asia/Singapore", "SGT-8"},
-    {"Asia/Taipei", "CST-8"},
-    {"Asia/Tashkent", "UZT-5"},
-    {"Asia/Tokyo", "JST-9"},
-    {"Asia/Ulaanbaatar", "ULAT-8"},
-    {"Asia/Yekaterinburg", "YEKT-5"},
-    {"Atlantic/Azores", "AZOT1AZOST,M3.5.0/0,M10.5.0/0"},
-    {"Atlantic/Reykjavik", "GMT0"},
-    {"Australia/Adelaide", "ACST-9:30ACDT,M10.1.0,M4.1.0"},
-    {"Australia/Brisbane", "AEST-10"},
-    {"Australia/Darwin", "ACST-9:30"},
-    {"Australia/Hobart", "AEST-10AEDT,M10.1.0,M4.1.0"},
-    {"Australia/Melbourne", "AEST-10AEDT,M10.1.0,M4.1.0"},
-    {"Australia/Perth", "AWST-8"},
-    {"Australia/Sydney", "AEST-10AEDT,M10.1.0,M4.1.0"},
-    {"Europe/Amsterdam", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Athens", "EET-2EEST,M3.5.0/3,M10.5.0/4"},
-    {"Europe/Belgrade", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Berlin", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Brussels", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Bucharest", "EET-2EEST,M3.5.0/3,M10.5.0/4"},
-    {"Europe/Copenhagen", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Dublin", "GMT0IST,M3.5.0/1,M10.5.0"},
-    {"Europe/Helsinki", "EET-2EEST,M3.5.0/3,M10.5.0/4"},
-    {"Europe/Istanbul", "TRT-3"},
-    {"Europe/Kiev", "EET-2EEST,M3.5.0/3,M10.5.0/4"},
-    {"Europe/Lisbon", "WET0WEST,M3.5.0/0,M10.5.0/0"},
-    {"Europe/London", "GMT0BST,M3.5.0/1,M10.5.0"},
-    {"Europe/Madrid", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Moscow", "MSK-3"},
-    {"Europe/Oslo", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Paris", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Prague", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Rome", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Stockholm", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Europe/Warsaw", "CET-1CEST,M3.5.0,M10.5.0/3"},
-    {"Pacific/Auckland", "NZST-12NZDT,M9.5.0,M4.1.0"},
-    {"Pacific/Chatham", "CHAST-12:45CHADT,M9.5.0,M4.1.0/3"},
-    {"Pacific/Fiji", "FJT-12"},
-    {"Pacific/Guam", "ChST-10"},
-    {"Pacific/Honolulu", "HST10"},
-    {"Pacific/Port_Moresby", "PGT-10"},
-    {"Pacific/Tahiti", "TAHT10"},
-    {"UTC", "UTC0"},
-    {"Etc/GMT+1", "GMT-1"},
-    {"Etc/GMT-1", "GMT+1"}
-};
+static const char tz_posix[] PROGMEM =
+    "<+00>0<+02>-2,M3.5.0/1,M10.5.0/3\0"
+    "<+01>-1\0"
+    "<+02>-2\0"
+    "<+0330>-3:30\0"
+    "<+03>-3\0"
+    "<+0430>-4:30\0"
+    "<+04>-4\0"
+    "<+0530>-5:30\0"
+    "<+0545>-5:45\0"
+    "<+05>-5\0"
+    "<+0630>-6:30\0"
+    "<+06>-6\0"
+    "<+07>-7\0"
+    "<+0845>-8:45\0"
+    "<+08>-8\0"
+    "<+09>-9\0"
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0\0"
+    "<+10>-10\0"
+    "<+11>-11\0"
+    "<+11>-11<+12>,M10.1.0,M4.1.0/3\0"
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45\0"
+    "<+12>-12\0"
+    "<+13>-13\0"
+    "<+14>-14\0"
+    "<-00>0\0"
+    "<-01>1\0"
+    "<-01>1<+00>,M3.5.0/0,M10.5.0/1\0"
+    "<-02>2\0"
+    "<-02>2<-01>,M3.5.0/-1,M10.5.0/0\0"
+    "<-03>3\0"
+    "<-03>3<-02>,M3.2.0,M11.1.0\0"
+    "<-04>4\0"
+    "<-04>4<-03>,M9.1.6/24,M4.1.6/24\0"
+    "<-05>5\0"
+    "<-06>6\0"
+    "<-06>6<-05>,M9.1.6/22,M4.1.6/22\0"
+    "<-07>7\0"
+    "<-08>8\0"
+    "<-0930>9:30\0"
+    "<-09>9\0"
+    "<-10>10\0"
+    "<-11>11\0"
+    "<-12>12\0"
+    "ACST-9:30\0"
+    "ACST-9:30ACDT,M10.1.0,M4.1.0/3\0"
+    "AEST-10\0"
+    "AEST-10AEDT,M10.1.0,M4.1.0/3\0"
+    "AKST9AKDT,M3.2.0,M11.1.0\0"
+    "AST4\0"
+    "AST4ADT,M3.2.0,M11.1.0\0"
+    "AWST-8\0"
+    "CAT-2\0"
+    "CET-1\0"
+    "CET-1CEST,M3.5.0,M10.5.0/3\0"
+    "CST-8\0"
+    "CST5CDT,M3.2.0/0,M11.1.0/1\0"
+    "CST6\0"
+    "CST6CDT,M3.2.0,M11.1.0\0"
+    "ChST-10\0"
+    "EAT-3\0"
+    "EET-2\0"
+    "EET-2EEST,M3.4.4/50,M10.4.4/50\0"
+    "EET-2EEST,M3.5.0,M10.5.0/3\0"
+    "EET-2EEST,M3.5.0/0,M10.5.0/0\0"
+    "EET-2EEST,M3.5.0/3,M10.5.0/4\0"
+    "EET-2EEST,M4.5.5/0,M10.5.4/24\0"
+    "EST5\0"
+    "EST5EDT,M3.2.0,M11.1.0\0"
+    "GMT0\0"
+    "GMT0BST,M3.5.0/1,M10.5.0\0"
+    "HKT-8\0"
+    "HST10\0"
+    "HST10HDT,M3.2.0,M11.1.0\0"
+    "IST-1GMT0,M10.5.0,M3.5.0/1\0"
+    "IST-2IDT,M3.4.4/26,M10.5.0\0"
+    "IST-5:30\0"
+    "JST-9\0"
+    "KST-9\0"
+    "MET-1MEST,M3.5.0,M10.5.0/3\0"
+    "MSK-3\0"
+    "MST7\0"
+    "MST7MDT,M3.2.0,M11.1.0\0"
+    "NST3:30NDT,M3.2.0,M11.1.0\0"
+    "NZST-12NZDT,M9.5.0,M4.1.0/3\0"
+    "PKT-5\0"
+    "PST-8\0"
+    "PST8PDT,M3.2.0,M11.1.0\0"
+    "SAST-2\0"
+    "SST11\0"
+    "UTC0\0"
+    "WAT-1\0"
+    "WET0WEST,M3.5.0/1,M10.5.0\0"
+    "WIB-7\0"
+    "WIT-9\0"
+    "WITA-8\0";
+
+static const char tz_names[] PROGMEM =
+    "Africa/Abidjan\0"
+    "Africa/Accra\0"
+    "Africa/Addis_Ababa\0"
+    "Africa/Algiers\0"
+    "Africa/Asmara\0"
+    "Africa/Asmera\0"
+    "Africa/Bamako\0"
+    "Africa/Bangui\0"
+    "Africa/Banjul\0"
+    "Africa/Bissau\0"
+    "Africa/Blantyre\0"
+    "Africa/Brazzaville\0"
+    "Africa/Bujumbura\0"
+    "Africa/Cairo\0"
+    "Africa/Casablanca\0"
+    "Africa/Ceuta\0"
+    "Africa/Conakry\0"
+    "Africa/Dakar\0"
+    "Africa/Dar_es_Salaam\0"
+    "Africa/Djibouti\0"
+    "Africa/Douala\0"
+    "Africa/El_Aaiun\0"
+    "Africa/Freetown\0"
+    "Africa/Gaborone\0"
+    "Africa/Harare\0"
+    "Africa/Johannesburg\0"
+    "Africa/Juba\0"
+    "Africa/Kampala\0"
+    "Africa/Khartoum\0"
+    "Africa/Kigali\0"
+    "Africa/Kinshasa\0"
+    "Africa/Lagos\0"
+    "Africa/Libreville\0"
+    "Africa/Lome\0"
+    "Africa/Luanda\0"
+    "Africa/Lubumbashi\0"
+    "Africa/Lusaka\0"
+    "Africa/Malabo\0"
+    "Africa/Maputo\0"
+    "Africa/Maseru\0"
+    "Africa/Mbabane\0"
+    "Africa/Mogadishu\0"
+    "Africa/Monrovia\0"
+    "Africa/Nairobi\0"
+    "Africa/Ndjamena\0"
+    "Africa/Niamey\0"
+    "Africa/Nouakchott\0"
+    "Africa/Ouagadougou\0"
+    "Africa/Porto-Novo\0"
+    "Africa/Sao_Tome\0"
+    "Africa/Timbuktu\0"
+    "Africa/Tripoli\0"
+    "Africa/Tunis\0"
+    "Africa/Windhoek\0"
+    "America/Adak\0"
+    "America/Anchorage\0"
+    "America/Anguilla\0"
+    "America/Antigua\0"
+    "America/Araguaina\0"
+    "America/Argentina/Buenos_Aires\0"
+    "America/Argentina/Catamarca\0"
+    "America/Argentina/ComodRivadavia\0"
+    "America/Argentina/Cordoba\0"
+    "America/Argentina/Jujuy\0"
+    "America/Argentina/La_Rioja\0"
+    "America/Argentina/Mendoza\0"
+    "America/Argentina/Rio_Gallegos\0"
+    "America/Argentina/Salta\0"
+    "America/Argentina/San_Juan\0"
+    "America/Argentina/San_Luis\0"
+    "America/Argentina/Tucuman\0"
+    "America/Argentina/Ushuaia\0"
+    "America/Aruba\0"
+    "America/Asuncion\0"
+    "America/Atikokan\0"
+    "America/Atka\0"
+    "America/Bahia\0"
+    "America/Bahia_Banderas\0"
+    "America/Barbados\0"
+    "America/Belem\0"
+    "America/Belize\0"
+    "America/Blanc-Sablon\0"
+    "America/Boa_Vista\0"
+    "America/Bogota\0"
+    "America/Boise\0"
+    "America/Buenos_Aires\0"
+    "America/Cambridge_Bay\0"
+    "America/Campo_Grande\0"
+    "America/Cancun\0"
+    "America/Caracas\0"
+    "America/Catamarca\0"
+    "America/Cayenne\0"
+    "America/Cayman\0"
+    "America/Chicago\0"
+    "America/Chihuahua\0"
+    "America/Ciudad_Juarez\0"
+    "America/Coral_Harbour\0"
+    "America/Cordoba\0"
+    "America/Costa_Rica\0"
+    "America/Coyhaique\0"
+    "America/Creston\0"
+    "America/Cuiaba\0"
+    "America/Curacao\0"
+    "America/Danmarkshavn\0"
+    "America/Dawson\0"
+    "America/Dawson_Creek\0"
+    "America/Denver\0"
+    "America/Detroit\0"
+    "America/Dominica\0"
+    "America/Edmonton\0"
+    "America/Eirunepe\0"
+    "America/El_Salvador\0"
+    "America/Ensenada\0"
+    "America/Fort_Nelson\0"
+    "America/Fort_Wayne\0"
+    "America/Fortaleza\0"
+    "America/Glace_Bay\0"
+    "America/Godthab\0"
+    "America/Goose_Bay\0"
+    "America/Grand_Turk\0"
+    "America/Grenada\0"
+    "America/Guadeloupe\0"
+    "America/Guatemala\0"
+    "America/Guayaquil\0"
+    "America/Guyana\0"
+    "America/Halifax\0"
+    "America/Havana\0"
+    "America/Hermosillo\0"
+    "America/Indiana/Indianapolis\0"
+    "America/Indiana/Knox\0"
+    "America/Indiana/Marengo\0"
+    "America/Indiana/Petersburg\0"
+    "America/Indiana/Tell_City\0"
+    "America/Indiana/Vevay\0"
+    "America/Indiana/Vincennes\0"
+    "America/Indiana/Winamac\0"
+    "America/Indianapolis\0"
+    "America/Inuvik\0"
+    "America/Iqaluit\0"
+    "America/Jamaica\0"
+    "America/Jujuy\0"
+    "America/Juneau\0"
+    "America/Kentucky/Louisville\0"
+    "America/Kentucky/Monticello\0"
+    "America/Knox_IN\0"
+    "America/Kralendijk\0"
+    "America/La_Paz\0"
+    "America/Lima\0"
+    "America/Los_Angeles\0"
+    "America/Louisville\0"
+    "America/Lower_Princes\0"
+    "America/Maceio\0"
+    "America/Managua\0"
+    "America/Manaus\0"
+    "America/Marigot\0"
+    "America/Martinique\0"
+    "America/Matamoros\0"
+    "America/Mazatlan\0"
+    "America/Mendoza\0"
+    "America/Menominee\0"
+    "America/Merida\0"
+    "America/Metlakatla\0"
+    "America/Mexico_City\0"
+    "America/Miquelon\0"
+    "America/Moncton\0"
+    "America/Monterrey\0"
+    "America/Montevideo\0"
+    "America/Montreal\0"
+    "America/Montserrat\0"
+    "America/Nassau\0"
+    "America/New_York\0"
+    "America/Nipigon\0"
+    "America/Nome\0"
+    "America/Noronha\0"
+    "America/North_Dakota/Beulah\0"
+    "America/North_Dakota/Center\0"
+    "America/North_Dakota/New_Salem\0"
+    "America/Nuuk\0"
+    "America/Ojinaga\0"
+    "America/Panama\0"
+    "America/Pangnirtung\0"
+    "America/Paramaribo\0"
+    "America/Phoenix\0"
+    "America/Port-au-Prince\0"
+    "America/Port_of_Spain\0"
+    "America/Porto_Acre\0"
+    "America/Porto_Velho\0"
+    "America/Puerto_Rico\0"
+    "America/Punta_Arenas\0"
+    "America/Rainy_River\0"
+    "America/Rankin_Inlet\0"
+    "America/Recife\0"
+    "America/Regina\0"
+    "America/Resolute\0"
+    "America/Rio_Branco\0"
+    "America/Rosario\0"
+    "America/Santa_Isabel\0"
+    "America/Santarem\0"
+    "America/Santiago\0"
+    "America/Santo_Domingo\0"
+    "America/Sao_Paulo\0"
+    "America/Scoresbysund\0"
+    "America/Shiprock\0"
+    "America/Sitka\0"
+    "America/St_Barthelemy\0"
+    "America/St_Johns\0"
+    "America/St_Kitts\0"
+    "America/St_Lucia\0"
+    "America/St_Thomas\0"
+    "America/St_Vincent\0"
+    "America/Swift_Current\0"
+    "America/Tegucigalpa\0"
+    "America/Thule\0"
+    "America/Thunder_Bay\0"
+    "America/Tijuana\0"
+    "America/Toronto\0"
+    "America/Tortola\0"
+    "America/Vancouver\0"
+    "America/Virgin\0"
+    "America/Whitehorse\0"
+    "America/Winnipeg\0"
+    "America/Yakutat\0"
+    "America/Yellowknife\0"
+    "Antarctica/Casey\0"
+    "Antarctica/Davis\0"
+    "Antarctica/DumontDUrville\0"
+    "Antarctica/Macquarie\0"
+    "Antarctica/Mawson\0"
+    "Antarctica/McMurdo\0"
+    "Antarctica/Palmer\0"
+    "Antarctica/Rothera\0"
+    "Antarctica/South_Pole\0"
+    "Antarctica/Syowa\0"
+    "Antarctica/Troll\0"
+    "Antarctica/Vostok\0"
+    "Arctic/Longyearbyen\0"
+    "Asia/Aden\0"
+    "Asia/Almaty\0"
+    "Asia/Amman\0"
+    "Asia/Anadyr\0"
+    "Asia/Aqtau\0"
+    "Asia/Aqtobe\0"
+    "Asia/Ashgabat\0"
+    "Asia/Ashkhabad\0"
+    "Asia/Atyrau\0"
+    "Asia/Baghdad\0"
+    "Asia/Bahrain\0"
+    "Asia/Baku\0"
+    "Asia/Bangkok\0"
+    "Asia/Barnaul\0"
+    "Asia/Beirut\0"
+    "Asia/Bishkek\0"
+    "Asia/Brunei\0"
+    "Asia/Calcutta\0"
+    "Asia/Chita\0"
+    "Asia/Choibalsan\0"
+    "Asia/Chongqing\0"
+    "Asia/Chungking\0"
+    "Asia/Colombo\0"
+    "Asia/Dacca\0"
+    "Asia/Damascus\0"
+    "Asia/Dhaka\0"
+    "Asia/Dili\0"
+    "Asia/Dubai\0"
+    "Asia/Dushanbe\0"
+    "Asia/Famagusta\0"
+    "Asia/Gaza\0"
+    "Asia/Harbin\0"
+    "Asia/Hebron\0"
+    "Asia/Ho_Chi_Minh\0"
+    "Asia/Hong_Kong\0"
+    "Asia/Hovd\0"
+    "Asia/Irkutsk\0"
+    "Asia/Istanbul\0"
+    "Asia/Jakarta\0"
+    "Asia/Jayapura\0"
+    "Asia/Jerusalem\0"
+    "Asia/Kabul\0"
+    "Asia/Kamchatka\0"
+    "Asia/Karachi\0"
+    "Asia/Kashgar\0"
+    "Asia/Kathmandu\0"
+    "Asia/Katmandu\0"
+    "Asia/Khandyga\0"
+    "Asia/Kolkata\0"
+    "Asia/Krasnoyarsk\0"
+    "Asia/Kuala_Lumpur\0"
+    "Asia/Kuching\0"
+    "Asia/Kuwait\0"
+    "Asia/Macao\0"
+    "Asia/Macau\0"
+    "Asia/Magadan\0"
+    "Asia/Makassar\0"
+    "Asia/Manila\0"
+    "Asia/Muscat\0"
+    "Asia/Nicosia\0"
+    "Asia/Novokuznetsk\0"
+    "Asia/Novosibirsk\0"
+    "Asia/Omsk\0"
+    "Asia/Oral\0"
+    "Asia/Phnom_Penh\0"
+    "Asia/Pontianak\0"
+    "Asia/Pyongyang\0"
+    "Asia/Qatar\0"
+    "Asia/Qostanay\0"
+    "Asia/Qyzylorda\0"
+    "Asia/Rangoon\0"
+    "Asia/Riyadh\0"
+    "Asia/Saigon\0"
+    "Asia/Sakhalin\0"
+    "Asia/Samarkand\0"
+    "Asia/Seoul\0"
+    "Asia/Shanghai\0"
+    "Asia/Singapore\0"
+    "Asia/Srednekolymsk\0"
+    "Asia/Taipei\0"
+    "Asia/Tashkent\0"
+    "Asia/Tbilisi\0"
+    "Asia/Tehran\0"
+    "Asia/Tel_Aviv\0"
+    "Asia/Thimbu\0"
+    "Asia/Thimphu\0"
+    "Asia/Tokyo\0"
+    "Asia/Tomsk\0"
+    "Asia/Ujung_Pandang\0"
+    "Asia/Ulaanbaatar\0"
+    "Asia/Ulan_Bator\0"
+    "Asia/Urumqi\0"
+    "Asia/Ust-Nera\0"
+    "Asia/Vientiane\0"
+    "Asia/Vladivostok\0"
+    "Asia/Yakutsk\0"
+    "Asia/Yangon\0"
+    "Asia/Yekaterinburg\0"
+    "Asia/Yerevan\0"
+    "Atlantic/Azores\0"
+    "Atlantic/Bermuda\0"
+    "Atlantic/Canary\0"
+    "Atlantic/Cape_Verde\0"
+    "Atlantic/Faeroe\0"
+    "Atlantic/Faroe\0"
+    "Atlantic/Jan_Mayen\0"
+    "Atlantic/Madeira\0"
+    "Atlantic/Reykjavik\0"
+    "Atlantic/South_Georgia\0"
+    "Atlantic/St_Helena\0"
+    "Atlantic/Stanley\0"
+    "Australia/ACT\0"
+    "Australia/Adelaide\0"
+    "Australia/Brisbane\0"
+    "Australia/Broken_Hill\0"
+    "Australia/Canberra\0"
+    "Australia/Currie\0"
+    "Australia/Darwin\0"
+    "Australia/Eucla\0"
+    "Australia/Hobart\0"
+    "Australia/LHI\0"
+    "Australia/Lindeman\0"
+    "Australia/Lord_Howe\0"
+    "Australia/Melbourne\0"
+    "Australia/NSW\0"
+    "Australia/North\0"
+    "Australia/Perth\0"
+    "Australia/Queensland\0"
+    "Australia/South\0"
+    "Australia/Sydney\0"
+    "Australia/Tasmania\0"
+    "Australia/Victoria\0"
+    "Australia/West\0"
+    "Australia/Yancowinna\0"
+    "Brazil/Acre\0"
+    "Brazil/DeNoronha\0"
+    "Brazil/East\0"
+    "Brazil/West\0"
+    "CET\0"
+    "CST6CDT\0"
+    "Canada/Atlantic\0"
+    "Canada/Central\0"
+    "Canada/Eastern\0"
+    "Canada/Mountain\0"
+    "Canada/Newfoundland\0"
+    "Canada/Pacific\0"
+    "Canada/Saskatchewan\0"
+    "Canada/Yukon\0"
+    "Chile/Continental\0"
+    "Chile/EasterIsland\0"
+    "Cuba\0"
+    "EET\0"
+    "EST\0"
+    "EST5EDT\0"
+    "Egypt\0"
+    "Eire\0"
+    "Etc/GMT\0"
+    "Etc/GMT+0\0"
+    "Etc/GMT+1\0"
+    "Etc/GMT+10\0"
+    "Etc/GMT+11\0"
+    "Etc/GMT+12\0"
+    "Etc/GMT+2\0"
+    "Etc/GMT+3\0"
+    "Etc/GMT+4\0"
+    "Etc/GMT+5\0"
+    "Etc/GMT+6\0"
+    "Etc/GMT+7\0"
+    "Etc/GMT+8\0"
+    "Etc/GMT+9\0"
+    "Etc/GMT-0\0"
+    "Etc/GMT-1\0"
+    "Etc/GMT-10\0"
+    "Etc/GMT-11\0"
+    "Etc/GMT-12\0"
+    "Etc/GMT-13\0"
+    "Etc/GMT-14\0"
+    "Etc/GMT-2\0"
+    "Etc/GMT-3\0"
+    "Etc/GMT-4\0"
+    "Etc/GMT-5\0"
+    "Etc/GMT-6\0"
+    "Etc/GMT-7\0"
+    "Etc/GMT-8\0"
+    "Etc/GMT-9\0"
+    "Etc/GMT0\0"
+    "Etc/Greenwich\0"
+    "Etc/UCT\0"
+    "Etc/UTC\0"
+    "Etc/Universal\0"
+    "Etc/Zulu\0"
+    "Europe/Amsterdam\0"
+    "Europe/Andorra\0"
+    "Europe/Astrakhan\0"
+    "Europe/Athens\0"
+    "Europe/Belfast\0"
+    "Europe/Belgrade\0"
+    "Europe/Berlin\0"
+    "Europe/Bratislava\0"
+    "Europe/Brussels\0"
+    "Europe/Bucharest\0"
+    "Europe/Budapest\0"
+    "Europe/Busingen\0"
+    "Europe/Chisinau\0"
+    "Europe/Copenhagen\0"
+    "Europe/Dublin\0"
+    "Europe/Gibraltar\0"
+    "Europe/Guernsey\0"
+    "Europe/Helsinki\0"
+    "Europe/Isle_of_Man\0"
+    "Europe/Istanbul\0"
+    "Europe/Jersey\0"
+    "Europe/Kaliningrad\0"
+    "Europe/Kiev\0"
+    "Europe/Kirov\0"
+    "Europe/Kyiv\0"
+    "Europe/Lisbon\0"
+    "Europe/Ljubljana\0"
+    "Europe/London\0"
+    "Europe/Luxembourg\0"
+    "Europe/Madrid\0"
+    "Europe/Malta\0"
+    "Europe/Mariehamn\0"
+    "Europe/Minsk\0"
+    "Europe/Monaco\0"
+    "Europe/Moscow\0"
+    "Europe/Nicosia\0"
+    "Europe/Oslo\0"
+    "Europe/Paris\0"
+    "Europe/Podgorica\0"
+    "Europe/Prague\0"
+    "Europe/Riga\0"
+    "Europe/Rome\0"
+    "Europe/Samara\0"
+    "Europe/San_Marino\0"
+    "Europe/Sarajevo\0"
+    "Europe/Saratov\0"
+    "Europe/Simferopol\0"
+    "Europe/Skopje\0"
+    "Europe/Sofia\0"
+    "Europe/Stockholm\0"
+    "Europe/Tallinn\0"
+    "Europe/Tirane\0"
+    "Europe/Tiraspol\0"
+    "Europe/Ulyanovsk\0"
+    "Europe/Uzhgorod\0"
+    "Europe/Vaduz\0"
+    "Europe/Vatican\0"
+    "Europe/Vienna\0"
+    "Europe/Vilnius\0"
+    "Europe/Volgograd\0"
+    "Europe/Warsaw\0"
+    "Europe/Zagreb\0"
+    "Europe/Zaporozhye\0"
+    "Europe/Zurich\0"
+    "Factory\0"
+    "GB\0"
+    "GB-Eire\0"
+    "GMT\0"
+    "GMT+0\0"
+    "GMT-0\0"
+    "GMT0\0"
+    "Greenwich\0"
+    "HST\0"
+    "Hongkong\0"
+    "Iceland\0"
+    "Indian/Antananarivo\0"
+    "Indian/Chagos\0"
+    "Indian/Christmas\0"
+    "Indian/Cocos\0"
+    "Indian/Comoro\0"
+    "Indian/Kerguelen\0"
+    "Indian/Mahe\0"
+    "Indian/Maldives\0"
+    "Indian/Mauritius\0"
+    "Indian/Mayotte\0"
+    "Indian/Reunion\0"
+    "Iran\0"
+    "Israel\0"
+    "Jamaica\0"
+    "Japan\0"
+    "Kwajalein\0"
+    "Libya\0"
+    "MET\0"
+    "MST\0"
+    "MST7MDT\0"
+    "Mexico/BajaNorte\0"
+    "Mexico/BajaSur\0"
+    "Mexico/General\0"
+    "NZ\0"
+    "NZ-CHAT\0"
+    "Navajo\0"
+    "PRC\0"
+    "PST8PDT\0"
+    "Pacific/Apia\0"
+    "Pacific/Auckland\0"
+    "Pacific/Bougainville\0"
+    "Pacific/Chatham\0"
+    "Pacific/Chuuk\0"
+    "Pacific/Easter\0"
+    "Pacific/Efate\0"
+    "Pacific/Enderbury\0"
+    "Pacific/Fakaofo\0"
+    "Pacific/Fiji\0"
+    "Pacific/Funafuti\0"
+    "Pacific/Galapagos\0"
+    "Pacific/Gambier\0"
+    "Pacific/Guadalcanal\0"
+    "Pacific/Guam\0"
+    "Pacific/Honolulu\0"
+    "Pacific/Johnston\0"
+    "Pacific/Kanton\0"
+    "Pacific/Kiritimati\0"
+    "Pacific/Kosrae\0"
+    "Pacific/Kwajalein\0"
+    "Pacific/Majuro\0"
+    "Pacific/Marquesas\0"
+    "Pacific/Midway\0"
+    "Pacific/Nauru\0"
+    "Pacific/Niue\0"
+    "Pacific/Norfolk\0"
+    "Pacific/Noumea\0"
+    "Pacific/Pago_Pago\0"
+    "Pacific/Palau\0"
+    "Pacific/Pitcairn\0"
+    "Pacific/Pohnpei\0"
+    "Pacific/Ponape\0"
+    "Pacific/Port_Moresby\0"
+    "Pacific/Rarotonga\0"
+    "Pacific/Saipan\0"
+    "Pacific/Samoa\0"
+    "Pacific/Tahiti\0"
+    "Pacific/Tarawa\0"
+    "Pacific/Tongatapu\0"
+    "Pacific/Truk\0"
+    "Pacific/Wake\0"
+    "Pacific/Wallis\0"
+    "Pacific/Yap\0"
+    "Poland\0"
+    "Portugal\0"
+    "ROC\0"
+    "ROK\0"
+    "Singapore\0"
+    "Turkey\0"
+    "UCT\0"
+    "US/Alaska\0"
+    "US/Aleutian\0"
+    "US/Arizona\0"
+    "US/Central\0"
+    "US/East-Indiana\0"
+    "US/Eastern\0"
+    "US/Hawaii\0"
+    "US/Indiana-Starke\0"
+    "US/Michigan\0"
+    "US/Mountain\0"
+    "US/Pacific\0"
+    "US/Samoa\0"
+    "UTC\0"
+    "Universal\0"
+    "W-SU\0"
+    "WET\0"
+    "Zulu\0";
 
-#define TZ_MAPPINGS_COUNT (sizeof(tz_mappings)/sizeof(tz_mappings[0]))
+static const TimeZoneEntry tz_entries[TZ_ZONE_COUNT] PROGMEM = {
+    {0,1033},{15,1033},{28,847},{47,745},{62,847},{76,847},{90,1033},{104,1342},
+    {118,1033},{132,1033},{146,739},{162,1342},{181,739},{198,975},{211,33},{229,751},
+    {242,1033},{257,1033},{270,847},{291,847},{307,1342},{321,33},{337,1033},{353,739},
+    {369,739},{383,1324},{403,739},{415,847},{430,739},{446,739},{460,1342},{476,1342},
+    {489,1342},{507,1033},{519,1342},{533,739},{551,739},{565,1342},{579,739},{593,1324},
+    {607,1324},{622,847},{639,1033},{655,847},{670,1342},{686,1342},{700,1033},{718,1033},
+    {737,1342},{755,1033},{771,1033},{787,853},{802,745},{815,739},{831,1075},{844,679},
+    {862,704},{879,704},{895,425},{913,425},{944,425},{972,425},{1005,425},{1031,425},
+    {1055,425},{1082,425},{1108,425},{1139,425},{1163,425},{1190,425},{1217,425},{1243,425},
+    {1269,704},{1283,425},{1300,1005},{1317,1075},{1330,425},{1344,811},{1367,704},{1384,425},
+    {1398,811},{1413,704},{1434,459},{1452,498},{1467,1212},{1481,425},{1502,1212},{1524,459},
+    {1545,1005},{1560,459},{1576,425},{1594,425},{1610,1005},{1625,816},{1641,811},{1659,1212},
+    {1681,1005},{1703,425},{1719,811},{1738,425},{1756,1207},{1772,459},{1787,704},{1803,1033},
+    {1824,1207},{1839,1207},{1860,1212},{1875,1010},{1891,704},{1908,1212},{1925,498},{1942,811},
+    {1962,1301},{1979,1207},{1999,1010},{2018,425},{2036,709},{2054,393},{2070,709},{2088,1010},
+    {2107,704},{2123,704},{2142,811},{2160,498},{2178,459},{2193,709},{2209,784},{2224,1207},
+    {2243,1010},{2272,816},{2293,1010},{2317,1010},{2344,816},{2370,1010},{2392,1010},{2418,1010},
+    {2442,1010},{2463,1212},{2478,1010},{2494,1005},{2510,425},{2524,679},{2539,1010},{2567,1010},
+    {2595,816},{2611,704},{2630,459},{2645,498},{2658,1301},{2678,1010},{2697,704},{2719,425},
+    {2734,811},{2750,459},{2765,704},{2781,704},{2800,816},{2818,1207},{2835,425},{2851,816},
+    {2869,811},{2884,679},{2903,811},{2923,432},{2940,709},{2956,811},{2974,425},{2993,1010},
+    {3010,704},{3029,1010},{3044,1010},{3061,1010},{3077,679},{3090,386},{3106,816},{3134,816},
+    {3162,816},{3193,393},{3206,816},{3222,1005},{3237,1010},{3257,425},{3276,1207},{3292,1010},
+    {3315,704},{3337,498},{3356,459},{3376,704},{3396,425},{3417,816},{3437,816},{3458,425},
+    {3473,811},{3488,816},{3505,498},{3524,425},{3540,1301},{3561,425},{3578,466},{3595,704},
+    {3617,425},{3635,393},{3656,1212},{3673,679},{3687,704},{3709,1235},{3726,704},{3743,704},
+    {3760,704},{3778,704},{3797,811},{3819,811},{3839,709},{3853,1010},{3873,1301},{3889,1010},
+    {3905,704},{3921,1301},{3939,704},{3954,1207},{3973,816},{3990,679},{4006,1212},{4026,167},
+    {4043,146},{4060,220},{4086,650},{4107,117},{4125,1261},{4144,425},{4162,425},{4181,1261},
+    {4203,62},{4220,0},{4237,117},{4255,751},{4275,62},{4285,117},{4297,62},{4308,314},
+    {4320,117},{4331,117},{4343,117},{4357,117},{4372,117},{4384,62},{4397,62},{4410,83},
+    {4420,146},{4433,146},{4446,917},{4458,138},{4471,167},{4483,1153},{4497,175},{4508,167},
+    {4524,778},{4539,778},{4554,91},{4567,138},{4578,62},{4592,138},{4603,175},{4613,83},
+    {4624,117},{4638,946},{4653,859},{4663,778},{4675,859},{4687,146},{4704,1063},{4719,146},
+    {4729,167},{4742,62},{4756,1374},{4769,1380},{4783,1126},{4798,70},{4809,314},{4824,1289},
+    {4837,138},{4850,104},{4865,104},{4879,175},{4893,1153},{4906,146},{4923,167},{4941,167},
+    {4954,62},{4966,778},{4977,778},{4988,229},{5001,1386},{5015,1295},{5027,83},{5039,946},
+    {5052,146},{5070,146},{5087,138},{5097,117},{5107,146},{5123,1374},{5138,1168},{5153,62},
+    {5164,117},{5178,117},{5193,125},{5206,62},{5218,146},{5230,229},{5244,117},{5259,1168},
+    {5270,778},{5284,167},{5299,229},{5318,778},{5330,117},{5344,83},{5357,49},{5369,1126},
+    {5383,138},{5395,138},{5408,1162},{5419,146},{5430,1386},{5449,167},{5466,167},{5482,138},
+    {5494,220},{5508,146},{5523,220},{5540,175},{5553,125},{5565,117},{5584,83},{5597,355},
+    {5613,709},{5630,1348},{5646,348},{5666,1348},{5682,1348},{5697,751},{5716,1348},{5733,1033},
+    {5752,386},{5775,1033},{5794,425},{5811,650},{5825,611},{5844,642},{5863,611},{5885,650},
+    {5904,650},{5921,601},{5938,154},{5954,650},{5971,183},{5985,642},{6004,183},{6024,650},
+    {6044,650},{6058,601},{6074,732},{6090,642},{6111,611},{6127,650},{6144,650},{6163,650},
+    {6182,732},{6197,611},{6218,498},{6230,386},{6247,425},{6259,459},{6271,751},{6275,816},
+    {6283,709},{6299,816},{6314,1010},{6329,1212},{6345,1235},{6365,1301},{6380,811},{6400,1207},
+    {6413,466},{6431,512},{6450,784},{6455,946},{6459,1005},{6463,1010},{6471,975},{6477,1099},
+    {6482,1033},{6490,1033},{6500,348},{6510,577},{6521,585},{6532,593},{6543,386},{6553,425},
+    {6563,459},{6573,498},{6583,505},{6593,544},{6603,551},{6613,570},{6623,1033},{6633,33},
+    {6643,220},{6654,229},{6665,314},{6676,323},{6687,332},{6698,41},{6708,62},{6718,83},
+    {6728,117},{6738,138},{6748,146},{6758,167},{6768,175},{6778,1033},{6787,1033},{6801,1337},
+    {6809,1337},{6817,1337},{6831,1337},{6840,751},{6857,751},{6872,83},{6889,946},{6903,1038},
+    {6918,751},{6934,751},{6948,751},{6966,751},{6982,946},{6999,751},{7015,751},{7031,890},
+    {7047,751},{7065,1099},{7079,751},{7096,1038},{7112,946},{7128,1038},{7147,62},{7163,1038},
+    {7177,853},{7196,946},{7208,1201},{7221,946},{7233,1348},{7247,751},{7264,1038},{7278,751},
+    {7296,751},{7310,751},{7323,946},{7340,62},{7353,751},{7367,1201},{7381,946},{7396,751},
+    {7408,751},{7421,751},{7438,751},{7452,946},{7464,751},{7476,83},{7490,751},{7508,751},
+    {7524,83},{7539,1201},{7557,751},{7571,946},{7584,751},{7601,946},{7616,751},{7630,890},
+    {7646,83},{7663,946},{7679,751},{7692,751},{7707,751},{7721,946},{7736,1201},{7753,751},
+    {7767,751},{7781,946},{7799,751},{7813,341},{7821,1038},{7824,1038},{7832,1033},{7836,1033},
+    {7842,1033},{7848,1033},{7853,1033},{7863,1069},{7867,1063},{7876,1033},{7884,847},{7904,138},
+    {7918,146},{7935,125},{7948,847},{7962,117},{7979,83},{7991,117},{8007,83},{8024,847},
+    {8039,83},{8054,49},{8059,1126},{8066,1005},{8074,1162},{8080,314},{8090,853},{8096,1174},
+    {8100,1207},{8104,1212},{8112,1301},{8129,1207},{8144,811},{8159,1261},{8162,269},{8170,1212},
+    {8177,778},{8181,1301},{8189,323},{8202,1261},{8219,229},{8240,269},{8256,220},{8270,512},
+    {8285,229},{8299,323},{8317,323},{8333,314},{8346,314},{8363,505},{8381,570},{8397,229},
+    {8417,839},{8430,1069},{8447,1069},{8464,323},{8479,332},{8498,229},{8513,314},{8531,314},
+    {8546,558},{8564,1331},{8579,314},{8593,585},{8606,238},{8622,229},{8637,1331},{8655,175},
+    {8669,551},{8686,229},{8702,229},{8717,220},{8738,577},{8756,839},{8771,1331},{8785,577},
+    {8800,314},{8815,323},{8833,220},{8846,314},{8859,314},{8874,220},{8886,751},{8893,1348},
+    {8902,778},{8906,1168},{8910,167},{8920,62},{8927,1337},{8931,679},{8941,1075},{8953,1207},
+    {8964,816},{8975,1010},{8991,1010},{9002,1069},{9012,816},{9030,1010},{9042,1212},{9054,1301},
+    {9065,1331},{9074,1337},{9078,1337},{9088,1201},{9093,1348},{9097,1337},
+};
 
+// POSIX TZ string for an IANA zone name, or UTC0 if the name is unknown.
+// The result is copied out of flash into a static buffer that is reused by
+// the next call.
 inline const char* ianaToPosix(const char* iana) {
-    for (size_t i = 0; i < TZ_MAPPINGS_COUNT; i++) {
-        if (strcmp(iana, tz_mappings[i].iana) == 0)
-            return tz_mappings[i].posix;
+    static char posix[TZ_POSIX_MAX + 1];
+    size_t lo = 0;
+    size_t hi = TZ_ZONE_COUNT;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        TimeZoneEntry entry;
+        memcpy_P(&entry, &tz_entries[mid], sizeof(entry));
+        int cmp = strcmp_P(iana, tz_names + entry.name);
+        if (cmp == 0) {
+            strcpy_P(posix, tz_posix + entry.posix);
+            return posix;
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
     }
     return "UTC0"; // fallback
 }
 
-#endif // TZ_LOOKUP_H
\ No newline at end of file
+#endif // TZ_LOOKUP_H
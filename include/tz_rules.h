@@ -0,0 +1,242 @@
+#ifndef TZ_RULES_H
+#define TZ_RULES_H
+
+#include <stdint.h>
+
+// POSIX TZ rule ("CET-1CEST,M3.5.0,M10.5.0/3") parsed once, with the UTC
+// offset in force cached together with the transitions around it. Between
+// transitions converting to local time is a compare and an add; the cache is
+// only rebuilt when a transition is crossed or the clock jumps.
+
+typedef enum {
+    TZ_DATE_JULIAN,   // Jn: day 1-365, February 29th never counted
+    TZ_DATE_ZERO,     // n: day 0-365, counting February 29th
+    TZ_DATE_MONTH     // Mm.w.d: day d (0 = Sunday) of week w (5 = last) of month m
+} TzDateKind;
+
+typedef struct {
+    TzDateKind kind;
+    uint16_t   day;
+    uint8_t    week;
+    uint8_t    month;
+    int32_t    time;      // Local seconds after midnight, may be negative or past 24h
+} TzDateRule;
+
+typedef struct {
+    int32_t    stdOffset;   // Seconds east of UTC (local - UTC), the opposite of POSIX
+    int32_t    dstOffset;
+    bool       hasDst;
+    TzDateRule start;       // Into DST, in standard local time
+    TzDateRule end;         // Out of DST, in daylight local time
+    // Cache
+    int32_t    offset;      // In force from validFrom until validUntil
+    int64_t    validFrom;
+    int64_t    validUntil;
+    uint32_t   rebuilds;
+} TzRules;
+
+inline bool tzIsLeap(int32_t y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (month 1-12).
+inline int64_t tzDaysFromCivil(int32_t y, uint8_t m, uint8_t d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// Year containing a day count since 1970-01-01.
+inline int32_t tzYearFromDays(int64_t days) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    uint32_t doe = (uint32_t)(days - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    return (int32_t)(yoe + era * 400) + (mp >= 10);
+}
+
+inline int64_t tzFloorDiv(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Local seconds since the epoch at which a date rule fires in year y.
+inline int64_t tzRuleLocal(const TzDateRule *r, int32_t y) {
+    int64_t days;
+    if (r->kind == TZ_DATE_JULIAN) {
+        days = tzDaysFromCivil(y, 1, 1) + r->day - 1 + (tzIsLeap(y) && r->day >= 60);
+    } else if (r->kind == TZ_DATE_ZERO) {
+        days = tzDaysFromCivil(y, 1, 1) + r->day;
+    } else {
+        static const uint8_t monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        int64_t first = tzDaysFromCivil(y, r->month, 1);
+        uint8_t firstWeekday = (uint8_t)((first % 7 + 11) % 7);  // 1970-01-01 was a Thursday
+        uint8_t day = (uint8_t)((r->day + 7 - firstWeekday) % 7) + (r->week - 1) * 7;
+        uint8_t length = monthDays[r->month - 1] + (r->month == 2 && tzIsLeap(y));
+        while (day >= length) {
+            day -= 7;
+        }
+        days = first + day;
+    }
+    return days * 86400 + r->time;
+}
+
+// --- Parsing, each returns the position after what it consumed or nullptr ---
+inline const char *tzParseName(const char *p) {
+    const char *start = p;
+    if (*p == '<') {
+        while (*p && *p != '>') p++;
+        return *p == '>' && p - start > 1 ? p + 1 : nullptr;
+    }
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) p++;
+    return p - start >= 3 ? p : nullptr;
+}
+
+// [+-]hh[:mm[:ss]] as seconds.
+inline const char *tzParseTime(const char *p, int32_t *seconds) {
+    int32_t sign = 1;
+    if (*p == '+' || *p == '-') {
+        sign = *p++ == '-' ? -1 : 1;
+    }
+    if (*p < '0' || *p > '9') return nullptr;
+    int32_t parts[3] = {0, 0, 0};
+    for (uint8_t i = 0; i < 3; i++) {
+        while (*p >= '0' && *p <= '9') {
+            parts[i] = parts[i] * 10 + (*p++ - '0');
+            if (parts[i] > 167) return nullptr;
+        }
+        if (i == 2 || *p != ':') break;
+        p++;
+    }
+    *seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return p;
+}
+
+inline const char *tzParseNumber(const char *p, uint16_t *value) {
+    if (*p < '0' || *p > '9') return nullptr;
+    uint16_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > 366) return nullptr;
+    }
+    *value = v;
+    return p;
+}
+
+inline const char *tzParseDate(const char *p, TzDateRule *r) {
+    uint16_t v;
+    if (*p == 'M') {
+        r->kind = TZ_DATE_MONTH;
+        if (!(p = tzParseNumber(p + 1, &v)) || v < 1 || v > 12 || *p != '.') return nullptr;
+        r->month = v;
+        if (!(p = tzParseNumber(p + 1, &v)) || v < 1 || v > 5 || *p != '.') return nullptr;
+        r->week = v;
+        if (!(p = tzParseNumber(p + 1, &v)) || v > 6) return nullptr;
+        r->day = v;
+    } else if (*p == 'J') {
+        r->kind = TZ_DATE_JULIAN;
+        if (!(p = tzParseNumber(p + 1, &v)) || v < 1 || v > 365) return nullptr;
+        r->day = v;
+    } else {
+        r->kind = TZ_DATE_ZERO;
+        if (!(p = tzParseNumber(p, &v)) || v > 365) return nullptr;
+        r->day = v;
+    }
+    r->time = 7200;
+    if (*p == '/') {
+        p = tzParseTime(p + 1, &r->time);
+    }
+    return p;
+}
+
+// Parse a POSIX TZ string and invalidate the cache. Returns false (leaving
+// UTC in place) if the string is malformed.
+inline bool tzParse(TzRules *tz, const char *rule) {
+    TzRules parsed = {};
+    const char *p = tzParseName(rule);
+    int32_t westOffset;
+    if (!p || !(p = tzParseTime(p, &westOffset))) return false;
+    parsed.stdOffset = -westOffset;
+    parsed.dstOffset = parsed.stdOffset;
+    if (*p) {
+        if (!(p = tzParseName(p))) return false;
+        parsed.hasDst = true;
+        parsed.dstOffset = parsed.stdOffset + 3600;
+        if (*p && *p != ',') {
+            if (!(p = tzParseTime(p, &westOffset))) return false;
+            parsed.dstOffset = -westOffset;
+        }
+        if (*p) {
+            if (*p != ',' || !(p = tzParseDate(p + 1, &parsed.start))) return false;
+            if (*p != ',' || !(p = tzParseDate(p + 1, &parsed.end))) return false;
+        } else if (!tzParseDate("M3.2.0", &parsed.start) || !tzParseDate("M11.1.0", &parsed.end)) {
+            return false;
+        }
+        if (*p) return false;
+    }
+    *tz = parsed;
+    tz->offset = tz->stdOffset;
+    tz->validFrom = INT64_MAX;  // Force a rebuild on first use
+    tz->validUntil = INT64_MIN;
+    return true;
+}
+
+// Find the offset in force at utc and the transitions bracketing it, from
+// the rules of the surrounding years.
+inline void tzRebuild(TzRules *tz, int64_t utc) {
+    tz->rebuilds++;
+    if (!tz->hasDst) {
+        tz->offset = tz->stdOffset;
+        tz->validFrom = INT64_MIN;
+        tz->validUntil = INT64_MAX;
+        return;
+    }
+    int32_t year = tzYearFromDays(tzFloorDiv(utc + tz->stdOffset, 86400));
+    // Transitions of years - 1 .. + 1 in order; at equal instants the end
+    // of DST sorts first so a start at the same moment wins.
+    int64_t at[6];
+    bool dst[6];
+    uint8_t n = 0;
+    for (int32_t y = year - 1; y <= year + 1; y++) {
+        int64_t start = tzRuleLocal(&tz->start, y) - tz->stdOffset;
+        int64_t end = tzRuleLocal(&tz->end, y) - tz->dstOffset;
+        for (uint8_t k = 0; k < 2; k++) {
+            int64_t t = k == 0 ? end : start;
+            uint8_t i = n++;
+            while (i > 0 && at[i - 1] > t) {
+                at[i] = at[i - 1];
+                dst[i] = dst[i - 1];
+                i--;
+            }
+            at[i] = t;
+            dst[i] = k == 1;
+        }
+    }
+    // Before the first transition the state is the opposite of what it sets.
+    tz->offset = dst[0] ? tz->stdOffset : tz->dstOffset;
+    tz->validFrom = INT64_MIN;
+    tz->validUntil = INT64_MAX;
+    for (uint8_t i = 0; i < n; i++) {
+        if (at[i] <= utc) {
+            tz->offset = dst[i] ? tz->dstOffset : tz->stdOffset;
+            tz->validFrom = at[i];
+        } else {
+            tz->validUntil = at[i];
+            break;
+        }
+    }
+}
+
+// Local seconds since the epoch for a UTC time.
+inline int64_t tzLocal(TzRules *tz, int64_t utc) {
+    if (utc < tz->validFrom || utc >= tz->validUntil) {
+        tzRebuild(tz, utc);
+    }
+    return utc + tz->offset;
+}
+
+#endif // TZ_RULES_H
@@ -3,14 +3,16 @@
 #include <WiFi.h>
 #include <ESPmDNS.h>
 #include <AsyncTCP.h>
-#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <lwip/tcpip.h>
 #endif
 #if ESPVERS == 8266
 #include <ESP8266WiFi.h>
 #include <ESP8266mDNS.h>
 #include <ESPAsyncTCP.h>
-#include <sntp.h>
 #endif
+#include <WiFiUdp.h>
+#include <lwip/dns.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #include <MD_Parola.h>
@@ -19,20 +21,42 @@
 #include <ESPAsyncWebServer.h>
 #include <DNSServer.h>
 #include <time.h>
+#include <sys/time.h>
 #include <ElegantOTA.h>
 #include "RTClib.h"
 #include "mfactoryfont.h"   // Custom font
 #include "tz_lookup.h"      // Timezone lookup
+#include "tz_rules.h"       // Cached UTC offset and DST transitions
+#include "clock_display.h"  // Tick text from time, target and zone
+#include "runtime_journal.h" // Uptime log and countupdown records
+#include "config_store.h"   // Binary settings record
+#include "flash_wear.h"     // Flash write and erase estimates
+#include "json_writer.h"    // Heap free JSON responses
+#include "form_parse.h"    // Checkbox and date/time form values
+#include "web_assets.h"     // Gzipped UI, generated by tools/embed_assets.py
+#include "metrics.h"        // Timing histograms for /metrics
+#include "trace.h"          // Cycle counter probes, built with -D TRACE=true
+#include "time_format.h"    // Display formatting
+#include "time_source.h"    // Unified time base
+#include "ntp_packet.h"     // SNTP packet handling
 #include "auth.h"           // Auth information
 
 #define HARDWARE_TYPE MD_MAX72XX::FC16_HW
 #define MAX_DEVICES   4
+#define CHAR_SPACING  1
+#define FRAME_COLUMNS (MAX_DEVICES * COL_SIZE)
 #define DEBUG         true
+#ifndef BINARY_CONFIG
+#define BINARY_CONFIG false // Settings in a binary record, config.json is only imported once
+#endif
 
 const char    *DEFAULT_AP_SSID      = "chronoclock";
 const char    *DEFAULT_AP_PASSWORD  = "chrono157";
 const char    *PASSWORD_MASK        = "********";
-const uint32_t COLON_BLINK_INTERVAL = 800;
+const uint32_t TICK_INTERVAL_US     = 500000; // Render on every half second edge (colon on/off)
+const uint32_t TICK_SPIN_US         = 2000;   // Busy-wait the last stretch before an edge
+const uint32_t TICK_MAX_SLEEP_MS    = 20;     // Cap idle sleeps so web/DNS/OTA work stays responsive
+const uint32_t TICK_NTP_SLEEP_MS    = 1;      // While an NTP reply is due, its receive time is taken when it is read
 
 /*
  * Function definitions
@@ -40,6 +64,46 @@ const uint32_t COLON_BLINK_INTERVAL = 800;
 // --- Config Load / Save / Safe Getters ---
 void loadConfig();
 String saveConfig();
+void configToJson(JsonDocument &doc);
+void loadConfigJson();
+String saveConfigJson();
+#if BINARY_CONFIG==true
+void packConfig(ConfigPacker *pk);
+bool unpackConfig(ConfigUnpacker *u);
+bool readConfigRecord(uint8_t which);
+bool writeConfigRecord();
+bool loadConfigBinary();
+String saveConfigBinary();
+bool restoreConfigBinary();
+#else
+bool restoreConfigJson();
+#endif
+bool restoreConfig();
+void markConfigDirty();
+void flushConfig();
+// --- Live State ---
+struct LiveState {
+  int    brightness;
+  bool   flipDisplay;
+  bool   twelveHour;
+  bool   lockCountUpDown;
+  time_t countupdownTimestamp;
+};
+// --- Runtime Journal ---
+void journalLoad();
+bool journalAppend(const JournalEntry *entries, uint8_t count);
+bool journalAppend(uint8_t type, uint8_t slot, int64_t value);
+bool journalCompact();
+uint8_t flashWearEntries(JournalEntry *entries);
+uint32_t flashWearUptime();
+size_t flashFsBytes();
+void markRuntimeDirty();
+void logRuntime(uint8_t slot, uint32_t ms);
+void buildConfigJson(bool apMode);
+void sendState(AsyncWebServerRequest *request);
+void sseConnect(AsyncEventSourceClient *client);
+void ssePush(time_t utc);
+void commitLiveState(const LiveState *state);
 const char *getSafeSsid(int ix);
 const char *getSafePassword(int ix);
 // -- Network ---
@@ -59,14 +123,58 @@ void WiFiScanFinished(WiFiEvent_t event, WiFiEventInfo_t info);
 WiFiEventHandler WiFiStationGotIP, WiFiStationDisconnected, WiFiScanFinished;
 #endif
 // --- Time ---
-void startNTPSync(bool resetTime, int retryCount);
+void startNTPSync(int retryCount);
+void ntpResolve(uint8_t ix);
+void ntpDnsFound(const char *, const ip_addr_t *ipaddr, void *arg);
+void ntpSendQuery();
+int ntpPoll(uint32_t curMillis);
 void setTimeZone(const char *local_TZ);
+int64_t monoMicros();
+int64_t timeNowUs();
+int64_t timeAt(int64_t monoUs);
+int64_t timeSlewRemaining(int64_t monoUs);
+void timeSetRate(int32_t ratePpb);
+TimeSource timeState();
+time_t timeNow();
+void syncTime(int64_t monoUs, int64_t utcUs, TimeSourceKind source, uint8_t stratum);
+void setSystemClock();
+bool waitForTick();
+DateTime readRTC();
+void syncTimeFromRTC(TimeSourceKind source);
+void disciplineFromRTC(uint32_t curMillis);
+#ifndef SQW_PIN
+void rtcPhaseNarrow(int64_t shownUs, int64_t beforeUs, int64_t afterUs);
+void rtcPhaseNext(int64_t nowUs);
+#endif
+void scheduleRTCWrite();
+void writeRTCAtEdge();
+// --- Drift ---
+int8_t readAgingOffset();
+void writeAgingOffset(int8_t value);
+void driftReset();
+void driftRecord(time_t utc, int64_t offsetUs);
+void driftApply();
+#ifdef SQW_PIN
+void IRAM_ATTR rtcSqwISR();
+#endif
+// --- Display ---
+void buildFontIndex();
+void composeFrame(const char *text);
+void pushFrame(bool force);
+void renderFrame(const char *frame);
+void invalidateFrame();
 // --- Utility ---
 void printConfigToSerial();
 // --- Web Server ---
 void setupWebServer();
+AsyncCallbackWebHandler &onRoute(const char *path, WebRequestMethodComposite method, ArRequestHandlerFunction handler,
+                                 ArBodyHandlerFunction body = nullptr);
+void sendMetrics(AsyncWebServerRequest *request);
+// --- Main ---
+void runLoop();
 
 MD_Parola P = MD_Parola(HARDWARE_TYPE, DATA_PIN, CLK_PIN, CS_PIN, MAX_DEVICES);
+MD_MAX72XX *mx = nullptr; // Parola's underlying driver, used for direct column writes
 RTC_DS3231 rtc;
 AsyncWebServer server(80);
 
@@ -84,6 +192,94 @@ ChronoWiFiState wifiState    = WIFI_DISCONNECTED;
 uint8_t         wifiNetNum   = 0;
 uint32_t        wifiLastTime = 0;
 
+// Handlers only change settings in RAM and mark the config dirty; the loop
+// writes it once configWriteDelay has passed since the first unsaved change,
+// so bursts of changes (slider drags, repeated +10s) become one flash write.
+const uint32_t configWriteDelay   = 2000;
+volatile bool  configDirty        = false;
+uint32_t       configDirtySince   = 0;
+uint32_t       configWrites       = 0;
+uint32_t       configCoalesced    = 0;     // Changes absorbed by a pending write
+uint32_t       configWriteErrors  = 0;
+volatile bool  restartRequested   = false; // Restart from the loop, after flushing the config
+volatile bool  restoreRequested   = false; // Restore the previous save from the loop and restart
+#if BINARY_CONFIG==true
+// Binary settings record (see config_store.h), the newest save and the one
+// before it. configRecord is the single buffer records are packed into,
+// written from and read back into.
+const char    *configPaths[2]      = {"/config.bin", "/config.prev"};
+ConfigRecord   configRecord;
+bool           configNewestValid   = false; // configPaths[0] holds a verified record
+#endif
+
+// GET /config.json is generated from RAM into configJson and only rebuilt
+// when settingsVersion moves. The version, with a per boot id, is its ETag,
+// so open UIs revalidating get a 304 until something changes.
+uint32_t       settingsVersion       = 1;  // Bumped by every change visible in /config.json
+uint32_t       settingsBootId        = 0;
+char           configJson[3072];
+size_t         configJsonLen         = 0;
+bool           configJsonOverflow    = false;
+uint32_t       configJsonVersion     = 0;  // settingsVersion configJson was built for, 0 for none
+bool           configJsonAp          = false;
+char           configJsonEtag[32]    = "";
+uint32_t       configJsonBuilds      = 0;
+uint32_t       configJsonNotModified = 0;
+
+// Control endpoints answer with the display state, serialized into one of
+// these buffers. The response sends from it after the handler returned, so
+// the buffer stays taken until its request is gone. With all of them taken
+// the response gets a copy on the heap instead.
+const uint8_t  stateBufferCount      = 4;
+char           stateBuffers[stateBufferCount][160];
+uint8_t        stateBuffersTaken     = 0;  // Bit per buffer, handlers and disconnects run on one task
+uint32_t       stateCopies           = 0;
+
+// Live state for open UIs over Server-Sent Events on /events. The loop sends
+// at most one event per second: the time plus the fields that changed since
+// the last event. Changes wait for the next event while clients still have
+// packets queued. A new client gets the full state on connect.
+AsyncEventSource events("/events");
+const size_t   sseMaxClients         = 4;
+const size_t   sseMaxQueued          = 2;      // Average packets waiting per client before holding back
+const uint32_t sseBusyRetry          = 30000;  // Reconnect delay sent to refused clients
+LiveState      sseSent               = {};     // As of the last event
+uint32_t       sseEventId            = 0;
+uint32_t       sseEvents             = 0;
+uint32_t       sseHeld               = 0;      // Seconds skipped for slow clients
+uint32_t       sseRejected           = 0;
+
+// Runtime state (uptime log, countupdown target) is appended to a journal of
+// small records instead of rewriting config.json. It is replayed at boot and
+// compacted down to the current state once it outgrows journalCompactSize.
+// The uptime log is updated in RAM every five minutes but journaled hourly,
+// with the next countupdown record and at restart: a power cut loses at most
+// an hour of it, and flash is spared an append (a copied block) every time.
+const char    *journalPath         = "/runtime.log";
+const char    *journalTempPath     = "/runtime.tmp";
+const size_t   journalCompactSize  = 16384;   // ~800 records, a week of hourly uptime and wear logging
+uint32_t       journalSeq          = 0;
+size_t         journalSize         = 0;
+uint32_t       journalAppends      = 0;
+uint32_t       journalCompactions  = 0;
+volatile bool  runtimeDirty        = false;   // countupdownTimestamp changed by a handler
+uint32_t       runtimeDirtySince   = 0;
+bool           uptimeUnjournaled   = false;   // logRuntimeMs[logIndex] newer than the journal
+const uint8_t  journalMaxEntries   = 8;       // Records per append
+
+// Flash wear, estimated from every LittleFS write (see flash_wear.h). The
+// totals are journaled hourly along with the uptime record and at restart,
+// so a power cut loses at most an hour of counts.
+FlashWear      flashWear           = {};
+uint32_t       flashWearBootS      = 0;       // Uptime covered by the counts before this boot
+const uint8_t  flashWearEntryCount = 5;
+enum FlashFile : uint8_t {                    // File indexes for flashWearWrite()
+  FLASH_FILE_CONFIG_JSON,
+  FLASH_FILE_CONFIG_RECORD,
+  FLASH_FILE_JOURNAL,
+  FLASH_FILE_JOURNAL_TEMP,
+};
+
 
 // Settings
 char mdns[64]          = "";
@@ -100,6 +296,7 @@ char ntpServer1[128]   = "pool.ntp.org";
 char ntpServer2[128]   = "time.nist.gov";
 int  logIndex          = 9;
 char logAct[10][24]    = {"","","","","","","","","",""};
+uint32_t logRuntimeMs[10] = {};
 uint32_t lastLogTime   = 0;
 uint32_t startMillis   = 0;
 uint32_t runtime       = 0;
@@ -107,9 +304,117 @@ uint32_t runtime       = 0;
 // Globals
 bool          rtcEnabled           = false;
 bool          colonVisible         = true;
-unsigned long lastColonBlink       = 0;
 time_t        countupdownTimestamp = 0;  // Unix timestamp
 
+// Display render state
+char     lastFrame[24]  = "";    // Last text pushed to the matrix
+bool     frameDirty     = true;  // Force the next frame out even if the text is unchanged
+uint32_t framesRendered = 0;
+uint32_t framesSkipped  = 0;
+
+// Column framebuffer, leftmost display column first. Each module owns
+// COL_SIZE consecutive columns so frames can be diffed module by module.
+uint8_t  frameColumns[FRAME_COLUMNS];
+uint8_t  sentColumns[FRAME_COLUMNS];
+uint16_t fontIndex[256];         // Offset of each glyph's width byte in mFactory
+uint32_t modulesWritten = 0;
+uint32_t modulesSkipped = 0;
+
+// Timings for /metrics, recorded on every pass (see metrics.h)
+MetricsHistogram metricsLoop       = {};  // loop() iterations, less loopWaitUs
+uint32_t         loopWaitUs        = 0;   // Slept or spun this iteration, waiting for an edge or RTC probe
+MetricsHistogram metricsWifi       = {};  // Loop stages
+MetricsHistogram metricsNtp        = {};
+MetricsHistogram metricsRtc        = {};
+MetricsHistogram metricsRender     = {};
+MetricsHistogram metricsOta        = {};
+MetricsHistogram metricsSave       = {};  // saveConfig()
+const uint8_t    metricsMaxRoutes  = 40;
+MetricsRoute     metricsRoutes[metricsMaxRoutes];
+uint8_t          metricsRouteCount = 0;
+
+// Every consumer reads UTC from here; NTP, the RTC and /set_time feed it.
+// Web handlers use it from the async_tcp task as well as loop(), so it is
+// only accessed through the time functions below, inside timeSourceMux.
+// ESPAsyncTCP on the ESP8266 runs them in the loop's own context.
+TimeSource timeSource;
+#if ESPVERS == 32
+portMUX_TYPE timeSourceMux = portMUX_INITIALIZER_UNLOCKED;
+#define TIME_SOURCE_LOCK()   portENTER_CRITICAL(&timeSourceMux)
+#define TIME_SOURCE_UNLOCK() portEXIT_CRITICAL(&timeSourceMux)
+#else
+#define TIME_SOURCE_LOCK()
+#define TIME_SOURCE_UNLOCK()
+#endif
+
+// newlib's clock (time(), gettimeofday(), library and file timestamps) is
+// set from the time source after every correction and once per
+// systemClockInterval, so slews and rate corrections don't leave it behind.
+const uint32_t systemClockInterval = 60000;
+uint32_t       systemClockLastSet  = 0;
+
+// Tick scheduler, aligned to the time source's half second edges
+int64_t  tickEdgeUs       = 0;   // Edge currently being rendered (UTC microseconds)
+int64_t  nextTickUs       = 0;   // Next edge to wait for
+uint32_t tickLatencyUs    = 0;   // Edge to display latency of the last tick
+uint32_t tickLatencyMaxUs = 0;
+uint32_t ticksMissed      = 0;   // Edges that passed while the loop was busy elsewhere
+uint32_t tickSteps        = 0;   // timeSource.steps as of the last tick
+
+// RTC discipline. The DS3231 is read at boot to set the time source. After
+// that it is only consulted once per rtcCheckInterval, plus its 1 Hz SQW
+// pulses when SQW_PIN is wired, or a few phase probes after each check
+// when it is not.
+const uint32_t rtcCheckInterval   = 60000; // Whole second comparison against the RTC
+const int32_t  rtcMaxPhaseErrorUs = 1000;  // RTC vs system clock second edge error tolerated before correcting
+uint32_t       rtcLastCheck       = 0;
+uint32_t       rtcReads           = 0;     // I2C time reads since boot
+uint32_t       i2cTransactions    = 0;     // Bus transactions of all RTC accesses
+int32_t        rtcPhaseErrorUs    = 0;     // Last measured time source error at an RTC second edge
+TimeSourceKind rtcSource          = TIME_SOURCE_RTC; // TIME_SOURCE_BUILD until the RTC is set properly
+bool           rtcWritePending    = false; // Copy the time source to the RTC at the next whole second
+uint32_t       rtcWrites          = 0;
+int32_t        rtcWriteLatencyUs  = 0;     // How late after the second edge the last write started
+#ifdef SQW_PIN
+volatile uint32_t rtcPulseMicros  = 0;
+volatile bool     rtcPulsePending = false;
+#else
+const uint8_t  rtcPhaseMaxProbes  = 16;
+int64_t        rtcProbeUs         = 0;     // Time source time of the next phase probe, 0 when not measuring
+int32_t        rtcPhaseLoUs       = 0;     // Bounds on RTC minus time source found by the probes so far
+int32_t        rtcPhaseHiUs       = 0;
+uint8_t        rtcProbes          = 0;
+int32_t        rtcProbeReadUs     = 0;     // How long the last RTC read took
+uint32_t       rtcProbeSyncs      = 0;     // timeSource steps + slews when the measurement started
+#endif
+
+// Drift estimation. Each NTP sync measures how far the clock wandered since
+// the previous one; the accumulated rate is trimmed out through the DS3231
+// aging offset register, or as a software rate correction without an RTC.
+#define DS3231_ADDRESS     0x68
+#define DS3231_REG_CONTROL 0x0E
+#define DS3231_REG_AGING   0x10
+#define DS3231_AGING_PPM   0.1f   // Approximate rate change per aging offset LSB at 25C
+const uint8_t  DRIFT_HISTORY   = 8;
+const uint32_t driftMinSpan    = 3600;   // Seconds of history required before correcting
+struct DriftPoint {
+  time_t  utc;        // NTP time of the sync
+  int32_t intervalS;  // Since the previous sync
+  int32_t offsetUs;   // Clock error found by the sync (NTP - clock)
+};
+DriftPoint driftHistory[DRIFT_HISTORY];
+uint8_t    driftCount       = 0;    // Points since the last correction
+uint8_t    driftNext        = 0;    // Ring position for the next point
+time_t     driftLastSync    = 0;    // Reference sync, 0 when the clock was set by other means
+float      driftPpm         = 0;    // Latest estimate, positive = clock runs fast
+uint32_t   driftCorrections = 0;
+int32_t    clockRatePpb     = 0;    // Software rate correction (no RTC), persisted
+int8_t     rtcAgingOffset   = 0;
+
+// Display formatter state
+DisplayCounters displayCounters = {};
+TzRules         localZone       = {};  // Parsed from the POSIX rule of timeZone
+
 // State management
 DNSServer dnsServer;
 const byte DNS_PORT = 53;
@@ -123,15 +428,111 @@ enum NtpState {
 };
 NtpState            ntpState               = NTP_IDLE;
 unsigned long       ntpLastTime            = 0;
-const int           ntpTimeout             = 10000;   // 10 seconds
+const int           ntpReplyTimeout        = 1000;    // Per query
+const int           ntpServerSpacing       = 4500;    // Between queries to the same server: NIST asks for 4 s, plus a margin for the crystal
+const uint8_t       ntpBurstSize           = 4;       // Queries per server per sync
+const uint32_t      ntpDnsTtl              = 86400000; // Resolve the servers again after a day
+const int           ntpDnsTimeout          = 5000;
+const uint16_t      ntpLocalPort           = 4123;
 const int           ntpRefreshTime         = 3600000; // Auto refresh NTP sync every hour with no RTC
+const int           ntpRtcRefreshTime      = 21600000; // Every 6 hours with an RTC, to measure its drift
 const int           maxNtpRetries          = 3;
 int                 ntpRetryCount          = 0;
 
+// SNTP client. Each sync sends a burst of queries to both servers and keeps
+// the sample with the lowest round trip delay, which has the least
+// asymmetric network delay hiding in its offset. The queries alternate
+// between the servers so neither sees them closer than ntpServerSpacing.
+// Server addresses are cached for ntpDnsTtl and resolved in the background.
+enum NtpDnsState {
+  NTP_DNS_NONE,
+  NTP_DNS_PENDING,
+  NTP_DNS_DONE,
+  NTP_DNS_FAILED
+};
+struct NtpServer {
+  volatile uint32_t    ip;                // Written by ntpDnsFound() from the lwIP task
+  volatile NtpDnsState dns;
+  uint32_t             hostCrc;           // Of the name ip belongs to
+  uint32_t             dnsMillis;         // When the lookup started
+  int64_t              sentMonoUs;        // Last query, 0 for none yet
+  uint8_t              queries;           // Sent in this sync, ntpBurstSize once done with it
+  uint8_t              samples;
+};
+WiFiUDP             ntpUdp;
+uint8_t             ntpRequest[NTP_PACKET_SIZE];
+NtpServer           ntpServers[2]          = {};      // For ntpServer1 and ntpServer2
+uint8_t             ntpServerIx            = 0;       // Server of the last query
+bool                ntpAwaiting            = false;
+uint32_t            ntpKisses              = 0;       // Kiss-o'-death replies
+uint32_t            ntpSendMillis          = 0;
+int64_t             ntpSendMonoUs          = 0;
+int64_t             ntpSendUtcUs           = 0;
+uint8_t             ntpSamples             = 0;
+bool                ntpHaveBest            = false;
+NtpSample           ntpBest;
+int64_t             ntpBestMonoUs          = 0;       // Receive time of the best sample
+int64_t             ntpBestUtcUs           = 0;
+uint8_t             ntpBestServerIx        = 0;
+
+// Result of the last successful sync, reported by /ntp_status
+struct NtpResult {
+  int64_t  offsetUs;
+  uint32_t delayUs;
+  uint8_t  stratum;
+  uint8_t  samples;
+  time_t   timestamp;
+  char     server[128];
+};
+NtpResult           ntpLastResult          = {0, 0, 0, 0, 0, ""};
+
 /*
  * Configuration Load & Save
  */
 void loadConfig() {
+#if BINARY_CONFIG==true
+  if (loadConfigBinary()) {
+    return;
+  }
+  // No valid slot yet: import config.json (or its defaults) once.
+  loadConfigJson();
+  saveConfigBinary();
+#else
+  loadConfigJson();
+#endif
+}
+
+String saveConfig() {
+  TRACE_SCOPE("saveConfig");
+#if BINARY_CONFIG==true
+  return saveConfigBinary();
+#else
+  return saveConfigJson();
+#endif
+}
+
+void configToJson(JsonDocument &doc) {
+  doc[F("mdns")] = mdns;
+  doc[F("apSsid")] = apSsid;
+  doc[F("apPassword")] = apPassword;
+  doc[F("timeZone")] = timeZone;
+  doc[F("brightness")] = brightness;
+  doc[F("flipDisplay")] = flipDisplay;
+  doc[F("twelveHour")] = twelveHour;
+  doc[F("lockCountUpDown")] = lockCountUpDown;
+  doc[F("ntpServer1")] = ntpServer1;
+  doc[F("ntpServer2")] = ntpServer2;
+  doc[F("clockRatePpb")] = clockRatePpb;
+
+  JsonArray ssidArray = doc[F("ssids")].to<JsonArray>();
+  JsonArray pwdArray = doc[F("passwords")].to<JsonArray>();
+  for (int i=0;i<10;i++) {
+    ssidArray[i] = ssids[i];
+    pwdArray[i] = passwords[i];
+  }
+}
+
+void loadConfigJson() {
 #if DEBUG==true
   Serial.println(F("[CONFIG] Loading configuration..."));
 #endif
@@ -142,31 +543,11 @@ void loadConfig() {
     Serial.println(F("[CONFIG] config.json not found, creating with defaults..."));
 #endif
     JsonDocument doc;
-    doc[F("mdns")] = mdns;
-    doc[F("apSsid")] = apSsid;
-    doc[F("apPassword")] = apPassword;
-    doc[F("timeZone")] = timeZone;
-    doc[F("brightness")] = brightness;
-    doc[F("flipDisplay")] = flipDisplay;
-    doc[F("twelveHour")] = twelveHour;
-    doc[F("lockCountUpDown")] = lockCountUpDown;
-    doc[F("ntpServer1")] = ntpServer1;
-    doc[F("ntpServer2")] = ntpServer2;
-    doc[F("countupdownTimestamp")] = 0;
-    doc[F("logIndex")] = logIndex;
-    JsonArray log = doc[F("log")].to<JsonArray>();
-
-    JsonArray ssidArray = doc[F("ssids")].to<JsonArray>();
-    JsonArray pwdArray = doc[F("passwords")].to<JsonArray>();
-    for (int i=0;i<10;i++) {
-      ssidArray[i] = ssids[i];
-      pwdArray[i] = passwords[i];
-      log[i] = logAct[i];
-    }
+    configToJson(doc);
 
     File f = LittleFS.open("/config.json", "w");
     if (f) {
-      serializeJsonPretty(doc, f);
+      flashWearWrite(&flashWear, FLASH_FILE_CONFIG_JSON, 0, serializeJsonPretty(doc, f));
       f.close();
 #if DEBUG==true
       Serial.println(F("[CONFIG] Default config.json created."));
@@ -204,11 +585,9 @@ void loadConfig() {
 
   JsonArray ssidArray = doc[F("ssids")];
   JsonArray pwdArray = doc[F("passwords")];
-  JsonArray tmplog = doc[F("log")].to<JsonArray>();
   for (int i=0; i<10; i++) {
     strlcpy(ssids[i], ssidArray[i] | "", sizeof(ssids[i]));
     strlcpy(passwords[i], pwdArray[i] | "", sizeof(passwords[i]));
-    strlcpy(logAct[i], tmplog[i] | "", sizeof(logAct[i]));
   }
   strlcpy(mdns, doc[F("mdns")] | "chronoclock", sizeof(mdns));
   strlcpy(apSsid, doc[F("apSsid")] | "", sizeof(apSsid));
@@ -220,50 +599,23 @@ void loadConfig() {
   lockCountUpDown = doc[F("lockCountUpDown")] | false;
   strlcpy(ntpServer1, doc[F("ntpServer1")] | "pool.ntp.org", sizeof(ntpServer1));
   strlcpy(ntpServer2, doc[F("ntpServer2")] | "time.nist.gov", sizeof(ntpServer2));
-  countupdownTimestamp = doc[F("countupdownTimestamp")] | 0;
-  logIndex = doc[F("logIndex")] | 0;
-  logIndex = (logIndex + 1) % 10;
+  clockRatePpb = doc[F("clockRatePpb")] | 0;
+  countupdownTimestamp = doc[F("countupdownTimestamp")] | 0; // Older firmware kept it here, the journal takes over
 #if DEBUG==true
   Serial.println(F("[CONFIG] Configuration loaded."));
 #endif
 }
 
-String saveConfig() {
+String saveConfigJson() {
     JsonDocument doc;
-    doc[F("mdns")] = mdns;
-    doc[F("apSsid")] = apSsid;
-    doc[F("apPassword")] = apPassword;
-    doc[F("timeZone")] = timeZone;
-    doc[F("brightness")] = brightness;
-    doc[F("flipDisplay")] = flipDisplay;
-    doc[F("twelveHour")] = twelveHour;
-    doc[F("lockCountUpDown")] = lockCountUpDown;
-    doc[F("ntpServer1")] = ntpServer1;
-    doc[F("ntpServer2")] = ntpServer2;
-    doc[F("countupdownTimestamp")] = countupdownTimestamp;
-    doc[F("logIndex")] = logIndex;
-
-    
-    snprintf(logAct[logIndex], sizeof(logAct[logIndex]), "%d:%02d:%02d", runtime / 3600000, runtime % 3600000 / 60000, runtime % 60000 / 1000);
-    Serial.print(F("New log data for index "));
-    Serial.print(logIndex);
-    Serial.print(F(": "));
-    Serial.println(logAct[logIndex]);
+    configToJson(doc);
 
-    JsonArray ssidArray = doc[F("ssids")].to<JsonArray>();
-    JsonArray pwdArray = doc[F("passwords")].to<JsonArray>();
-    JsonArray logArray = doc[F("log")].to<JsonArray>();
-    for (int i=0;i<10;i++) {
-      ssidArray[i] = ssids[i];
-      pwdArray[i] = passwords[i];
-      logArray[i] = logAct[i];
-    }
-    
     if (LittleFS.exists("/config.json")) {
 #if DEBUG==true
       Serial.println(F("[SAVE] Renaming /config.json to /config.bak"));
 #endif
       LittleFS.rename("/config.json", "/config.bak");
+      flashWearCommit(&flashWear);
     }
     File f = LittleFS.open("/config.json", "w");
     if (!f) {
@@ -278,12 +630,13 @@ String saveConfig() {
       return response;
     }
 
-#if DEBUG==true
     size_t bytesWritten = serializeJson(doc, f);
+#if DEBUG==true
     Serial.print(F("[SAVE] Bytes written to /config.json: "));
     Serial.println(bytesWritten);
 #endif
     f.close();
+    flashWearWrite(&flashWear, FLASH_FILE_CONFIG_JSON, 0, bytesWritten);
 #if DEBUG==true
     Serial.println(F("[SAVE] /config.json file closed."));
 #endif
@@ -326,6 +679,381 @@ String saveConfig() {
     return "";
 }
 
+#if BINARY_CONFIG==true
+// The settings in packing order, see config_store.h. unpackConfig() reads
+// them back in the same order.
+void packConfig(ConfigPacker *pk) {
+  int32_t brightness32 = brightness;
+  uint8_t flags[3] = {flipDisplay, twelveHour, lockCountUpDown};
+  configPackBytes(pk, &brightness32, sizeof(brightness32));
+  configPackBytes(pk, &clockRatePpb, sizeof(clockRatePpb));
+  configPackBytes(pk, flags, sizeof(flags));
+  configPackString(pk, mdns, sizeof(mdns));
+  configPackString(pk, apSsid, sizeof(apSsid));
+  configPackString(pk, apPassword, sizeof(apPassword));
+  configPackString(pk, timeZone, sizeof(timeZone));
+  configPackString(pk, ntpServer1, sizeof(ntpServer1));
+  configPackString(pk, ntpServer2, sizeof(ntpServer2));
+  for (int i=0;i<10;i++) {
+    configPackString(pk, ssids[i], sizeof(ssids[i]));
+    configPackString(pk, passwords[i], sizeof(passwords[i]));
+  }
+}
+// Every string packs into at most its field's size, the length byte takes the terminator's place.
+static_assert(4 + sizeof(clockRatePpb) + 3 + sizeof(mdns) + sizeof(apSsid) + sizeof(apPassword) + sizeof(timeZone) +
+              sizeof(ntpServer1) + sizeof(ntpServer2) + sizeof(ssids) + sizeof(passwords) <= CONFIG_PAYLOAD_MAX,
+              "Settings outgrew CONFIG_PAYLOAD_MAX");
+
+bool unpackConfig(ConfigUnpacker *u) {
+  int32_t brightness32;
+  uint8_t flags[3];
+  configUnpackBytes(u, &brightness32, sizeof(brightness32));
+  configUnpackBytes(u, &clockRatePpb, sizeof(clockRatePpb));
+  configUnpackBytes(u, flags, sizeof(flags));
+  configUnpackString(u, mdns, sizeof(mdns));
+  configUnpackString(u, apSsid, sizeof(apSsid));
+  configUnpackString(u, apPassword, sizeof(apPassword));
+  configUnpackString(u, timeZone, sizeof(timeZone));
+  configUnpackString(u, ntpServer1, sizeof(ntpServer1));
+  configUnpackString(u, ntpServer2, sizeof(ntpServer2));
+  for (int i=0;i<10;i++) {
+    configUnpackString(u, ssids[i], sizeof(ssids[i]));
+    configUnpackString(u, passwords[i], sizeof(passwords[i]));
+  }
+  brightness = brightness32;
+  flipDisplay = flags[0];
+  twelveHour = flags[1];
+  lockCountUpDown = flags[2];
+  return !u->torn;
+}
+
+// Read a record file (0 newest, 1 previous) into configRecord, true if it
+// holds a valid record.
+bool readConfigRecord(uint8_t which) {
+  File f = LittleFS.open(configPaths[which], "r");
+  if (!f) {
+    return false;
+  }
+  size_t length = f.read((uint8_t *)&configRecord, sizeof(configRecord));
+  f.close();
+  return configRecordValid(&configRecord, length);
+}
+
+// Write configRecord as the newest save and read it back to verify. The
+// newest before it becomes the previous save, unless it never verified: a
+// retry after a failed write must not push out the last good one.
+bool writeConfigRecord() {
+  if (configNewestValid) {
+    LittleFS.rename(configPaths[0], configPaths[1]);
+    flashWearCommit(&flashWear);
+    configNewestValid = false;
+  }
+  File f = LittleFS.open(configPaths[0], "w");
+  if (!f) {
+    return false;
+  }
+  size_t length = configRecordLength(&configRecord);
+  size_t written = f.write((const uint8_t *)&configRecord, length);
+  f.close();
+  flashWearWrite(&flashWear, FLASH_FILE_CONFIG_RECORD, 0, written);
+  if (written != length || !readConfigRecord(0)) {
+    return false;
+  }
+  configNewestValid = true;
+  return true;
+}
+
+// Only the newest save is read. The previous one is the fallback when it is
+// missing or torn, as after power lost during a save.
+bool loadConfigBinary() {
+  int8_t loaded = -1;
+  for (uint8_t which = 0; which < 2 && loaded < 0; which++) {
+    if (!readConfigRecord(which)) {
+      continue;
+    }
+    ConfigUnpacker u = configUnpacker(&configRecord);
+    if (unpackConfig(&u)) {
+      loaded = which;
+    }
+  }
+  if (loaded < 0) {
+#if DEBUG==true
+    Serial.println(F("[CONFIG] No valid binary config."));
+#endif
+    return false;
+  }
+  configNewestValid = loaded == 0;
+#if DEBUG==true
+  Serial.printf("[CONFIG] Configuration loaded from %s (%u bytes).\n", configPaths[loaded], (unsigned)configRecordLength(&configRecord));
+#endif
+  return true;
+}
+
+String saveConfigBinary() {
+  ConfigPacker pk = configPacker(&configRecord);
+  packConfig(&pk);
+  configRecordSeal(&configRecord, configPacked(&pk));
+  if (!writeConfigRecord()) {
+#if DEBUG==true
+    Serial.println(F("[SAVE] ERROR: Binary config write failed verification!"));
+#endif
+    return "{\"error\":\"Failed to write config.\"}";
+  }
+  return "";
+}
+
+// Make the previous save the newest again. Restoring twice undoes it.
+bool restoreConfigBinary() {
+  return readConfigRecord(1) && writeConfigRecord();
+}
+#else
+// Copy the backup saveConfigJson() made over config.json.
+bool restoreConfigJson() {
+  File src = LittleFS.open("/config.bak", "r");
+  if (!src) {
+#if DEBUG==true
+    Serial.println(F("[RESTORE] Failed to open /config.bak"));
+#endif
+    return false;
+  }
+  File dst = LittleFS.open("/config.json", "w");
+  if (!dst) {
+    src.close();
+#if DEBUG==true
+    Serial.println(F("[RESTORE] Failed to open /config.json for writing"));
+#endif
+    return false;
+  }
+  size_t copied = 0;
+  while (src.available()) {
+    copied += dst.write(src.read());
+  }
+  src.close();
+  dst.close();
+  flashWearWrite(&flashWear, FLASH_FILE_CONFIG_JSON, 0, copied);
+  return true;
+}
+#endif
+
+// Go back to the save before the last one, from the loop. Pending changes
+// are written first, so the save before them is the one restored, not the
+// one before that.
+bool restoreConfig() {
+  flushConfig();
+#if BINARY_CONFIG==true
+  return restoreConfigBinary();
+#else
+  return restoreConfigJson();
+#endif
+}
+
+void markConfigDirty() {
+  settingsVersion++;
+  if (configDirty) {
+    configCoalesced++;
+    return;
+  }
+  configDirtySince = millis();
+  configDirty = true;
+}
+
+// Write pending changes now. A failed write stays pending and is retried
+// after another configWriteDelay.
+void flushConfig() {
+  if (!configDirty) {
+    return;
+  }
+  configDirty = false;
+  uint32_t start = micros();
+  String msg = saveConfig();
+  metricsRecord(&metricsSave, micros() - start);
+  configWrites++;
+  if (msg.length() > 0) {
+#if DEBUG==true
+    Serial.print(F("[SAVE] Write failed, retrying: "));
+    Serial.println(msg);
+#endif
+    configWriteErrors++;
+    // Pending again without a settingsVersion bump, nothing changed.
+    configDirtySince = millis();
+    configDirty = true;
+  }
+}
+
+/*
+ * Runtime Journal
+ */
+void logRuntime(uint8_t slot, uint32_t ms) {
+  settingsVersion++;
+  logRuntimeMs[slot] = ms;
+  snprintf(logAct[slot], sizeof(logAct[slot]), "%lu:%02lu:%02lu", (unsigned long)(ms / 3600000), (unsigned long)(ms % 3600000 / 60000), (unsigned long)(ms % 60000 / 1000));
+}
+
+// Replay the journal into RAM. A torn or corrupt tail is compacted away so
+// new records don't land behind it.
+void journalLoad() {
+  if (!LittleFS.exists(journalPath) && LittleFS.exists(journalTempPath)) {
+    LittleFS.rename(journalTempPath, journalPath); // Power lost during compaction
+    flashWearCommit(&flashWear);
+  }
+  File f = LittleFS.open(journalPath, "r");
+  if (!f) {
+#if DEBUG==true
+    Serial.println(F("[JOURNAL] No runtime journal, starting a new one."));
+#endif
+    logIndex = 0;
+    journalCompact();
+    return;
+  }
+  JournalRecord rec;
+  int lastSlot = -1;
+  uint32_t records = 0;
+  bool clean = true;
+  while (f.available() > 0) {
+    if (f.read((uint8_t *)&rec, sizeof(rec)) != sizeof(rec) || !journalRecordValid(&rec) || (records > 0 && rec.seq <= journalSeq)) {
+      clean = false;
+      break;
+    }
+    journalSeq = rec.seq;
+    records++;
+    if (rec.type == JOURNAL_UPTIME && rec.slot < 10) {
+      logRuntime(rec.slot, (uint32_t)journalRecordValue(&rec));
+      lastSlot = rec.slot;
+    } else if (rec.type == JOURNAL_COUNTUPDOWN) {
+      countupdownTimestamp = (time_t)journalRecordValue(&rec);
+    } else if (rec.type == JOURNAL_WEAR) {
+      uint64_t value = (uint64_t)journalRecordValue(&rec);
+      switch (rec.slot) {
+        case 0: flashWear.logicalBytes = value; break;
+        case 1: flashWear.physicalBytes = value; break;
+        case 2: flashWear.erases = value >> 32; flashWear.sessions = (uint32_t)value; break;
+        case 3: flashWear.commits = value >> 32; flashWearBootS = (uint32_t)value; break;
+        case 4: flashWear.files = (uint32_t)value; break;
+      }
+    }
+  }
+  journalSize = f.size();
+  f.close();
+  logIndex = (lastSlot + 1) % 10;
+#if DEBUG==true
+  Serial.printf("[JOURNAL] Replayed %lu records, log index %d%s\n", (unsigned long)records, logIndex, clean ? "" : ", discarding corrupt tail");
+#endif
+  if (!clean) {
+    journalCompact();
+  }
+}
+
+// Entries are appended in one write: every append copies the journal's
+// partly written last block on flash, however few bytes it adds.
+bool journalAppend(const JournalEntry *entries, uint8_t count) {
+  TRACE_SCOPE("journalAppend");
+  if (journalSize + count * sizeof(JournalRecord) > journalCompactSize) {
+    return journalCompact(); // Writes the current state, which includes these changes
+  }
+  File f = LittleFS.open(journalPath, "a");
+  if (!f) {
+    return false;
+  }
+  JournalRecord recs[journalMaxEntries];
+  count = count < journalMaxEntries ? count : journalMaxEntries;
+  for (uint8_t i = 0; i < count; i++) {
+    journalRecordInit(&recs[i], journalSeq + 1 + i, entries[i].type, entries[i].slot, entries[i].value);
+  }
+  size_t written = f.write((const uint8_t *)recs, count * sizeof(JournalRecord));
+  f.close();
+  flashWearWrite(&flashWear, FLASH_FILE_JOURNAL, journalSize, written);
+  if (written != count * sizeof(JournalRecord)) {
+    journalCompact(); // Don't leave a partial record for the next append to follow
+    return false;
+  }
+  journalSeq += count;
+  journalSize += written;
+  journalAppends++;
+  return true;
+}
+
+bool journalAppend(uint8_t type, uint8_t slot, int64_t value) {
+  JournalEntry entry = {type, slot, value};
+  return journalAppend(&entry, 1);
+}
+
+// Rewrite the journal as one record per used log slot (oldest first, so the
+// current slot replays last) plus the countupdown target and wear counters.
+bool journalCompact() {
+  TRACE_SCOPE("journalCompact");
+  File f = LittleFS.open(journalTempPath, "w");
+  if (!f) {
+    return false;
+  }
+  JournalRecord rec;
+  size_t size = 0;
+  for (uint8_t i = 1; i <= 10; i++) {
+    uint8_t slot = (logIndex + i) % 10;
+    if (logRuntimeMs[slot] > 0) {
+      journalRecordInit(&rec, ++journalSeq, JOURNAL_UPTIME, slot, logRuntimeMs[slot]);
+      size += f.write((const uint8_t *)&rec, sizeof(rec));
+    }
+  }
+  journalRecordInit(&rec, ++journalSeq, JOURNAL_COUNTUPDOWN, 0, countupdownTimestamp);
+  size += f.write((const uint8_t *)&rec, sizeof(rec));
+  JournalEntry wear[flashWearEntryCount];
+  uint8_t wearCount = flashWearEntries(wear);
+  for (uint8_t i = 0; i < wearCount; i++) {
+    journalRecordInit(&rec, ++journalSeq, wear[i].type, wear[i].slot, wear[i].value);
+    size += f.write((const uint8_t *)&rec, sizeof(rec));
+  }
+  f.close();
+  flashWearWrite(&flashWear, FLASH_FILE_JOURNAL_TEMP, 0, size);
+  LittleFS.remove(journalPath);
+  flashWearCommit(&flashWear);
+  bool renamed = LittleFS.rename(journalTempPath, journalPath);
+  flashWearCommit(&flashWear);
+  if (!renamed) {
+    return false;
+  }
+  journalSize = size;
+  journalCompactions++;
+#if DEBUG==true
+  Serial.printf("[JOURNAL] Compacted to %u bytes\n", (unsigned)size);
+#endif
+  return true;
+}
+
+// The wear counters as JOURNAL_WEAR entries, returns how many.
+uint8_t flashWearEntries(JournalEntry *entries) {
+  entries[0] = {JOURNAL_WEAR, 0, (int64_t)flashWear.logicalBytes};
+  entries[1] = {JOURNAL_WEAR, 1, (int64_t)flashWear.physicalBytes};
+  entries[2] = {JOURNAL_WEAR, 2, (int64_t)((uint64_t)flashWear.erases << 32 | flashWear.sessions)};
+  entries[3] = {JOURNAL_WEAR, 3, (int64_t)((uint64_t)flashWear.commits << 32 | flashWearUptime())};
+  entries[4] = {JOURNAL_WEAR, 4, (int64_t)flashWear.files};
+  return flashWearEntryCount;
+}
+
+// Powered seconds the wear counters cover, across boots.
+uint32_t flashWearUptime() {
+  return flashWearBootS + runtime / 1000;
+}
+
+size_t flashFsBytes() {
+#if ESPVERS == 32
+  return LittleFS.totalBytes();
+#endif
+#if ESPVERS == 8266
+  FSInfo info;
+  return LittleFS.info(info) ? info.totalBytes : 0;
+#endif
+}
+
+// Handlers changing countupdownTimestamp record it from the loop, coalesced
+// like config writes.
+void markRuntimeDirty() {
+  settingsVersion++;
+  if (!runtimeDirty) {
+    runtimeDirtySince = millis();
+    runtimeDirty = true;
+  }
+}
+
 // --- Safe WiFi credential getters ---
 const char *getSafeSsid(int ix) {
   return ssids[ix];
@@ -493,34 +1221,676 @@ void WiFiScanFinished(WiFiEvent_t event, WiFiEventInfo_t info) {
 /*
  * Time Functions
  */
-void startNTPSync(bool resetTime, int retryCount = 0) {
+void startNTPSync(int retryCount = 0) {
   if (wifiState == WIFI_APMODE) {
     return;
   }
 #if DEBUG==true
   Serial.println(F("[TIME] Starting NTP sync"));
 #endif
-
-  setTimeZone(""); // ConfigTime is going to sync assuming the server is set to UTC0, so set it to UTC0.
-  if (resetTime) {
-#if DEBUG==true
-    Serial.println(F("[TIME] Resetting time."));
-#endif
-    struct timeval now = { 0, 0 };
-    settimeofday(&now, NULL);
+  ntpUdp.stop();
+  ntpUdp.begin(ntpLocalPort);
+  ntpAwaiting = false;
+  ntpSamples = 0;
+  ntpHaveBest = false;
+  for (uint8_t ix = 0; ix < 2; ix++) {
+    ntpServers[ix].queries = 0;
+    ntpServers[ix].samples = 0;
+    ntpResolve(ix);
   }
   ntpState = NTP_SYNCING;
   ntpLastTime = millis();
-  configTime(0, 0, ntpServer1, ntpServer2);
   ntpRetryCount = retryCount + 1;
 }
 
+// Start looking up a server unless its address is cached. lwIP answers
+// through ntpDnsFound(), loop() never waits for the lookup.
+void ntpResolve(uint8_t ix) {
+  NtpServer &server = ntpServers[ix];
+  const char *host = ix == 0 ? ntpServer1 : ntpServer2;
+  if (strlen(host) == 0) {
+    server.queries = ntpBurstSize; // Nothing to query
+    return;
+  }
+  uint32_t hostCrc = crc32Compute(host, strlen(host));
+  uint32_t now = millis();
+  if (server.hostCrc == hostCrc && ((server.dns == NTP_DNS_DONE && now - server.dnsMillis < ntpDnsTtl) ||
+                                    (server.dns == NTP_DNS_PENDING && now - server.dnsMillis < ntpDnsTimeout))) {
+    return;
+  }
+  server.hostCrc = hostCrc;
+  server.dnsMillis = now;
+  server.dns = NTP_DNS_PENDING;
+  ip_addr_t addr;
+#if ESPVERS == 32
+  LOCK_TCPIP_CORE(); // lwIP's raw API from outside its task
+#endif
+  err_t err = dns_gethostbyname(host, &addr, ntpDnsFound, &server);
+#if ESPVERS == 32
+  UNLOCK_TCPIP_CORE();
+#endif
+  if (err == ERR_OK) { // Cached by lwIP, or an address already
+    server.ip = ip_addr_get_ip4_u32(&addr);
+    server.dns = NTP_DNS_DONE;
+  } else if (err != ERR_INPROGRESS) {
+    server.dns = NTP_DNS_FAILED;
+  }
+}
+
+void ntpDnsFound(const char *, const ip_addr_t *ipaddr, void *arg) {
+  NtpServer *server = (NtpServer *)arg;
+  if (ipaddr) {
+    server->ip = ip_addr_get_ip4_u32(ipaddr);
+    server->dns = NTP_DNS_DONE;
+  } else {
+    server->dns = NTP_DNS_FAILED;
+  }
+}
+
+// Send the next query of the burst to ntpServerIx.
+void ntpSendQuery() {
+  TRACE_SCOPE("ntpSendQuery");
+  NtpServer &server = ntpServers[ntpServerIx];
+  while (ntpUdp.parsePacket() > 0) { // Drop late replies to earlier queries
+  }
+  ntpSendMonoUs = monoMicros();
+  ntpSendUtcUs = timeAt(ntpSendMonoUs);
+  ntpBuildRequest(ntpRequest, ntpSendUtcUs);
+  ntpUdp.beginPacket(IPAddress(server.ip), NTP_PORT);
+  ntpUdp.write(ntpRequest, NTP_PACKET_SIZE);
+  ntpUdp.endPacket();
+  ntpSendMillis = millis();
+  server.sentMonoUs = ntpSendMonoUs;
+  server.queries++;
+  ntpAwaiting = true;
+}
+
+// Drive the query burst. Returns 0 while in progress, 1 when done with at
+// least one valid sample in ntpBest, -1 when done without one.
+int ntpPoll(uint32_t curMillis) {
+  if (ntpAwaiting) {
+    int size = ntpUdp.parsePacket();
+    if (size > 0) {
+      // Receive time from the monotonic clock so slewing can't skew the delay.
+      int64_t recvMonoUs = monoMicros();
+      TRACE_SCOPE("ntpReceive");
+      int64_t recvUtcUs = ntpSendUtcUs + (recvMonoUs - ntpSendMonoUs);
+      uint8_t reply[NTP_PACKET_SIZE];
+      int len = ntpUdp.read(reply, sizeof(reply));
+      NtpSample sample;
+      char kiss[5];
+      if (len == NTP_PACKET_SIZE && ntpParseReply(reply, len, ntpRequest, ntpSendUtcUs, recvUtcUs, &sample)) {
+        ntpSamples++;
+        ntpServers[ntpServerIx].samples++;
+        if (!ntpHaveBest || sample.delayUs < ntpBest.delayUs) {
+          ntpBest = sample;
+          ntpBestMonoUs = recvMonoUs;
+          ntpBestUtcUs = recvUtcUs;
+          ntpBestServerIx = ntpServerIx;
+          ntpHaveBest = true;
+        }
+      } else if (len == NTP_PACKET_SIZE && ntpIsKiss(reply, len, ntpRequest, kiss)) {
+        // Done with this server for the sync; unless it only asked to slow
+        // down, look it up again in case the name leads elsewhere now.
+        ntpKisses++;
+        ntpServers[ntpServerIx].queries = ntpBurstSize;
+        if (strcmp(kiss, "RATE") != 0) {
+          ntpServers[ntpServerIx].dns = NTP_DNS_NONE;
+        }
+#if DEBUG==true
+        Serial.printf("[TIME] NTP server %u sent kiss-o'-death %s\n", ntpServerIx + 1, kiss);
+#endif
+      }
+      ntpAwaiting = false;
+    } else if (curMillis - ntpSendMillis > ntpReplyTimeout) {
+      ntpAwaiting = false;
+    }
+    return 0;
+  }
+
+  // Alternate between the servers, each at most once per ntpServerSpacing.
+  bool busy = false;
+  for (uint8_t n = 1; n <= 2; n++) {
+    uint8_t ix = (ntpServerIx + n) % 2;
+    NtpServer &server = ntpServers[ix];
+    if (server.queries >= ntpBurstSize) {
+      continue;
+    }
+    if (server.dns == NTP_DNS_PENDING && curMillis - server.dnsMillis > (uint32_t)ntpDnsTimeout) {
+      server.dns = NTP_DNS_FAILED;
+    }
+    if (server.dns != NTP_DNS_DONE && server.dns != NTP_DNS_PENDING) {
+#if DEBUG==true
+      Serial.printf("[TIME] Unable to resolve NTP server %u\n", ix + 1);
+#endif
+      server.queries = ntpBurstSize;
+      continue;
+    }
+    busy = true;
+    if (server.dns == NTP_DNS_PENDING || (server.sentMonoUs != 0 && monoMicros() - server.sentMonoUs < ntpServerSpacing * 1000LL)) {
+      continue;
+    }
+    ntpServerIx = ix;
+    ntpSendQuery();
+    return 0;
+  }
+  if (busy) {
+    return 0;
+  }
+  ntpUdp.stop();
+  for (uint8_t ix = 0; ix < 2; ix++) {
+    if (ntpServers[ix].samples == 0 && ntpServers[ix].dns == NTP_DNS_DONE) {
+      ntpServers[ix].dns = NTP_DNS_NONE; // Maybe moved, look it up again next time
+    }
+  }
+  return ntpHaveBest ? 1 : -1;
+}
+
 void setTimeZone(const char *localTZ) {
 #if DEBUG==true
   Serial.printf("[TIME] Setting Time Zone to: %s (%s)\n", localTZ, ianaToPosix(localTZ));
 #endif
-  setenv("TZ", ianaToPosix(localTZ), 1);
+  const char *posix = ianaToPosix(localTZ);
+  setenv("TZ", posix, 1);
   tzset();
+  // The display uses its own copy of the rule, so a frame costs a compare
+  // and an add instead of a newlib localtime_r().
+  if (!tzParse(&localZone, posix)) {
+    tzParse(&localZone, "UTC0");
+  }
+}
+
+int64_t monoMicros() {
+#if ESPVERS == 32
+  return esp_timer_get_time();
+#endif
+#if ESPVERS == 8266
+  return micros64();
+#endif
+}
+
+int64_t timeNowUs() {
+  int64_t monoUs = monoMicros();
+  TIME_SOURCE_LOCK();
+  int64_t nowUs = timeSourceNow(&timeSource, monoUs);
+  TIME_SOURCE_UNLOCK();
+  return nowUs;
+}
+
+// Timeline value at monoUs, without the monotonic clamp.
+int64_t timeAt(int64_t monoUs) {
+  TIME_SOURCE_LOCK();
+  int64_t utcUs = timeSourceAt(&timeSource, monoUs);
+  TIME_SOURCE_UNLOCK();
+  return utcUs;
+}
+
+int64_t timeSlewRemaining(int64_t monoUs) {
+  TIME_SOURCE_LOCK();
+  int64_t remainingUs = timeSourceSlewRemaining(&timeSource, monoUs);
+  TIME_SOURCE_UNLOCK();
+  return remainingUs;
+}
+
+void timeSetRate(int32_t ratePpb) {
+  int64_t monoUs = monoMicros();
+  TIME_SOURCE_LOCK();
+  timeSourceSetRate(&timeSource, monoUs, ratePpb);
+  TIME_SOURCE_UNLOCK();
+}
+
+// A consistent copy, for its counters and where it was set from.
+TimeSource timeState() {
+  TIME_SOURCE_LOCK();
+  TimeSource state = timeSource;
+  TIME_SOURCE_UNLOCK();
+  return state;
+}
+
+time_t timeNow() {
+  return timeNowUs() / 1000000;
+}
+
+void setSystemClock() {
+  int64_t nowUs = timeNowUs();
+  struct timeval tv = {(time_t)(nowUs / 1000000), (suseconds_t)(nowUs % 1000000)};
+  settimeofday(&tv, NULL);
+  systemClockLastSet = millis();
+}
+
+void syncTime(int64_t monoUs, int64_t utcUs, TimeSourceKind source, uint8_t stratum) {
+  TIME_SOURCE_LOCK();
+  int64_t offset = timeSourceSync(&timeSource, monoUs, utcUs, source, stratum);
+  TIME_SOURCE_UNLOCK();
+  setSystemClock();
+#if DEBUG==true
+  Serial.printf("[TIME] %s correction of %lld us (stratum %u)\n", timeSourceName(source), (long long)offset, stratum);
+#endif
+}
+
+DateTime readRTC() {
+  TRACE_SCOPE("readRTC");
+  rtcReads++;
+  i2cTransactions += 2;  // Register address, then the time registers
+  return rtc.now();
+}
+
+// Set the time source from the RTC, aligned to the RTC's second boundary by
+// polling until the seconds register rolls over. Blocks for up to a second,
+// so it is only used at boot.
+void syncTimeFromRTC(TimeSourceKind source) {
+  uint32_t first = readRTC().unixtime();
+  uint32_t second = first;
+  uint32_t start = millis();
+  while (second == first && millis() - start < 1100) {
+    second = readRTC().unixtime();
+    yield();
+  }
+  rtcSource = source;
+  syncTime(monoMicros(), (int64_t)second * 1000000, source, source == TIME_SOURCE_BUILD ? TIME_STRATUM_BUILD : TIME_STRATUM_RTC);
+}
+
+#ifdef SQW_PIN
+// The DS3231 seconds register advances on the falling edge of the 1 Hz SQW.
+void IRAM_ATTR rtcSqwISR() {
+  rtcPulseMicros = micros();
+  rtcPulsePending = true;
+}
+#endif
+
+// Keep the time source locked to the RTC without reading it every pass.
+// With SQW_PIN each pulse marks a true second edge, which corrects the phase
+// of the timeline. Whole seconds are checked every rtcCheckInterval by
+// reading the RTC mid-second, where the reading can't straddle an edge;
+// without SQW_PIN that read starts a phase measurement (rtcPhaseNext()).
+void disciplineFromRTC(uint32_t curMillis) {
+  uint8_t stratum = rtcSource == TIME_SOURCE_BUILD ? TIME_STRATUM_BUILD : TIME_STRATUM_RTC;
+#ifndef SQW_PIN
+  if (rtcProbeUs != 0) {
+    TimeSource state = timeState();
+    if (state.steps + state.slews != rtcProbeSyncs) {
+      rtcProbeUs = 0; // The timeline moved under the measurement
+    }
+  }
+  if (rtcProbeUs != 0) {
+    int64_t nowUs = timeAt(monoMicros());
+    if (rtcProbeUs - nowUs > TICK_SPIN_US) {
+      return;
+    }
+    uint32_t waitStart = micros();
+    while ((nowUs = timeAt(monoMicros())) < rtcProbeUs) {
+    }
+    loopWaitUs += micros() - waitStart;
+    int64_t shownUs = (int64_t)readRTC().unixtime() * 1000000;
+    rtcPhaseNarrow(shownUs, nowUs, timeAt(monoMicros()));
+    rtcPhaseNext(nowUs);
+    return;
+  }
+#else
+  if (rtcPulsePending) {
+    rtcPulsePending = false;
+    int64_t pulseMonoUs = monoMicros() - (uint32_t)(micros() - rtcPulseMicros);
+    int64_t pulseUtcUs = timeAt(pulseMonoUs);
+    int32_t err = pulseUtcUs % 1000000;
+    if (err >= 500000) {
+      err -= 1000000;
+    }
+    rtcPhaseErrorUs = err;
+    if (err > rtcMaxPhaseErrorUs || err < -rtcMaxPhaseErrorUs) {
+      syncTime(pulseMonoUs, pulseUtcUs - err, rtcSource, stratum);
+    }
+  }
+#endif
+  if (curMillis - rtcLastCheck < rtcCheckInterval && rtcLastCheck != 0) {
+    return;
+  }
+  int64_t monoUs = monoMicros();
+  int64_t nowUs = timeAt(monoUs);
+  int32_t frac = nowUs % 1000000;
+  if (frac < 250000 || frac > 750000) {
+    return;
+  }
+  rtcLastCheck = curMillis;
+  int64_t shownUs = (int64_t)readRTC().unixtime() * 1000000;
+  int64_t diffSec = shownUs / 1000000 - nowUs / 1000000;
+  if (diffSec != 0) {
+    syncTime(monoUs, nowUs + diffSec * 1000000, rtcSource, stratum);
+    driftReset(); // The next NTP offset would include this whole second
+    return;
+  }
+#ifndef SQW_PIN
+  if (timeSlewRemaining(monoUs) == 0) {
+    TimeSource state = timeState();
+    rtcPhaseLoUs = -1000000;
+    rtcPhaseHiUs = 1000000;
+    rtcProbes = 0;
+    rtcProbeSyncs = state.steps + state.slews;
+    rtcPhaseNarrow(shownUs, nowUs, timeAt(monoMicros()));
+    rtcPhaseNext(nowUs);
+  }
+#endif
+}
+
+#ifndef SQW_PIN
+// Without SQW the RTC's second edge is found by bisection. A read started at
+// time source time beforeUs and done at afterUs that shows the second shownUs
+// puts RTC minus time source within [shownUs - afterUs, shownUs + 1 s - beforeUs).
+void rtcPhaseNarrow(int64_t shownUs, int64_t beforeUs, int64_t afterUs) {
+  int64_t lo = shownUs - afterUs;
+  int64_t hi = shownUs + 1000000 - beforeUs;
+  if (lo > rtcPhaseLoUs) {
+    rtcPhaseLoUs = lo;
+  }
+  if (hi < rtcPhaseHiUs) {
+    rtcPhaseHiUs = hi;
+  }
+  rtcProbeReadUs = afterUs - beforeUs;
+  rtcProbes++;
+}
+
+// Schedule the next probe so that the middle of its read falls where the
+// middle of the bounds would put an RTC edge, so its reading halves them; one
+// per second, each a single read from loop() (waitForTick() wakes up for it).
+// A read takes most of a millisecond at 100 kHz, so once the bounds are
+// within 2 * rtcMaxPhaseErrorUs the phase is corrected like from an SQW pulse.
+void rtcPhaseNext(int64_t nowUs) {
+  int32_t midUs = rtcPhaseLoUs + (rtcPhaseHiUs - rtcPhaseLoUs) / 2;
+  if (rtcPhaseHiUs - rtcPhaseLoUs > 2 * rtcMaxPhaseErrorUs) {
+    if (rtcPhaseLoUs >= rtcPhaseHiUs || rtcProbes >= rtcPhaseMaxProbes) {
+      rtcProbeUs = 0; // Inconsistent, or reads too slow to get there
+      return;
+    }
+    int32_t leadUs = midUs + rtcProbeReadUs / 2;
+    rtcProbeUs = ((nowUs + leadUs) / 1000000 + 1) * 1000000 - leadUs;
+    return;
+  }
+  rtcProbeUs = 0;
+  int32_t err = -midUs; // Time source time at an RTC edge, as measured by an SQW pulse
+  rtcPhaseErrorUs = err;
+  if (err > rtcMaxPhaseErrorUs || err < -rtcMaxPhaseErrorUs) {
+    int64_t monoUs = monoMicros();
+    uint8_t stratum = rtcSource == TIME_SOURCE_BUILD ? TIME_STRATUM_BUILD : TIME_STRATUM_RTC;
+    syncTime(monoUs, timeAt(monoUs) - err, rtcSource, stratum);
+  }
+}
+#endif
+
+// The DS3231 only holds whole seconds and restarts its countdown when the
+// seconds register is written, so writing mid-second would leave it up to a
+// second behind. Instead the write is deferred to the next whole second edge
+// of the time source, where the truncated value is exact. A correction still
+// being slewed in would be copied along with it, so the write also waits for
+// the timeline to catch up with its reference (under 40 s at the slew rate).
+void scheduleRTCWrite() {
+  if (rtcEnabled) {
+    rtcWritePending = true;
+  }
+}
+
+// Called right after waitForTick() on a whole second edge.
+void writeRTCAtEdge() {
+  TRACE_SCOPE("writeRTC");
+  rtcWritePending = false;
+  rtcWriteLatencyUs = timeNowUs() - tickEdgeUs;
+  rtc.adjust(DateTime(tickEdgeUs / 1000000));
+  rtcWrites++;
+  i2cTransactions += 4;  // Time registers, then a read-modify-write clearing the oscillator stop flag
+  rtcSource = TIME_SOURCE_RTC;
+#ifdef SQW_PIN
+  rtcPulsePending = false; // Measured against the old RTC phase
+#else
+  rtcProbeUs = 0;
+#endif
+  rtcLastCheck = millis();
+#if DEBUG==true
+  Serial.printf("[TIME] RTC set %ld us after the second edge\n", (long)rtcWriteLatencyUs);
+#endif
+}
+
+/*
+ * Drift
+ */
+int8_t readAgingOffset() {
+  TRACE_SCOPE("readAgingOffset");
+  i2cTransactions += 2;
+  Wire.beginTransmission(DS3231_ADDRESS);
+  Wire.write(DS3231_REG_AGING);
+  Wire.endTransmission();
+  Wire.requestFrom((uint8_t)DS3231_ADDRESS, (uint8_t)1);
+  return (int8_t)Wire.read();
+}
+
+void writeAgingOffset(int8_t value) {
+  TRACE_SCOPE("writeAgingOffset");
+  i2cTransactions += 4;
+  Wire.beginTransmission(DS3231_ADDRESS);
+  Wire.write(DS3231_REG_AGING);
+  Wire.write((uint8_t)value);
+  Wire.endTransmission();
+  // The new offset takes effect at the next temperature conversion, force one.
+  Wire.beginTransmission(DS3231_ADDRESS);
+  Wire.write(DS3231_REG_CONTROL);
+  Wire.endTransmission();
+  Wire.requestFrom((uint8_t)DS3231_ADDRESS, (uint8_t)1);
+  uint8_t control = Wire.read();
+  Wire.beginTransmission(DS3231_ADDRESS);
+  Wire.write(DS3231_REG_CONTROL);
+  Wire.write(control | 0x20); // CONV
+  Wire.endTransmission();
+}
+
+// Forget the history, e.g. after the clock was set by something other than NTP.
+void driftReset() {
+  driftCount = 0;
+  driftLastSync = 0;
+}
+
+// Log the error an NTP sync found before correcting the clock.
+void driftRecord(time_t utc, int64_t offsetUs) {
+  if (driftLastSync == 0 || offsetUs > TIME_STEP_THRESHOLD_US || offsetUs < -TIME_STEP_THRESHOLD_US) {
+    // No usable reference, or the clock was stepped: start over from here.
+    driftCount = 0;
+    driftLastSync = utc;
+    return;
+  }
+  DriftPoint &point = driftHistory[driftNext];
+  point.utc = utc;
+  point.intervalS = utc - driftLastSync;
+  point.offsetUs = offsetUs;
+  driftNext = (driftNext + 1) % DRIFT_HISTORY;
+  if (driftCount < DRIFT_HISTORY) {
+    driftCount++;
+  }
+  driftLastSync = utc;
+  driftApply();
+}
+
+// Estimate the rate from the accumulated error over the accumulated time and
+// correct it once the span is long enough for the measurement resolution.
+void driftApply() {
+  int64_t sumOffsetUs = 0;
+  int64_t sumIntervalS = 0;
+  for (uint8_t i = 0; i < driftCount; i++) {
+    const DriftPoint &point = driftHistory[(driftNext + DRIFT_HISTORY - 1 - i) % DRIFT_HISTORY];
+    sumOffsetUs += point.offsetUs;
+    sumIntervalS += point.intervalS;
+  }
+  if (sumIntervalS <= 0) {
+    return;
+  }
+  driftPpm = -(float)sumOffsetUs / (float)sumIntervalS;
+
+  // Resolution of one measurement: SQW edges to a few ms, the phase probes
+  // (bounds of 2 ms, once a minute) to about 5 ms, otherwise the NTP round
+  // trip.
+#ifdef SQW_PIN
+  float resolutionUs = rtcEnabled ? 2000 : 20000;
+#else
+  float resolutionUs = rtcEnabled ? 5000 : 20000;
+#endif
+  float uncertaintyPpm = resolutionUs / (float)sumIntervalS;
+  if (sumIntervalS < driftMinSpan || fabsf(driftPpm) < 2 * uncertaintyPpm) {
+    return;
+  }
+
+  // With an RTC the timeline is phase locked to it and runs at the DS3231's
+  // rate, so NTP offsets measure the RTC crystal and the correction belongs
+  // in its aging register. SQW pulses lock it every second, without SQW_PIN
+  // the phase probes do after every whole second check. Without an RTC the
+  // timeline runs on the ESP crystal and the correction goes to the
+  // software rate.
+  if (rtcEnabled) {
+    int32_t steps = lroundf(driftPpm / DS3231_AGING_PPM); // Positive offsets slow the RTC
+    if (steps == 0) {
+      return;
+    }
+    int32_t aging = constrain(rtcAgingOffset + steps, -128, 127);
+    rtcAgingOffset = aging;
+    writeAgingOffset(rtcAgingOffset);
+#if DEBUG==true
+    Serial.printf("[TIME] RTC drift %.2f ppm, aging offset now %d\n", driftPpm, rtcAgingOffset);
+#endif
+  } else {
+    clockRatePpb -= lroundf(driftPpm * 1000);
+    timeSetRate(clockRatePpb);
+    markConfigDirty();
+#if DEBUG==true
+    Serial.printf("[TIME] Clock drift %.2f ppm, rate correction now %ld ppb\n", driftPpm, (long)clockRatePpb);
+#endif
+  }
+  driftCorrections++;
+  driftCount = 0; // Older points were measured at the old rate
+}
+
+// Returns true once the next half second edge of the time source has been
+// reached, with tickEdgeUs set to that edge. Until then it sleeps in short
+// slices (so the rest of loop() keeps running) and spins for the final
+// TICK_SPIN_US so the frame goes out right on the edge.
+bool waitForTick() {
+  int64_t nowUs = timeNowUs();
+  if (nowUs < nextTickUs && nextTickUs - nowUs <= TICK_INTERVAL_US) {
+    int64_t waitUs = nextTickUs - nowUs;
+    if (waitUs > TICK_SPIN_US) {
+      int64_t sleepUs = waitUs - TICK_SPIN_US;
+#ifndef SQW_PIN
+      // Wake up in time for an RTC phase probe due before the edge.
+      if (rtcProbeUs >= nowUs && rtcProbeUs < nextTickUs) {
+        sleepUs = rtcProbeUs - nowUs > TICK_SPIN_US ? rtcProbeUs - nowUs - TICK_SPIN_US : 0;
+      }
+#endif
+      uint32_t sleepMs = sleepUs / 1000;
+      uint32_t maxSleepMs = ntpAwaiting ? TICK_NTP_SLEEP_MS : TICK_MAX_SLEEP_MS;
+      uint32_t waitStart = micros();
+      delay(sleepMs < maxSleepMs ? sleepMs : maxSleepMs);
+      loopWaitUs += micros() - waitStart;
+      return false;
+    }
+    uint32_t waitStart = micros();
+    while ((nowUs = timeNowUs()) < nextTickUs) {
+    }
+    loopWaitUs += micros() - waitStart;
+  }
+  // Also lands here when the clock was stepped past the pending edge. Edges
+  // skipped by a step never came, so only a busy loop counts as missing them.
+  int64_t edgeUs = nowUs - nowUs % TICK_INTERVAL_US;
+  uint32_t steps = timeState().steps;
+  if (nextTickUs > 0 && edgeUs > nextTickUs && steps == tickSteps) {
+    ticksMissed += (edgeUs - nextTickUs) / TICK_INTERVAL_US;
+  }
+  tickSteps = steps;
+  tickEdgeUs = edgeUs;
+  nextTickUs = edgeUs + TICK_INTERVAL_US;
+  return true;
+}
+
+/*
+ * Display
+ */
+// mFactory uses the headerless font layout: for each character code a width
+// byte followed by that many column bytes. Index it once so glyph lookups
+// don't have to walk the table.
+void buildFontIndex() {
+  uint16_t offset = 0;
+  for (int c = 0; c < 256; c++) {
+    fontIndex[c] = offset;
+    offset += pgm_read_byte(&mFactory[offset]) + 1;
+  }
+}
+
+// Lay out text centered in the framebuffer, CHAR_SPACING blank columns between
+// glyphs. Text wider than the display is clipped on the right.
+void composeFrame(const char *text) {
+  uint16_t width = 0;
+  for (const char *c = text; *c; c++) {
+    width += pgm_read_byte(&mFactory[fontIndex[(uint8_t)*c]]);
+    if (c[1] != '\0') {
+      width += CHAR_SPACING;
+    }
+  }
+
+  memset(frameColumns, 0, sizeof(frameColumns));
+  uint16_t col = width < FRAME_COLUMNS ? (FRAME_COLUMNS - width) / 2 : 0;
+  for (const char *c = text; *c && col < FRAME_COLUMNS; c++) {
+    const uint8_t *glyph = &mFactory[fontIndex[(uint8_t)*c]];
+    uint8_t glyphWidth = pgm_read_byte(glyph);
+    for (uint8_t i = 1; i <= glyphWidth && col < FRAME_COLUMNS; i++) {
+      frameColumns[col++] = pgm_read_byte(glyph + i);
+    }
+    col += CHAR_SPACING;
+  }
+}
+
+uint8_t reverseBits(uint8_t b) {
+  b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+  b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+  b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+  return b;
+}
+
+// Write only the modules whose columns differ from what was last sent. The
+// driver only flushes rows marked changed, so untouched modules cost no SPI
+// traffic and a seconds tick stays one or two modules regardless of chain length.
+void pushFrame(bool force) {
+  TRACE_SCOPE("pushFrame");
+  for (uint8_t m = 0; m < MAX_DEVICES; m++) {
+    const uint8_t *cols = &frameColumns[m * COL_SIZE];
+    if (!force && memcmp(cols, &sentColumns[m * COL_SIZE], COL_SIZE) == 0) {
+      modulesSkipped++;
+      continue;
+    }
+    for (uint8_t c = 0; c < COL_SIZE; c++) {
+      uint16_t x = m * COL_SIZE + c;
+      if (flipDisplay) { // Rotated 180 degrees: mirror columns and rows
+        mx->setColumn(x / COL_SIZE, x % COL_SIZE, reverseBits(cols[c]));
+      } else {           // Driver column 0 is the rightmost column
+        uint16_t hw = FRAME_COLUMNS - 1 - x;
+        mx->setColumn(hw / COL_SIZE, hw % COL_SIZE, cols[c]);
+      }
+    }
+    memcpy(&sentColumns[m * COL_SIZE], cols, COL_SIZE);
+    modulesWritten++;
+  }
+  mx->update();
+}
+
+// Only lay out and push a frame to the matrix when its text differs from the
+// last one sent, e.g. the clock face is unchanged on the half second tick.
+void renderFrame(const char *frame) {
+  if (!frameDirty && strcmp(frame, lastFrame) == 0) {
+    framesSkipped++;
+    return;
+  }
+  composeFrame(frame);
+  pushFrame(frameDirty);
+  strlcpy(lastFrame, frame, sizeof(lastFrame));
+  frameDirty = false;
+  framesRendered++;
+}
+
+// Display settings that change every module (e.g. flip) need the whole
+// frame re-sent.
+void invalidateFrame() {
+  frameDirty = true;
 }
 
 /*
@@ -537,240 +1907,760 @@ void printConfigToSerial() {
     Serial.print(F(" - "));
     Serial.println(passwords[i]);
   }
-  Serial.print(F("mDNS: "));
-  Serial.println(mdns);
-  Serial.print(F("Brightness: "));
-  Serial.println(brightness);
-  Serial.print(F("Flip Display: "));
-  Serial.println(flipDisplay ? "Yes" : "No");
-  Serial.print(F("12 Hour: "));
-  Serial.println(twelveHour ? "Yes" : "No");
-  Serial.print(F("CountUpDown Locked: "));
-  Serial.println(lockCountUpDown ? "Yes" : "No");
-  Serial.print(F("Countupdown Target Timestamp: "));
-  Serial.println(countupdownTimestamp);
-  Serial.print(F("NTP Server 1: "));
-  Serial.println(ntpServer1);
-  Serial.print(F("NTP Server 2: "));
-  Serial.println(ntpServer2);
-  Serial.print(F("TimeZone (IANA): "));
-  Serial.println(timeZone);
-  Serial.print(F("LogIndex: "));
-  Serial.println(logIndex);
-  for (int i=0;i<10;i++) {
-    Serial.print(F("Log "));
-    Serial.print(i);
-    Serial.print(F(": "));
-    Serial.println(logAct[i]);
+  Serial.print(F("mDNS: "));
+  Serial.println(mdns);
+  Serial.print(F("Brightness: "));
+  Serial.println(brightness);
+  Serial.print(F("Flip Display: "));
+  Serial.println(flipDisplay ? "Yes" : "No");
+  Serial.print(F("12 Hour: "));
+  Serial.println(twelveHour ? "Yes" : "No");
+  Serial.print(F("CountUpDown Locked: "));
+  Serial.println(lockCountUpDown ? "Yes" : "No");
+  Serial.print(F("Countupdown Target Timestamp: "));
+  Serial.println(countupdownTimestamp);
+  Serial.print(F("NTP Server 1: "));
+  Serial.println(ntpServer1);
+  Serial.print(F("NTP Server 2: "));
+  Serial.println(ntpServer2);
+  Serial.print(F("TimeZone (IANA): "));
+  Serial.println(timeZone);
+  Serial.print(F("LogIndex: "));
+  Serial.println(logIndex);
+  for (int i=0;i<10;i++) {
+    Serial.print(F("Log "));
+    Serial.print(i);
+    Serial.print(F(": "));
+    Serial.println(logAct[i]);
+  }
+  Serial.println(F("========================================"));
+  Serial.println();
+#endif
+}
+
+/*
+ * Web Server
+ */
+// Settings as the UI sees them, SSIDs and passwords masked.
+void buildConfigJson(bool apMode) {
+  uint32_t version = settingsVersion;
+  JsonWriter w;
+  jsonInit(&w, configJson, sizeof(configJson));
+  jsonObjectBegin(&w);
+  jsonString(&w, "mdns", mdns);
+  jsonString(&w, "apSsid", apSsid);
+  jsonString(&w, "apPassword", apPassword);
+  jsonString(&w, "timeZone", timeZone);
+  jsonInt(&w, "brightness", brightness);
+  jsonBool(&w, "flipDisplay", flipDisplay);
+  jsonBool(&w, "twelveHour", twelveHour);
+  jsonBool(&w, "lockCountUpDown", lockCountUpDown);
+  jsonString(&w, "ntpServer1", ntpServer1);
+  jsonString(&w, "ntpServer2", ntpServer2);
+  jsonInt(&w, "clockRatePpb", clockRatePpb);
+  jsonArrayBegin(&w, "ssids");
+  for (int i=0;i<10;i++) {
+    jsonString(&w, nullptr, getSafeSsid(i));
+  }
+  jsonArrayEnd(&w);
+  jsonArrayBegin(&w, "passwords");
+  for (int i=0;i<10;i++) {
+    jsonString(&w, nullptr, getSafePassword(i));
+  }
+  jsonArrayEnd(&w);
+  jsonString(&w, "mode", apMode ? "ap" : "sta");
+  jsonInt(&w, "countupdownTimestamp", countupdownTimestamp);
+  jsonInt(&w, "logIndex", logIndex);
+  jsonArrayBegin(&w, "log");
+  for (int i=0;i<10;i++) {
+    jsonString(&w, nullptr, logAct[i]);
+  }
+  jsonArrayEnd(&w);
+  jsonObjectEnd(&w);
+  configJsonLen = w.len;
+  configJsonOverflow = w.overflow;
+  configJsonVersion = version;
+  configJsonAp = apMode;
+  snprintf(configJsonEtag, sizeof(configJsonEtag), "\"%08lx-%lu%c\"", (unsigned long)settingsBootId, (unsigned long)version, apMode ? 'a' : 's');
+  configJsonBuilds++;
+}
+
+LiveState liveState() {
+  LiveState state;
+  state.brightness           = brightness;
+  state.flipDisplay          = flipDisplay;
+  state.twelveHour           = twelveHour;
+  state.lockCountUpDown      = lockCountUpDown;
+  state.countupdownTimestamp = countupdownTimestamp;
+  return state;
+}
+
+// Members of state that differ from prev, all of them without prev.
+void jsonLiveState(JsonWriter *w, const LiveState *state, const LiveState *prev) {
+  if (!prev || state->brightness != prev->brightness) {
+    jsonInt(w, "brightness", state->brightness);
+  }
+  if (!prev || state->flipDisplay != prev->flipDisplay) {
+    jsonBool(w, "flipDisplay", state->flipDisplay);
+  }
+  if (!prev || state->twelveHour != prev->twelveHour) {
+    jsonBool(w, "twelveHour", state->twelveHour);
+  }
+  if (!prev || state->lockCountUpDown != prev->lockCountUpDown) {
+    jsonBool(w, "lockCountUpDown", state->lockCountUpDown);
+  }
+  if (!prev || state->countupdownTimestamp != prev->countupdownTimestamp) {
+    jsonInt(w, "countupdownTimestamp", state->countupdownTimestamp);
+  }
+}
+
+// Make a state live (a batch's staged copy), marking what changed dirty so
+// it is saved once.
+void commitLiveState(const LiveState *state) {
+  LiveState current = liveState();
+  bool configChanged = false;
+  if (state->brightness != current.brightness) {
+    brightness = state->brightness;
+    P.setIntensity(brightness);
+    configChanged = true;
+  }
+  if (state->flipDisplay != current.flipDisplay) {
+    flipDisplay = state->flipDisplay;
+    invalidateFrame();
+    configChanged = true;
+  }
+  if (state->twelveHour != current.twelveHour) {
+    twelveHour = state->twelveHour;
+    configChanged = true;
+  }
+  if (state->lockCountUpDown != current.lockCountUpDown) {
+    lockCountUpDown = state->lockCountUpDown;
+    configChanged = true;
+  }
+  if (configChanged) {
+    markConfigDirty();
+  }
+  if (state->countupdownTimestamp != current.countupdownTimestamp) {
+    countupdownTimestamp = state->countupdownTimestamp;
+    markRuntimeDirty();
+  }
+}
+
+// Display state returned by every control endpoint, written without a JSON
+// document into a free state buffer and sent from there.
+void sendState(AsyncWebServerRequest *request) {
+  uint8_t slot = 0;
+  while (slot < stateBufferCount && (stateBuffersTaken & (1 << slot))) {
+    slot++;
+  }
+  char copy[sizeof(stateBuffers[0])];
+  char *stateJson = slot < stateBufferCount ? stateBuffers[slot] : copy;
+  LiveState state = liveState();
+  JsonWriter w;
+  jsonInit(&w, stateJson, sizeof(stateBuffers[0]));
+  jsonObjectBegin(&w);
+  jsonLiveState(&w, &state, nullptr);
+  jsonObjectEnd(&w);
+  if (slot == stateBufferCount) {
+    stateCopies++;
+    request->send(200, "application/json", stateJson);
+    return;
+  }
+  stateBuffersTaken |= 1 << slot;
+  request->onDisconnect([slot]() {
+    stateBuffersTaken &= ~(1 << slot);
+  });
+  request->send(request->beginResponse(200, "application/json", (const uint8_t *)stateJson, w.len));
+}
+
+/*
+ * Live Events
+ */
+void sseConnect(AsyncEventSourceClient *client) {
+  // The new client is already counted.
+  if (events.count() > sseMaxClients) {
+    sseRejected++;
+    client->send("{}", "busy", 0, sseBusyRetry);
+    client->close();
+    return;
+  }
+  char stateJson[192];
+  LiveState state = liveState();
+  JsonWriter w;
+  jsonInit(&w, stateJson, sizeof(stateJson));
+  jsonObjectBegin(&w);
+  jsonInt(&w, "time", timeNow());
+  jsonLiveState(&w, &state, nullptr);
+  jsonObjectEnd(&w);
+  client->send(stateJson, "state", sseEventId);
+#if DEBUG==true
+  Serial.printf("[EVENTS] Client connected, %u open\n", (unsigned)events.count());
+#endif
+}
+
+// Called from the loop on every whole second.
+void ssePush(time_t utc) {
+  if (events.count() == 0) {
+    return;
+  }
+  if (events.avgPacketsWaiting() > sseMaxQueued) {
+    sseHeld++;
+    return;
+  }
+  TRACE_SCOPE("ssePush");
+  char eventJson[192];
+  LiveState state = liveState();
+  JsonWriter w;
+  jsonInit(&w, eventJson, sizeof(eventJson));
+  jsonObjectBegin(&w);
+  jsonInt(&w, "time", utc);
+  jsonLiveState(&w, &state, &sseSent);
+  jsonObjectEnd(&w);
+  events.send(eventJson, "state", ++sseEventId);
+  sseSent = state;
+  sseEvents++;
+}
+
+/*
+ * Form Parsing
+ */
+// /save fields. Values are views into the request's parameters, valid for
+// the duration of the handler.
+struct SaveContext {
+  bool        restartWifi;
+  const char *countupdownDate;
+  const char *countupdownTime;
+};
+typedef void (*SaveSetter)(SaveContext &ctx, int index, const char *value);
+struct SaveKey {
+  const char *name;
+  bool        indexed;  // Name is followed by a single digit index, 0-9
+  SaveSetter  set;
+};
+
+// Sorted by name (strcmp order) for the binary search in findSaveKey(),
+// which the static_assert below checks.
+static constexpr SaveKey saveKeys[] = {
+  {"apPassword", false, [](SaveContext &, int, const char *v) {
+    strlcpy(apPassword, v, sizeof(apPassword));
+  }},
+  {"apSsid", false, [](SaveContext &, int, const char *v) {
+    strlcpy(apSsid, v, sizeof(apSsid));
+  }},
+  {"brightness", false, [](SaveContext &, int, const char *v) {
+    brightness = atoi(v);
+  }},
+  {"countupdownDate", false, [](SaveContext &ctx, int, const char *v) {
+    ctx.countupdownDate = v;
+  }},
+  {"countupdownTime", false, [](SaveContext &ctx, int, const char *v) {
+    ctx.countupdownTime = v;
+  }},
+  {"flipDisplay", false, [](SaveContext &, int, const char *v) {
+    bool flip = formBool(v);
+    if (flip != flipDisplay) {
+      flipDisplay = flip;
+      invalidateFrame();
+    }
+  }},
+  {"mdns", false, [](SaveContext &, int, const char *v) {
+    if (strcmp(mdns, v) != 0) {
+      strlcpy(mdns, v, sizeof(mdns));
+      startMDNS();
+    }
+  }},
+  {"ntpServer1", false, [](SaveContext &, int, const char *v) {
+    strlcpy(ntpServer1, v, sizeof(ntpServer1));
+  }},
+  {"ntpServer2", false, [](SaveContext &, int, const char *v) {
+    strlcpy(ntpServer2, v, sizeof(ntpServer2));
+  }},
+  {"password", true, [](SaveContext &ctx, int num, const char *v) {
+    if (strcmp(v, PASSWORD_MASK) == 0 || *v == '\0') {
+#if DEBUG==true
+      Serial.println(F("[WEBSERVER] Password unchanged."));
+#endif
+      return; // Keep the previous password
+    }
+#if DEBUG==true
+    Serial.print(F("[WEBSERVER] Password changed for network "));
+    Serial.println(num+1);
+#endif
+    if (strcmp(passwords[num], v) != 0) {
+#if DEBUG==true
+      Serial.println(F("[WEBSERVER] RestartWiFi set to true."));
+#endif
+      ctx.restartWifi = true;
+    }
+    strlcpy(passwords[num], v, sizeof(passwords[num])); // user entered a new password
+  }},
+  {"ssid", true, [](SaveContext &ctx, int num, const char *v) {
+#if DEBUG==true
+    Serial.print(F("[WEBSERVER] SSID "));
+    Serial.printf("%d: '%s' (%s)\n", num+1, v, ssids[num]);
+#endif
+    if (strcmp(ssids[num], v) != 0) {
+      ctx.restartWifi = true;
+    }
+    strlcpy(ssids[num], v, sizeof(ssids[num]));
+    if (*v == '\0') {
+      strlcpy(passwords[num], "", sizeof(passwords[num]));
+    }
+  }},
+  {"timeZone", false, [](SaveContext &, int, const char *v) {
+    strlcpy(timeZone, v, sizeof(timeZone));
+    setTimeZone(timeZone);
+  }},
+  {"twelveHour", false, [](SaveContext &, int, const char *v) {
+    twelveHour = formBool(v);
+  }},
+};
+
+constexpr int constexprStrcmp(const char *a, const char *b) {
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return (unsigned char)*a - (unsigned char)*b;
+}
+
+constexpr bool saveKeysSorted() {
+  for (size_t i = 1; i < sizeof(saveKeys) / sizeof(saveKeys[0]); i++) {
+    if (constexprStrcmp(saveKeys[i - 1].name, saveKeys[i].name) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(saveKeysSorted(), "saveKeys must be sorted by name in strcmp order");
+
+// strcmp() of key against the first len chars of name as a whole string.
+static int compareSaveKey(const char *key, const char *name, size_t len) {
+  int cmp = strncmp(key, name, len);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return key[len] == '\0' ? 0 : 1;
+}
+
+static const SaveKey *searchSaveKeys(const char *name, size_t len) {
+  size_t lo = 0;
+  size_t hi = sizeof(saveKeys) / sizeof(saveKeys[0]);
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    int cmp = compareSaveKey(saveKeys[mid].name, name, len);
+    if (cmp == 0) {
+      return &saveKeys[mid];
+    }
+    if (cmp > 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return nullptr;
+}
+
+// Exact names first, then "<indexed key><digit>" with the digit in index.
+const SaveKey *findSaveKey(const char *name, int *index) {
+  size_t len = strlen(name);
+  const SaveKey *key = searchSaveKeys(name, len);
+  if (key) {
+    return key->indexed ? nullptr : key;
+  }
+  if (len < 2 || name[len - 1] < '0' || name[len - 1] > '9') {
+    return nullptr;
+  }
+  key = searchSaveKeys(name, len - 1);
+  if (!key || !key->indexed) {
+    return nullptr;
+  }
+  *index = name[len - 1] - '0';
+  return key;
+}
+
+/*
+ * Batch Commands
+ */
+// POST /api/batch takes a JSON array (application/json) of operations named
+// after the control endpoints, e.g.
+//   [{"op":"stop"},{"op":"set_countupdown","value":"2025-06-01 09:00"},{"op":"set_lock","value":true}]
+// They are applied in order to a copy of the live state, each checked like
+// its endpoint against what the ones before left. Only if all of them
+// succeed does the copy go live, saved once like any other change.
+const size_t batchMaxBody = 1024;
+const size_t batchMaxOps  = 16;
+
+struct BatchContext {
+  LiveState state;
+  time_t    now;
+};
+// Returns 0, or an HTTP status with *error set.
+typedef int (*BatchApply)(BatchContext &ctx, JsonVariantConst value, const char **error);
+struct BatchOp {
+  const char *name;
+  BatchApply  apply;
+};
+
+static bool batchBool(JsonVariantConst value, bool *out) {
+  if (value.is<bool>()) {
+    *out = value.as<bool>();
+  } else if (value.is<int>()) {
+    *out = value.as<int>() != 0;
+  } else if (value.is<const char *>()) {
+    *out = formBool(value.as<const char *>());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The checks /start, /stop and the seconds adjustments make.
+static int batchCheckCountUpDown(BatchContext &ctx, bool mustRun, const char *notRunning, const char **error) {
+  if (ctx.state.lockCountUpDown) {
+    *error = "CountUpDown locked.";
+    return 409;
+  }
+  if ((ctx.state.countupdownTimestamp > 0) != mustRun) {
+    *error = mustRun ? notRunning : "CountUpDown already running.";
+    return 409;
+  }
+  return 0;
+}
+
+static int batchAdjustSeconds(BatchContext &ctx, JsonVariantConst value, int sign, const char **error) {
+  int status = batchCheckCountUpDown(ctx, true, "CountUpDown not set, unable to adjust.", error);
+  if (status) {
+    return status;
+  }
+  if (!value.is<int>()) {
+    *error = "Missing value";
+    return 400;
+  }
+  int seconds = value.as<int>() * sign;
+  if (ctx.state.countupdownTimestamp < ctx.now) { // Count Up!
+    seconds = seconds * -1;
+  }
+  ctx.state.countupdownTimestamp += seconds;
+  return 0;
+}
+
+static const BatchOp batchOps[] = {
+  {"add_seconds", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    return batchAdjustSeconds(ctx, value, 1, error);
+  }},
+  {"remove_seconds", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    return batchAdjustSeconds(ctx, value, -1, error);
+  }},
+  {"set_brightness", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    if (!value.is<int>()) {
+      *error = "Missing value";
+      return 400;
+    }
+    ctx.state.brightness = constrain(value.as<int>(), 1, 15);
+    return 0;
+  }},
+  {"set_countupdown", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    struct tm tm;
+    time_t target = (time_t)-1;
+    if (value.is<const char *>() && parseLocalDateTime(value.as<const char *>(), &tm)) {
+      target = mktime(&tm);
+    }
+    if (target == (time_t)-1) {
+      *error = "Invalid datetime";
+      return 400;
+    }
+    ctx.state.countupdownTimestamp = target;
+    return 0;
+  }},
+  {"set_flip", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    *error = "Missing value";
+    return batchBool(value, &ctx.state.flipDisplay) ? 0 : 400;
+  }},
+  {"set_lock", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    *error = "Missing value";
+    return batchBool(value, &ctx.state.lockCountUpDown) ? 0 : 400;
+  }},
+  {"set_twelvehour", [](BatchContext &ctx, JsonVariantConst value, const char **error) {
+    *error = "Missing value";
+    return batchBool(value, &ctx.state.twelveHour) ? 0 : 400;
+  }},
+  {"start", [](BatchContext &ctx, JsonVariantConst, const char **error) {
+    int status = batchCheckCountUpDown(ctx, false, nullptr, error);
+    if (status == 0) {
+      ctx.state.countupdownTimestamp = ctx.now;
+    }
+    return status;
+  }},
+  {"stop", [](BatchContext &ctx, JsonVariantConst, const char **error) {
+    int status = batchCheckCountUpDown(ctx, true, "CountUpDown not running.", error);
+    if (status == 0) {
+      ctx.state.countupdownTimestamp = 0;
+    }
+    return status;
+  }},
+};
+
+static const BatchOp *findBatchOp(const char *name) {
+  for (const BatchOp &op : batchOps) {
+    if (strcmp(op.name, name) == 0) {
+      return &op;
+    }
+  }
+  return nullptr;
+}
+
+// Request body collected into _tempObject, which the server frees with the
+// request.
+static void batchBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (total > batchMaxBody) {
+    return;
+  }
+  if (index == 0) {
+    request->_tempObject = malloc(total);
+  }
+  if (request->_tempObject && index + len <= total) {
+    memcpy((uint8_t *)request->_tempObject + index, data, len);
+  }
+}
+
+static void batchRequest(AsyncWebServerRequest *request) {
+#if DEBUG==true
+  Serial.println(F("[WEBSERVER] Request: /api/batch"));
+#endif
+  if (request->contentLength() > batchMaxBody) {
+    request->send(413, "application/json", "{\"error\":\"Batch too large\"}");
+    return;
+  }
+  if (!request->_tempObject) {
+    request->send(400, "application/json", "{\"error\":\"Missing body\"}");
+    return;
+  }
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, (const char *)request->_tempObject, request->contentLength());
+  if (err || !doc.is<JsonArrayConst>()) {
+    request->send(400, "application/json", "{\"error\":\"Expected a JSON array of operations\"}");
+    return;
+  }
+  JsonArrayConst ops = doc.as<JsonArrayConst>();
+  if (ops.size() > batchMaxOps) {
+    request->send(400, "application/json", "{\"error\":\"Too many operations\"}");
+    return;
+  }
+
+  BatchContext ctx = {liveState(), timeNow()};
+  size_t i = 0;
+  for (JsonVariantConst item : ops) {
+    const BatchOp *op = findBatchOp(item["op"] | "");
+    const char *error = "Unknown op";
+    int status = op ? op->apply(ctx, item["value"], &error) : 400;
+    if (status) {
+#if DEBUG==true
+      Serial.printf("[WEBSERVER] Batch rejected at op %u: %s\n", (unsigned)i, error);
+#endif
+      char errorJson[96];
+      snprintf(errorJson, sizeof(errorJson), "{\"error\":\"%s\",\"op\":%u}", error, (unsigned)i);
+      request->send(status, "application/json", errorJson);
+      return;
+    }
+    i++;
+  }
+  commitLiveState(&ctx.state);
+  sendState(request);
+}
+
+// server.on() with the handler's run time recorded for the route.
+AsyncCallbackWebHandler &onRoute(const char *path, WebRequestMethodComposite method, ArRequestHandlerFunction handler,
+                                 ArBodyHandlerFunction body) {
+  if (metricsRouteCount < metricsMaxRoutes) {
+    MetricsRoute *route = &metricsRoutes[metricsRouteCount++];
+    route->path = path;
+    handler = [route, handler](AsyncWebServerRequest *request) {
+      TRACE_SCOPE(route->path);
+      uint32_t start = micros();
+      handler(request);
+      metricsRouteRecord(route, micros() - start);
+    };
   }
-  Serial.println(F("========================================"));
-  Serial.println();
+  if (body) {
+    return server.on(path, method, handler, nullptr, body);
+  }
+  return server.on(path, method, handler);
+}
+
+// Prometheus text exposition of the timings and a few gauges. Formatted only
+// here, when scraped.
+void sendMetrics(AsyncWebServerRequest *request) {
+#if DEBUG==true
+  Serial.println(F("[WEBSERVER] Request: /metrics"));
+#endif
+  AsyncResponseStream *out = request->beginResponseStream("text/plain; version=0.0.4");
+  metricsHeader(*out, "chronoclock_loop_seconds", "histogram", "Duration of loop() iterations, without waiting for the next tick.");
+  metricsHistogram(*out, "chronoclock_loop_seconds", nullptr, &metricsLoop);
+  metricsHeader(*out, "chronoclock_stage_seconds", "histogram", "Duration of loop() stages.");
+  metricsHistogram(*out, "chronoclock_stage_seconds", "stage=\"wifi\"", &metricsWifi);
+  metricsHistogram(*out, "chronoclock_stage_seconds", "stage=\"ota\"", &metricsOta);
+  metricsHistogram(*out, "chronoclock_stage_seconds", "stage=\"ntp\"", &metricsNtp);
+  metricsHistogram(*out, "chronoclock_stage_seconds", "stage=\"rtc\"", &metricsRtc);
+  metricsHistogram(*out, "chronoclock_stage_seconds", "stage=\"render\"", &metricsRender);
+  metricsHeader(*out, "chronoclock_config_save_seconds", "histogram", "Duration of saveConfig().");
+  metricsHistogram(*out, "chronoclock_config_save_seconds", nullptr, &metricsSave);
+
+  metricsHeader(*out, "chronoclock_http_requests_total", "counter", "Requests handled per route.");
+  for (uint8_t i = 0; i < metricsRouteCount; i++) {
+    out->printf("chronoclock_http_requests_total{path=\"%s\"} %lu\n", metricsRoutes[i].path, (unsigned long)metricsRoutes[i].count);
+  }
+  metricsHeader(*out, "chronoclock_http_handler_seconds_total", "counter", "Time spent in request handlers per route.");
+  for (uint8_t i = 0; i < metricsRouteCount; i++) {
+    out->printf("chronoclock_http_handler_seconds_total{path=\"%s\"} %.6f\n", metricsRoutes[i].path, metricsRoutes[i].sumUs / 1e6);
+  }
+  metricsHeader(*out, "chronoclock_http_handler_max_seconds", "gauge", "Longest request handler run per route.");
+  for (uint8_t i = 0; i < metricsRouteCount; i++) {
+    out->printf("chronoclock_http_handler_max_seconds{path=\"%s\"} %.6f\n", metricsRoutes[i].path, metricsRoutes[i].maxUs / 1e6);
+  }
+
+  metricsHeader(*out, "chronoclock_config_saves_total", "counter", "Settings writes to flash.");
+  metricsValue(*out, "chronoclock_config_saves_total", nullptr, configWrites);
+  metricsHeader(*out, "chronoclock_heap_free_bytes", "gauge", "Free heap.");
+  metricsValue(*out, "chronoclock_heap_free_bytes", nullptr, ESP.getFreeHeap());
+  metricsHeader(*out, "chronoclock_heap_max_block_bytes", "gauge", "Largest allocatable heap block.");
+#if ESPVERS == 32
+  metricsValue(*out, "chronoclock_heap_max_block_bytes", nullptr, ESP.getMaxAllocHeap());
+#endif
+#if ESPVERS == 8266
+  metricsValue(*out, "chronoclock_heap_max_block_bytes", nullptr, ESP.getMaxFreeBlockSize());
 #endif
+  if (wifiState == WIFI_CONNECTED) {
+    metricsHeader(*out, "chronoclock_wifi_rssi_dbm", "gauge", "Received signal strength.");
+    metricsValue(*out, "chronoclock_wifi_rssi_dbm", nullptr, WiFi.RSSI());
+  }
+  metricsHeader(*out, "chronoclock_ntp_offset_seconds", "gauge", "Clock error found by the last NTP sync.");
+  metricsValue(*out, "chronoclock_ntp_offset_seconds", nullptr, ntpLastResult.offsetUs / 1e6);
+  metricsHeader(*out, "chronoclock_ntp_delay_seconds", "gauge", "Round trip delay of the last NTP sync.");
+  metricsValue(*out, "chronoclock_ntp_delay_seconds", nullptr, ntpLastResult.delayUs / 1e6);
+  metricsHeader(*out, "chronoclock_ticks_missed_total", "counter", "Display edges passed while the loop was busy.");
+  metricsValue(*out, "chronoclock_ticks_missed_total", nullptr, ticksMissed);
+  metricsHeader(*out, "chronoclock_flash_logical_bytes_total", "counter", "Bytes written to LittleFS files.");
+  metricsValue(*out, "chronoclock_flash_logical_bytes_total", nullptr, flashWear.logicalBytes);
+  metricsHeader(*out, "chronoclock_flash_physical_bytes_total", "counter", "Estimated bytes programmed, including copies and metadata.");
+  metricsValue(*out, "chronoclock_flash_physical_bytes_total", nullptr, flashWear.physicalBytes);
+  metricsHeader(*out, "chronoclock_flash_erases_total", "counter", "Estimated block erases.");
+  metricsValue(*out, "chronoclock_flash_erases_total", nullptr, flashWear.erases);
+  metricsHeader(*out, "chronoclock_flash_file_writes_total", "counter", "LittleFS file write sessions.");
+  metricsValue(*out, "chronoclock_flash_file_writes_total", nullptr, flashWear.sessions);
+  metricsHeader(*out, "chronoclock_i2c_transactions_total", "counter", "I2C bus transactions with the RTC.");
+  metricsValue(*out, "chronoclock_i2c_transactions_total", nullptr, i2cTransactions);
+  metricsHeader(*out, "chronoclock_uptime_seconds", "gauge", "Time since boot.");
+  metricsValue(*out, "chronoclock_uptime_seconds", nullptr, millis() / 1e3);
+  request->send(out);
 }
 
-/*
- * Web Server
- */
 void setupWebServer() {
 #if DEBUG==true
   Serial.println(F("[WEBSERVER] Setting up web server..."));
 #endif
 
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+  // The UI is built into the firmware, gzipped, with a content hash ETag.
+  for (const WebAsset &asset : webAssets) {
+    const WebAsset *a = &asset;
+    onRoute(a->path, HTTP_GET, [a](AsyncWebServerRequest *request) {
 #if DEBUG==true
-    Serial.println(F("[WEBSERVER] Request: /"));
+      Serial.print(F("[WEBSERVER] Request: "));
+      Serial.println(a->path);
 #endif
-    request->send(LittleFS, "/index.html", "text/html");
-  });
-
-  server.on("/favicon.ico", HTTP_GET, [](AsyncWebServerRequest *request) {
-#if DEBUG==true
-    Serial.println(F("[WEBSERVER] Request: /favicon.ico"));
-#endif
-    request->send(LittleFS, "/favicon.ico", "image/x-icon");
-  });
+      const AsyncWebHeader *match = request->getHeader("If-None-Match");
+      AsyncWebServerResponse *response;
+      if (match && strcmp(match->value().c_str(), a->etag) == 0) {
+        response = request->beginResponse(304);
+      } else {
+        response = request->beginResponse(200, a->contentType, a->gzip, a->length);
+        response->addHeader("Content-Encoding", "gzip");
+      }
+      response->addHeader("ETag", a->etag);
+      response->addHeader("Cache-Control", a->cacheControl);
+      request->send(response);
+    });
+  }
 
-  server.on("/health", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/health", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /health"));
 #endif
     request->send(204);
   });
 
-  server.on("/config.json", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/config.json", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /config.json"));
 #endif
-    File f = LittleFS.open("/config.json", "r");
-    if (!f) {
-#if DEBUG==true
-      Serial.println(F("[WEBSERVER] Error opening /config.json"));
-#endif
-      request->send(500, "application/json", "{\"error\":\"Failed to open config.json\"}");
-      return;
+    bool apMode = wifiState == WIFI_APMODE;
+    if (configJsonVersion != settingsVersion || configJsonAp != apMode) {
+      buildConfigJson(apMode);
     }
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, f);
-    f.close();
-    if (err) {
-#if DEBUG==true
-      Serial.print(F("[WEBSERVER] Error parsing /config.json: "));
-      Serial.println(err.f_str());
-#endif
-      request->send(500, "application/json", "{\"error\":\"Failed to parse config.json\"}");
+    const AsyncWebHeader *match = request->getHeader("If-None-Match");
+    if (match && strcmp(match->value().c_str(), configJsonEtag) == 0) {
+      configJsonNotModified++;
+      AsyncWebServerResponse *response = request->beginResponse(304);
+      response->addHeader("ETag", configJsonEtag);
+      request->send(response);
       return;
     }
-
-    // Always sanitize before sending to browser
-    JsonArray ssidArray = doc[F("ssids")];
-    JsonArray pwdArray = doc[F("passwords")];
-    for (int i=0;i<10;i++) {
-      ssidArray[i] = getSafeSsid(i);
-      pwdArray[i] = getSafePassword(i);
+    if (configJsonOverflow) {
+      request->send(500, "application/json", "{\"error\":\"Config too large\"}");
+      return;
     }
-    doc[F("mode")] = wifiState == WIFI_APMODE ? "ap" : "sta";
-    String response;
-    serializeJson(doc, response);
-    request->send(200, "application/json", response);
+    // The response keeps its own copy; configJson may be rebuilt while it is still being sent.
+    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", configJson);
+    response->addHeader("ETag", configJsonEtag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
   });
 
-  server.on("/save", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/save", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /save"));
 #endif
-    bool restartWifi = false;
-
-    String countupdownDateStr = "";
-    String countupdownTimeStr = "";
-    for (u_int i = 0; i < request->params(); i++) {
+    SaveContext ctx = {false, nullptr, nullptr};
+    for (size_t i = 0; i < request->params(); i++) {
       const AsyncWebParameter *p = request->getParam(i);
-      String n = p->name();
-      String v = p->value();
-
-      if (n == "brightness") {
-        brightness = v.toInt();
-      } else if (n == "flipDisplay") {
-        flipDisplay = (v == "true" || v == "on" || v == "1");
-      } else if (n == "twelveHour") {
-        twelveHour = (v == "true" || v == "on" || v == "1");
-      } else if (n == "password0"
-              || n == "password1"
-              || n == "password2"
-              || n == "password3"
-              || n == "password4"
-              || n == "password5"
-              || n == "password6"
-              || n == "password7"
-              || n == "password8"
-              || n == "password9") {
-        if (strcmp(v.c_str(), PASSWORD_MASK) != 0 && v.length() > 0) {
-          int num = n.substring(8).toInt();
-#if DEBUG==true
-          Serial.print(F("[WEBSERVER] Password changed for network "));
-          Serial.println(num+1);
-#endif
-          if (strcmp(passwords[num], v.c_str()) != 0) {
-#if DEBUG==true
-            Serial.println(F("[WEBSERVER] RestartWiFi set to true."));
-#endif
-            restartWifi = true;
-          }
-          strlcpy(passwords[num], v.c_str(), sizeof(passwords[num])); // user entered a new password
-        }
-#if DEBUG==true
-        else { // do nothing, keep previous
-          Serial.println(F("[WEBSERVER] Password unchanged."));
-        }
-#endif
-      } else if (n == "ssid0"
-              || n == "ssid1"
-              || n == "ssid2"
-              || n == "ssid3"
-              || n == "ssid4"
-              || n == "ssid5"
-              || n == "ssid6"
-              || n == "ssid7"
-              || n == "ssid8"
-              || n == "ssid9") {
-        int num = n.substring(4).toInt();
-#if DEBUG==true
-        Serial.print(F("[WEBSERVER] SSID "));
-        Serial.printf("%d: '%s' (%s)\n", num+1, v.c_str(), ssids[num]);
-#endif
-        if (v.length() == 0) {
-          if (strlen(ssids[num]) > 0) {
-            restartWifi = true;
-          }
-          strlcpy(ssids[num], "", sizeof(ssids[num]));
-          strlcpy(passwords[num], "", sizeof(passwords[num]));
-        } else {
-          if (strcmp(ssids[num], v.c_str()) != 0) {
-            restartWifi = true;
-          }
-          strlcpy(ssids[num], v.c_str(), sizeof(ssids[num]));
-        }
-      } else if (n == "ntpServer1") {
-        strlcpy(ntpServer1, v.c_str(), sizeof(ntpServer1));
-      } else if (n == "ntpServer2") {
-        strlcpy(ntpServer2, v.c_str(), sizeof(ntpServer2));
-      } else if (n == "timeZone") {
-        strlcpy(timeZone, v.c_str(), sizeof(timeZone));
-        setTimeZone(timeZone);
-      } else if (n == "mdns") {
-        if (strcmp(mdns, v.c_str()) != 0) {
-          strlcpy(mdns, v.c_str(), sizeof(mdns));
-          startMDNS();
-        } else {
-          strlcpy(mdns, v.c_str(), sizeof(mdns));
-        }
-      } else if (n == "countupdownDate") {
-        countupdownDateStr = v;
-      } else if (n == "countupdownTime") {
-        countupdownTimeStr = v;
-      } else if (n == "apSsid") {
-        strlcpy(apSsid, v.c_str(), sizeof(apSsid));
-      } else if (n == "apPassword") {
-        strlcpy(apPassword, v.c_str(), sizeof(apPassword));
+      int index = -1;
+      const SaveKey *key = findSaveKey(p->name().c_str(), &index);
+      if (key) {
+        key->set(ctx, index, p->value().c_str());
       }
     }
+    bool restartWifi = ctx.restartWifi;
 
-    if (countupdownDateStr.length() > 0 && countupdownTimeStr.length() > 0) {
+    time_t previousTimestamp = countupdownTimestamp;
+    if (ctx.countupdownDate && ctx.countupdownTime && *ctx.countupdownDate && *ctx.countupdownTime) {
       struct tm tm;
-      tm.tm_year = countupdownDateStr.substring(0, 4).toInt() - 1900;
-      tm.tm_mon = countupdownDateStr.substring(5, 7).toInt() - 1;
-      tm.tm_mday = countupdownDateStr.substring(8, 10).toInt();
-      tm.tm_hour = countupdownTimeStr.substring(0, 2).toInt();
-      tm.tm_min = countupdownTimeStr.substring(3, 5).toInt();
-      tm.tm_sec = countupdownTimeStr.substring(6, 8).toInt();
-      tm.tm_isdst = -1;
-      countupdownTimestamp = mktime(&tm);
-      if (countupdownTimestamp == (time_t)-1) {
+      time_t target = (time_t)-1;
+      if (parseDateTime(ctx.countupdownDate, ctx.countupdownTime, &tm)) {
+        target = mktime(&tm);
+      }
+      if (target == (time_t)-1) {
 #if DEBUG==true
         Serial.println(F("[WEBSERVER] Error converting countupdown date/time to timestamp."));
 #endif
         countupdownTimestamp = 0;
-      }
+      } else {
+        countupdownTimestamp = target;
 #if DEBUG==true
-      else {
         Serial.print(F("[WEBSERVER] Converted countupdown target: "));
-        Serial.printf("%s %s -> %lld\n", countupdownDateStr.c_str(), countupdownTimeStr.c_str(), countupdownTimestamp);
-      }
+        Serial.printf("%s %s -> %lld\n", ctx.countupdownDate, ctx.countupdownTime, (long long)countupdownTimestamp);
 #endif
+      }
     }
 
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-    } else {
-#if DEBUG==true
-      Serial.println(F("[WEBSERVER] Config saved successful."));
-#endif
-      JsonDocument okDoc;
-      okDoc[F("message")] = "Saved successfully.";
-      String response;
-      serializeJson(okDoc, response);
-      request->send(200, "application/json", response);
+    markConfigDirty();
+    if (countupdownTimestamp != previousTimestamp) {
+      markRuntimeDirty(); // Journal record only for a new target
     }
+    JsonDocument okDoc;
+    okDoc[F("message")] = "Saved successfully.";
+    String response;
+    serializeJson(okDoc, response);
+    request->send(200, "application/json", response);
 
     request->onDisconnect([restartWifi]() {
       if (restartWifi) {
@@ -782,43 +2672,16 @@ void setupWebServer() {
     });
   });
 
-  server.on("/restore", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/restore", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /restore"));
 #endif
-    if (LittleFS.exists("/config.bak")) {
-      File src = LittleFS.open("/config.bak", "r");
-      if (!src) {
-#if DEBUG==true
-        Serial.println(F("[WEBSERVER] Failed to open /config.bak"));
+#if BINARY_CONFIG==true
+    const char *backupPath = configPaths[1];
+#else
+    const char *backupPath = "/config.bak";
 #endif
-        JsonDocument errorDoc;
-        errorDoc[F("error")] = "Failed to open backup file.";
-        String response;
-        serializeJson(errorDoc, response);
-        request->send(500, "application/json", response);
-        return;
-      }
-      File dst = LittleFS.open("/config.json", "w");
-      if (!dst) {
-        src.close();
-#if DEBUG==true
-        Serial.println(F("[WEBSERVER] Failed to open /config.json for writing"));
-#endif
-        JsonDocument errorDoc;
-        errorDoc[F("error")] = "Failed to open config for writing.";
-        String response;
-        serializeJson(errorDoc, response);
-        request->send(500, "application/json", response);
-        return;
-      }
-
-      while (src.available()) {
-        dst.write(src.read());
-      }
-      src.close();
-      dst.close();
-
+    if (LittleFS.exists(backupPath)) {
       JsonDocument okDoc;
       okDoc[F("message")] = "✅ Backup restored! Device will now reboot.";
       String response;
@@ -828,7 +2691,7 @@ void setupWebServer() {
 #if DEBUG==true
         Serial.println(F("[WEBSERVER] Rebooting after restore..."));
 #endif
-        ESP.restart();
+        restoreRequested = true;
       });
     } else {
 #if DEBUG==true
@@ -842,7 +2705,7 @@ void setupWebServer() {
     }
   });
 
-  server.on("/clear_wifi", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/clear_wifi", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /clear_wifi"));
 #endif
@@ -850,14 +2713,7 @@ void setupWebServer() {
       strlcpy(ssids[i], "", sizeof(ssids[i]));
       strlcpy(passwords[i], "", sizeof(passwords[i]));
     }
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-#if DEBUG==true
-      Serial.println(F("[CLEARWIFI] Error saving cleared WiFi credentials."));
-#endif
-      request->send(500, "application/json", msg);
-      return;
-    }
+    markConfigDirty();
 #if DEBUG==true
     Serial.println(F("[CLEARWIFI] WiFi credentials cleared."));
 #endif
@@ -874,7 +2730,7 @@ void setupWebServer() {
     });
   });
   
-  server.on("/ap_status", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/ap_status", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.print(F("[WEBSERVER] Request: /ap_status. isAPMode = "));
     Serial.println(wifiState == WIFI_APMODE);
@@ -885,7 +2741,7 @@ void setupWebServer() {
     request->send(200, "application/json", json);
   });
 
-  server.on("/set_brightness", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/set_brightness", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /set_brightness"));
 #endif
@@ -904,23 +2760,11 @@ void setupWebServer() {
 #endif
     brightness = newBrightness;
     P.setIntensity(brightness);
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markConfigDirty();
+    sendState(request);
   });
 
-  server.on("/set_flip", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/set_flip", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /set_flip"));
 #endif
@@ -930,29 +2774,16 @@ void setupWebServer() {
       flip = (v == "1" || v == "true" || v == "on");
     }
     flipDisplay = flip;
-    P.setZoneEffect(0, flipDisplay, PA_FLIP_UD);
-    P.setZoneEffect(0, flipDisplay, PA_FLIP_LR);
+    invalidateFrame();
 #if DEBUG==true
     Serial.print(F("[WEBSERVER] Set flipDisplay to "));
     Serial.println(flipDisplay);
 #endif
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markConfigDirty();
+    sendState(request);
   });
 
-  server.on("/set_twelvehour", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/set_twelvehour", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /set_twelvehour"));
 #endif
@@ -966,33 +2797,21 @@ void setupWebServer() {
     Serial.print(F("[WEBSERVER] Set twelveHour to "));
     Serial.println(twelveHour);
 #endif
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markConfigDirty();
+    sendState(request);
   });
 
-  server.on("/restart", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/restart", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /restart"));
 #endif
     request->send(200, "application/json", "{\"ok\":true}");
     request->onDisconnect([](){
-      ESP.restart();
+      restartRequested = true;
     });
   });
 
-  server.on("/set_lock", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/set_lock", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /set_lock"));
 #endif
@@ -1006,23 +2825,11 @@ void setupWebServer() {
     Serial.print(F("[WEBSERVER] Set lockCountUpDown to "));
     Serial.println(lockCountUpDown);
 #endif
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markConfigDirty();
+    sendState(request);
   });
 
-  server.on("/set_countupdown", HTTP_POST, [](AsyncWebServerRequest *request) {
+  onRoute("/set_countupdown", HTTP_POST, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /set_countupdown"));
 #endif
@@ -1030,16 +2837,9 @@ void setupWebServer() {
       request->send(400, "application/json", "{\"error\":\"Missing value\"}");
       return;
     }
-    String DateTimeStr = request->getParam("DateTime", true)->value();
-    if (DateTimeStr.length() == 19) {
-      struct tm tm;
-      tm.tm_year = DateTimeStr.substring(0, 4).toInt() - 1900;
-      tm.tm_mon = DateTimeStr.substring(5, 7).toInt() - 1;
-      tm.tm_mday = DateTimeStr.substring(8, 10).toInt();
-      tm.tm_hour = DateTimeStr.substring(11, 13).toInt();
-      tm.tm_min = DateTimeStr.substring(14, 16).toInt();
-      tm.tm_sec = DateTimeStr.substring(17, 19).toInt();
-      tm.tm_isdst = -1;
+    const char *DateTimeStr = request->getParam("DateTime", true)->value().c_str();
+    struct tm tm;
+    if (parseLocalDateTime(DateTimeStr, &tm)) {
       countupdownTimestamp = mktime(&tm);
       if (countupdownTimestamp == (time_t)-1) {
 #if DEBUG==true
@@ -1050,28 +2850,17 @@ void setupWebServer() {
 #if DEBUG==true
       else {
         Serial.print(F("[WEBSERVER] Converted countupdown target: "));
-        Serial.printf("%s -> %lld\n", DateTimeStr.c_str(), countupdownTimestamp);
+        Serial.printf("%s -> %lld\n", DateTimeStr, (long long)countupdownTimestamp);
       }
 #endif
-      String msg = saveConfig();
-      if (msg.length() > 0) {
-        request->send(500, "application/json", msg);
-        return;
-      }
-      JsonDocument okDoc;
-      okDoc[F("flipDisplay")] = flipDisplay;
-      okDoc[F("twelveHour")] = twelveHour;
-      okDoc[F("lockCountUpDown")] = lockCountUpDown;
-      okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-      String response;
-      serializeJson(okDoc, response);
-      request->send(200, "application/json", response);
+      markRuntimeDirty();
+      sendState(request);
     } else {
       request->send(400, "application/json", "{\"error\":\"Invalid datetime\"}");
     }
   });
 
-  server.on("/start", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/start", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /start"));
 #endif
@@ -1083,28 +2872,12 @@ void setupWebServer() {
       request->send(409, "application/json", "{\"error\":\"CountUpDown already running.\"}"); // Conflict
       return;
     }
-    if (rtcEnabled) {
-      countupdownTimestamp = rtc.now().unixtime();
-    } else {
-      countupdownTimestamp = time(nullptr);
-    }
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    countupdownTimestamp = timeNow();
+    markRuntimeDirty();
+    sendState(request);
   });
 
-  server.on("/stop", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/stop", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /stop"));
 #endif
@@ -1117,23 +2890,11 @@ void setupWebServer() {
       return;
     }
     countupdownTimestamp = 0;
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markRuntimeDirty();
+    sendState(request);
   });
 
-  server.on("/add_seconds", HTTP_POST, [](AsyncWebServerRequest *request){
+  onRoute("/add_seconds", HTTP_POST, [](AsyncWebServerRequest *request){
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /add_seconds"));
 #endif
@@ -1149,34 +2910,16 @@ void setupWebServer() {
       request->send(400, "application/json", "{\"error\":\"Missing value\"}");
       return;
     }
-    DateTime dtNow;
-    if (rtcEnabled) {
-      dtNow = rtc.now();
-    } else {
-      dtNow = DateTime(time(nullptr));
-    }
     int seconds = request->getParam("seconds", true)->value().toInt();
-    if (countupdownTimestamp < dtNow.unixtime()) { // Count Up!
+    if (countupdownTimestamp < timeNow()) { // Count Up!
       seconds = seconds * -1; // needs to be further in the past if in countup mode
     }
     countupdownTimestamp += seconds;
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markRuntimeDirty();
+    sendState(request);
   });
 
-  server.on("/remove_seconds", HTTP_POST, [](AsyncWebServerRequest *request){
+  onRoute("/remove_seconds", HTTP_POST, [](AsyncWebServerRequest *request){
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /remove_seconds"));
 #endif
@@ -1192,45 +2935,23 @@ void setupWebServer() {
       request->send(400, "application/json", "{\"error\":\"Missing value\"}");
       return;
     }
-    DateTime dtNow;
-    if (rtcEnabled) {
-      dtNow = rtc.now();
-    } else {
-      dtNow = DateTime(time(nullptr));
-    }
     int seconds = request->getParam("seconds", true)->value().toInt();
-    if (countupdownTimestamp < dtNow.unixtime()) { // Count Up!
+    if (countupdownTimestamp < timeNow()) { // Count Up!
       seconds = seconds * -1; // needs to be closer to today if in countup
     }
     countupdownTimestamp -= seconds;
-    String msg = saveConfig();
-    if (msg.length() > 0) {
-      request->send(500, "application/json", msg);
-      return;
-    }
-    JsonDocument okDoc;
-    okDoc[F("brightness")] = brightness;
-    okDoc[F("flipDisplay")] = flipDisplay;
-    okDoc[F("twelveHour")] = twelveHour;
-    okDoc[F("lockCountUpDown")] = lockCountUpDown;
-    okDoc[F("countupdownTimestamp")] = countupdownTimestamp;
-    String response;
-    serializeJson(okDoc, response);
-    request->send(200, "application/json", response);
+    markRuntimeDirty();
+    sendState(request);
   });
 
-  server.on("/get_time", HTTP_GET, [](AsyncWebServerRequest *request){
+  onRoute("/api/batch", HTTP_POST, batchRequest, batchBody);
+
+  onRoute("/get_time", HTTP_GET, [](AsyncWebServerRequest *request){
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /get_time"));
 #endif
-    DateTime dtNow;
-    if (rtcEnabled) {
-      dtNow = rtc.now();
-    } else {
-      dtNow = DateTime(time(nullptr));
-    }
     // Convert from UTC to Local
-    time_t nowTime = dtNow.unixtime();
+    time_t nowTime = timeNow();
     struct tm timeInfo;
     localtime_r(&nowTime, &timeInfo);
     char dateTimeJson[48];
@@ -1238,57 +2959,66 @@ void setupWebServer() {
     request->send(200, "application/json", dateTimeJson);
   });
 
-  server.on("/set_time", HTTP_POST, [](AsyncWebServerRequest *request) {
+  // Either DateTime (local "YYYY-MM-DD HH:MM:SS[.mmm]") or epochMs, the
+  // client's UTC in milliseconds when it sent the request. delayMs, the
+  // client's estimate of the one way network delay (half a measured round
+  // trip), is added to either.
+  onRoute("/set_time", HTTP_POST, [](AsyncWebServerRequest *request) {
+    int64_t receivedMonoUs = monoMicros();
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /set_time"));
 #endif
-    Serial.println(request->params());
-    if (!request->hasParam("DateTime", true)) {
-      request->send(400, "application/json", "{\"error\":\"Missing value\"}");
-      return;
-    }
-    String DateTimeStr = request->getParam("DateTime", true)->value();
-    if (DateTimeStr.length() >= 19) {
-      int year = DateTimeStr.substring(0, 4).toInt();
-      int month = DateTimeStr.substring(5, 7).toInt();
-      int day = DateTimeStr.substring(8, 10).toInt();
-      int hour = DateTimeStr.substring(11, 13).toInt();
-      int minute = DateTimeStr.substring(14, 16).toInt();
-      int second = DateTimeStr.substring(17, 19).toInt();
-      int millisec = 0;
-      if (DateTimeStr.length() >= 23) {
-        millisec = DateTimeStr.substring(20,23).toInt();
+    int64_t newTimeUs = -1;
+    if (request->hasParam("epochMs", true)) {
+      int64_t epochMs = atoll(request->getParam("epochMs", true)->value().c_str());
+      if (epochMs > 0) {
+        newTimeUs = epochMs * 1000;
       }
+    } else if (request->hasParam("DateTime", true)) {
+      String DateTimeStr = request->getParam("DateTime", true)->value();
+      if (DateTimeStr.length() >= 19) {
+        int year = DateTimeStr.substring(0, 4).toInt();
+        int month = DateTimeStr.substring(5, 7).toInt();
+        int day = DateTimeStr.substring(8, 10).toInt();
+        int hour = DateTimeStr.substring(11, 13).toInt();
+        int minute = DateTimeStr.substring(14, 16).toInt();
+        int second = DateTimeStr.substring(17, 19).toInt();
+        int millisec = 0;
+        if (DateTimeStr.length() >= 23) {
+          millisec = DateTimeStr.substring(20,23).toInt();
+        }
 
-      struct tm tm;
-      tm.tm_year = year - 1900;
-      tm.tm_mon = month - 1;
-      tm.tm_mday = day;
-      tm.tm_hour = hour;
-      tm.tm_min = minute;
-      tm.tm_sec = second;
-      tm.tm_isdst = -1;
-
-      time_t newTime = mktime(&tm);
-      if (newTime != (time_t)-1) {
-        struct timeval newNow = {.tv_sec = newTime, .tv_usec = millisec*1000};
-        settimeofday(&newNow, NULL);
-        if (rtcEnabled) {
-          time_t nowTime = time(nullptr);
-          struct tm timeInfo;
-          gmtime_r(&nowTime, &timeInfo);
-          rtc.adjust(DateTime(timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec));
+        struct tm tm;
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+
+        time_t newTime = mktime(&tm);
+        if (newTime != (time_t)-1) {
+          newTimeUs = (int64_t)newTime * 1000000 + millisec * 1000;
         }
       }
-    }
-    DateTime dtNow;
-    if (rtcEnabled) {
-      dtNow = rtc.now();
     } else {
-      dtNow = DateTime(time(nullptr));
+      request->send(400, "application/json", "{\"error\":\"Missing value\"}");
+      return;
+    }
+    if (newTimeUs > 0) {
+      if (request->hasParam("delayMs", true)) {
+        int32_t delayMs = request->getParam("delayMs", true)->value().toInt();
+        if (delayMs > 0 && delayMs < 10000) {
+          newTimeUs += (int64_t)delayMs * 1000;
+        }
+      }
+      syncTime(receivedMonoUs, newTimeUs, TIME_SOURCE_MANUAL, TIME_STRATUM_MANUAL);
+      driftReset();
+      scheduleRTCWrite();
     }
     // Convert from UTC to Local
-    time_t nowTime = dtNow.unixtime();
+    time_t nowTime = timeNow();
     struct tm timeInfo;
     localtime_r(&nowTime, &timeInfo);
     char dateTimeJson[48];
@@ -1296,16 +3026,104 @@ void setupWebServer() {
     request->send(200, "application/json", dateTimeJson);
   });
 
-  server.on("/ntp_sync", HTTP_GET, [](AsyncWebServerRequest *request) {
+  onRoute("/stats", HTTP_GET, [](AsyncWebServerRequest *request) {
+#if DEBUG==true
+    Serial.println(F("[WEBSERVER] Request: /stats"));
+#endif
+    TimeSource time = timeState();
+    char statsJson[896];
+    snprintf(statsJson, sizeof(statsJson), "{\"framesRendered\":%lu,\"framesSkipped\":%lu,\"modulesWritten\":%lu,\"modulesSkipped\":%lu,"
+             "\"tickLatencyUs\":%lu,\"tickLatencyMaxUs\":%lu,\"ticksMissed\":%lu,\"rtcReads\":%lu,\"i2cTransactions\":%lu,\"rtcPhaseErrorUs\":%ld,\"rtcWrites\":%lu,\"rtcWriteLatencyUs\":%ld,"
+             "\"timeSource\":\"%s\",\"stratum\":%u,\"timeOffsetUs\":%ld,\"timeSteps\":%lu,\"timeSlews\":%lu,\"tzRebuilds\":%lu,\"configWrites\":%lu,\"configCoalesced\":%lu,\"configWriteErrors\":%lu,\"configJsonBuilds\":%lu,\"configJsonNotModified\":%lu,"
+             "\"sseClients\":%u,\"sseEvents\":%lu,\"sseHeld\":%lu,\"sseRejected\":%lu,\"stateCopies\":%lu}",
+             (unsigned long)framesRendered, (unsigned long)framesSkipped, (unsigned long)modulesWritten, (unsigned long)modulesSkipped,
+             (unsigned long)tickLatencyUs, (unsigned long)tickLatencyMaxUs, (unsigned long)ticksMissed,
+             (unsigned long)rtcReads, (unsigned long)i2cTransactions, (long)rtcPhaseErrorUs, (unsigned long)rtcWrites, (long)rtcWriteLatencyUs,
+             timeSourceName(time.source), time.stratum, (long)time.lastOffsetUs,
+             (unsigned long)time.steps, (unsigned long)time.slews, (unsigned long)localZone.rebuilds,
+             (unsigned long)configWrites, (unsigned long)configCoalesced, (unsigned long)configWriteErrors,
+             (unsigned long)configJsonBuilds, (unsigned long)configJsonNotModified,
+             (unsigned)events.count(), (unsigned long)sseEvents, (unsigned long)sseHeld, (unsigned long)sseRejected,
+             (unsigned long)stateCopies);
+    request->send(200, "application/json", statsJson);
+  });
+
+  onRoute("/ntp_status", HTTP_GET, [](AsyncWebServerRequest *request) {
+#if DEBUG==true
+    Serial.println(F("[WEBSERVER] Request: /ntp_status"));
+#endif
+    char ntpJson[320];
+    snprintf(ntpJson, sizeof(ntpJson), "{\"state\":\"%s\",\"server\":\"%s\",\"offsetUs\":%lld,\"delayUs\":%lu,\"stratum\":%u,\"samples\":%u,\"timestamp\":%lld,\"kisses\":%lu}",
+             ntpState == NTP_SYNCING ? "syncing" : ntpState == NTP_SUCCESS ? "success" : ntpState == NTP_FAILED ? "failed" : "idle",
+             ntpLastResult.server, (long long)ntpLastResult.offsetUs, (unsigned long)ntpLastResult.delayUs,
+             ntpLastResult.stratum, ntpLastResult.samples, (long long)ntpLastResult.timestamp, (unsigned long)ntpKisses);
+    request->send(200, "application/json", ntpJson);
+  });
+
+  onRoute("/wear", HTTP_GET, [](AsyncWebServerRequest *request) {
+#if DEBUG==true
+    Serial.println(F("[WEBSERVER] Request: /wear"));
+#endif
+    uint32_t uptimeS = flashWearUptime();
+    size_t fsBytes = flashFsBytes();
+    double days = uptimeS / 86400.0;
+    // No erases yet, no rate to project a lifetime from.
+    double lifetimeDays = flashWearLifetimeDays(&flashWear, uptimeS, fsBytes);
+    char lifetimeYears[16] = "null";
+    if (lifetimeDays > 0) {
+      snprintf(lifetimeYears, sizeof(lifetimeYears), "%.1f", lifetimeDays / 365.25);
+    }
+    char wearJson[384];
+    snprintf(wearJson, sizeof(wearJson), "{\"logicalBytes\":%llu,\"physicalBytes\":%llu,\"erases\":%lu,\"files\":%u,\"sessions\":%lu,\"commits\":%lu,"
+             "\"uptimeS\":%lu,\"logicalBytesPerDay\":%.0f,\"physicalBytesPerDay\":%.0f,\"erasesPerDay\":%.1f,\"fsBytes\":%lu,\"lifetimeYears\":%s}",
+             (unsigned long long)flashWear.logicalBytes, (unsigned long long)flashWear.physicalBytes,
+             (unsigned long)flashWear.erases, flashWearFiles(&flashWear), (unsigned long)flashWear.sessions, (unsigned long)flashWear.commits,
+             (unsigned long)uptimeS,
+             days > 0 ? flashWear.logicalBytes / days : 0, days > 0 ? flashWear.physicalBytes / days : 0, days > 0 ? flashWear.erases / days : 0,
+             (unsigned long)fsBytes, lifetimeYears);
+    request->send(200, "application/json", wearJson);
+  });
+
+  onRoute("/drift", HTTP_GET, [](AsyncWebServerRequest *request) {
+#if DEBUG==true
+    Serial.println(F("[WEBSERVER] Request: /drift"));
+#endif
+    char driftJson[640];
+    int len = snprintf(driftJson, sizeof(driftJson), "{\"ppm\":%.3f,\"corrections\":%lu,\"agingOffset\":%d,\"clockRatePpb\":%ld,\"history\":[",
+                       driftPpm, (unsigned long)driftCorrections, rtcAgingOffset, (long)clockRatePpb);
+    for (uint8_t i = 0; i < driftCount && len < (int)sizeof(driftJson); i++) {
+      const DriftPoint &point = driftHistory[(driftNext + DRIFT_HISTORY - driftCount + i) % DRIFT_HISTORY];
+      len += snprintf(driftJson + len, sizeof(driftJson) - len, "%s{\"time\":%lld,\"intervalS\":%ld,\"offsetUs\":%ld}",
+                      i == 0 ? "" : ",", (long long)point.utc, (long)point.intervalS, (long)point.offsetUs);
+    }
+    if (len < (int)sizeof(driftJson)) {
+      snprintf(driftJson + len, sizeof(driftJson) - len, "]}");
+    }
+    request->send(200, "application/json", driftJson);
+  });
+
+  onRoute("/ntp_sync", HTTP_GET, [](AsyncWebServerRequest *request) {
 #if DEBUG==true
     Serial.println(F("[WEBSERVER] Request: /ntp_sync"));
 #endif
     if (ntpState == NTP_IDLE || ntpState == NTP_SUCCESS) {
-      startNTPSync(true);
+      startNTPSync();
     }
     request->send(200, "application/json", "{\"ok\":true}");
   });
 
+  onRoute("/metrics", HTTP_GET, sendMetrics);
+#if TRACE==true
+  server.on("/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *out = request->beginResponseStream("application/json");
+    traceDump(*out);
+    request->send(out);
+  });
+#endif
+
+  events.onConnect(sseConnect);
+  server.addHandler(&events);
+
   server.begin();
 #if DEBUG==true
   Serial.println(F("[WEBSERVER] Web server started"));
@@ -1319,6 +3137,15 @@ void setup() {
   Serial.begin(115200);
   delay(500);
   startMillis = millis();
+#if ESPVERS == 32
+  settingsBootId = esp_random();
+#endif
+#if ESPVERS == 8266
+  settingsBootId = RANDOM_REG32;
+#endif
+  TIME_SOURCE_LOCK();
+  timeSourceInit(&timeSource);
+  TIME_SOURCE_UNLOCK();
 #if DEBUG==true
   Serial.println(F("[SETUP] Starting setup..."));
 #endif
@@ -1334,10 +3161,18 @@ void setup() {
     Serial.println(F("[SETUP] RTC found."));
 #endif
     rtcEnabled = true;
+    TimeSourceKind source = TIME_SOURCE_RTC;
     if (rtc.lostPower()) {
       // Set time if new device or after a power loss.
       rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+      source = TIME_SOURCE_BUILD;
     }
+    syncTimeFromRTC(source);
+#ifdef SQW_PIN
+    rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+    pinMode(SQW_PIN, INPUT_PULLUP); // SQW is open drain
+    attachInterrupt(digitalPinToInterrupt(SQW_PIN), rtcSqwISR, FALLING);
+#endif
   }
 
 #if ESPVERS == 8266
@@ -1358,13 +3193,18 @@ void setup() {
 #endif
 
   P.begin();  // Initialize Parola library
-  P.setCharSpacing(1);
-  P.setFont(mFactory);
+  mx = P.getGraphicObject();
+  mx->control(MD_MAX72XX::UPDATE, MD_MAX72XX::OFF); // pushFrame() flushes explicitly
+  buildFontIndex();
   loadConfig();  // This function now has internal yields and prints
+  journalLoad();
 
   P.setIntensity(brightness);
-  P.setZoneEffect(0, flipDisplay, PA_FLIP_UD);
-  P.setZoneEffect(0, flipDisplay, PA_FLIP_LR);
+  if (rtcEnabled) {
+    rtcAgingOffset = readAgingOffset();
+  } else {
+    timeSetRate(clockRatePpb);
+  }
 #if DEBUG==true
   Serial.println(F("[SETUP] Parola (LED Matrix) initialized"));
 #endif
@@ -1378,17 +3218,76 @@ void setup() {
   Serial.println(F("[SETUP] Setup complete"));
 #endif
   printConfigToSerial();
-  lastColonBlink = millis();
 }
 
+// The loop histogram is the work of an iteration: waiting for the next edge
+// would otherwise fill its top buckets with the sleep and hide the work.
 void loop() {
+  loopWaitUs = 0;
+  uint32_t start = micros();
+  runLoop();
+  metricsRecord(&metricsLoop, micros() - start - loopWaitUs);
+}
+
+void runLoop() {
   uint32_t curMillis = millis();
   runtime = curMillis - startMillis;
   if (runtime / 300000 > lastLogTime) {
     lastLogTime = runtime / 300000;
-    saveConfig();
+    logRuntime(logIndex, runtime);
+    uptimeUnjournaled = true;
+    // Hourly it is journaled, the wear counters along in the same write.
+    if (lastLogTime % 12 == 0) {
+      JournalEntry entries[1 + flashWearEntryCount] = {{JOURNAL_UPTIME, (uint8_t)logIndex, runtime}};
+      uint8_t count = 1 + flashWearEntries(entries + 1);
+      uptimeUnjournaled = false;
+      journalAppend(entries, count);
+    }
+  }
+  if (runtimeDirty && curMillis - runtimeDirtySince >= configWriteDelay) {
+    runtimeDirty = false;
+    JournalEntry entries[2] = {{JOURNAL_COUNTUPDOWN, 0, countupdownTimestamp}};
+    uint8_t count = 1;
+    if (uptimeUnjournaled) {
+      entries[count++] = {JOURNAL_UPTIME, (uint8_t)logIndex, logRuntimeMs[logIndex]};
+      uptimeUnjournaled = false;
+    }
+    journalAppend(entries, count);
+  }
+  // --- Config Writer ---
+  if (configDirty && curMillis - configDirtySince >= configWriteDelay) {
+    flushConfig();
   }
+  // Nothing is flushed after a restore: a change made since would be
+  // saved over the restored settings.
+  bool restored = false;
+  if (restoreRequested) {
+    restoreRequested = false;
+    restored = restoreConfig();
+    restartRequested = true;
+  }
+  if (restartRequested) {
+    if (!restored) {
+      flushConfig();
+    }
+    logRuntime(logIndex, runtime);
+    JournalEntry entries[2 + flashWearEntryCount] = {{JOURNAL_UPTIME, (uint8_t)logIndex, runtime}};
+    uint8_t count = 1;
+    if (runtimeDirty) {
+      entries[count++] = {JOURNAL_COUNTUPDOWN, 0, countupdownTimestamp};
+    }
+    count += flashWearEntries(entries + count);
+    journalAppend(entries, count);
+    ESP.restart();
+  }
+#if TRACE==true
+  if (Serial.available() && Serial.read() == 't') {
+    traceDump(Serial);
+  }
+#endif
   // --- WiFi Connection State Machine ---
+  uint32_t stageStart = micros();
+  uint32_t otaUs = 0;
   switch (wifiState) {
     // Attempting to connect still.
     case WIFI_SCAN_FINISHED:
@@ -1469,47 +3368,59 @@ outer_break:
 #endif
         connectWiFi();
       }
-    default:
+    default: {
       // --- ElegantOTA ---
       // Only try to run if we're connected or in AP mode.
+      uint32_t otaStart = micros();
       ElegantOTA.loop();
+      otaUs = micros() - otaStart;
+      metricsRecord(&metricsOta, otaUs);
       break;
+    }
   }
+  metricsRecord(&metricsWifi, micros() - stageStart - otaUs);
 
   // --- NTP State Machine ---
+  stageStart = micros();
   if (wifiState == WIFI_CONNECTED) {
     switch (ntpState) {
       case NTP_SUCCESS:
       case NTP_IDLE: {
-          // If RTC doesn't work, attempt to refresh NTP sync every hour.
-          if (!rtcEnabled  && (ntpLastTime == 0 || curMillis > ntpLastTime + ntpRefreshTime)) {
-            startNTPSync(false);
+          // Refresh every hour without an RTC, less often with one (to track its drift).
+          uint32_t refreshTime = rtcEnabled ? ntpRtcRefreshTime : ntpRefreshTime;
+          if (ntpLastTime == 0 || curMillis > ntpLastTime + refreshTime) {
+            startNTPSync();
           }
         }
         break;
       case NTP_SYNCING: {
-          time_t lNow = time(nullptr);
-          if (lNow > 1000) {  // NTP sync successful
+          int result = ntpPoll(curMillis);
+          if (result > 0) {  // NTP sync successful
+            ntpState = NTP_SUCCESS;
+            ntpLastResult.offsetUs = ntpBest.offsetUs;
+            ntpLastResult.delayUs = ntpBest.delayUs;
+            ntpLastResult.stratum = ntpBest.stratum;
+            ntpLastResult.samples = ntpSamples;
+            ntpLastResult.timestamp = (ntpBestUtcUs + ntpBest.offsetUs) / 1000000;
+            strlcpy(ntpLastResult.server, ntpBestServerIx == 0 ? ntpServer1 : ntpServer2, sizeof(ntpLastResult.server));
   #if DEBUG==true
-            Serial.println(F("[TIME] NTP sync successful."));
+            Serial.printf("[TIME] NTP sync successful: %s offset %lld us, delay %lu us (%u samples)\n",
+                          ntpLastResult.server, (long long)ntpLastResult.offsetUs, (unsigned long)ntpLastResult.delayUs, ntpSamples);
   #endif
-            ntpState = NTP_SUCCESS;
-            setTimeZone(timeZone);
+            driftRecord(ntpLastResult.timestamp, ntpBest.offsetUs);
+            syncTime(ntpBestMonoUs, ntpBestUtcUs + ntpBest.offsetUs, TIME_SOURCE_NTP, ntpBest.stratum + 1);
             if (rtcEnabled) {
   #if DEBUG==true
               Serial.println(F("[TIME] Adjusting RTC clock."));
   #endif
-              time_t nowTime = time(nullptr);
-              struct tm timeInfo;
-              gmtime_r(&nowTime, &timeInfo);
-              rtc.adjust(DateTime(timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec));
+              scheduleRTCWrite();
             }
-          } else if (curMillis - ntpLastTime > ntpTimeout && ntpRetryCount < maxNtpRetries) {
+          } else if (result < 0 && ntpRetryCount < maxNtpRetries) {
   #if DEBUG==true
             Serial.println(F("[TIME] NTP sync failed."));
   #endif
             ntpState = NTP_FAILED;
-          } else if (ntpRetryCount >= maxNtpRetries) {
+          } else if (result < 0) {
             ntpState = NTP_IDLE;
           }
         }
@@ -1518,69 +3429,54 @@ outer_break:
   #if DEBUG==true
           Serial.println(F("[TIME] Retrying NTP sync..."));
   #endif
-          startNTPSync(false, ntpRetryCount);
+          startNTPSync(ntpRetryCount);
         }
         break;
     }
   }
 
-  // Colon is visible for 800 ms then not for 800 ms
-  if (curMillis - lastColonBlink > COLON_BLINK_INTERVAL) {
-    colonVisible = !colonVisible;
-    lastColonBlink = millis();
+  metricsRecord(&metricsNtp, micros() - stageStart);
+
+  // --- RTC Discipline ---
+  // Not while a write is pending, the RTC is about to be overwritten.
+  stageStart = micros();
+  if (rtcEnabled && ntpState != NTP_SYNCING && !rtcWritePending) {
+    disciplineFromRTC(curMillis);
   }
 
-  // Create DateTime object and set it via RTC or via (maybe) ntp synced clock.
-  DateTime dtNow;
-  if (rtcEnabled) { // RTC stores UTC time.
-    dtNow = rtc.now();
-  } else {
-    dtNow = DateTime(time(nullptr));
+  metricsRecord(&metricsRtc, micros() - stageStart);
+
+  // --- System Clock ---
+  if (curMillis - systemClockLastSet >= systemClockInterval) {
+    setSystemClock();
   }
-  char timeWithSeconds[24];
-  // --- COUNTUPDOWN Display Mode ---
-  if (countupdownTimestamp > 0) {
-    long timeSeconds = countupdownTimestamp - dtNow.unixtime();
-    if (timeSeconds < 0) {
-      timeSeconds = timeSeconds * -1;
-    }
 
-    if (timeSeconds < 1296000) { // less than 15 days
-      // Format the full string
-      if (colonVisible) {
-        snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%ld:%02ld:%02ld", timeSeconds / 3600, (timeSeconds % 3600) / 60, timeSeconds % 60);
-      } else {
-        snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%ld %02ld %02ld", timeSeconds / 3600, (timeSeconds % 3600) / 60, timeSeconds % 60);
-      }
-    } else if (timeSeconds < 31557600) { // less than 365.25 days / 1 year-ish
-      // display days-hours:minutes
-      if (colonVisible) {
-        snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%ld+%02ld:%02ld", timeSeconds / 86400, (timeSeconds % 86400) / 3600, (timeSeconds % 3600) / 60);
-      } else {
-        snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%ld^%02ld %02ld", timeSeconds / 86400, (timeSeconds % 86400) / 3600, (timeSeconds % 3600) / 60);
-      }
-    } else {
-      if (colonVisible) {
-        snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%ld+%ld", timeSeconds / 31557600, (timeSeconds % 31557600) / 86400);
-      } else {
-        snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%ld^%ld", timeSeconds / 31557600, (timeSeconds % 31557600) / 86400);
-      }
-    }
-  }  // End COUNTUPDOWN Display Mode
-  // --- CLOCK Display Mode ---
-  else {
-    // Convert UTC to local.
-    struct tm tm;
-    time_t utcStamp = dtNow.unixtime();
-    localtime_r(&utcStamp, &tm);
-    if (twelveHour) {
-      uint8_t hour = tm.tm_hour % 12;
-      snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%d:%02d:%02d", hour == 0 ? 12 : hour, tm.tm_min, tm.tm_sec);
-    } else {
-      snprintf(timeWithSeconds, sizeof(timeWithSeconds), "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
-    }
-  } // End CLOCK Display Mode
-  P.setTextAlignment(PA_CENTER);
-  P.print(timeWithSeconds);
+  // --- Display Tick ---
+  // Everything below only runs on a half second edge.
+  if (!waitForTick()) {
+    return;
+  }
+  TRACE_SCOPE("tick");
+  // Colon is visible for the first half of every second.
+  colonVisible = tickEdgeUs % 1000000 == 0;
+  if (rtcWritePending && colonVisible && timeSlewRemaining(monoMicros()) == 0) {
+    writeRTCAtEdge();
+  }
+
+  // The system clock is UTC, NTP synced and/or disciplined from the RTC.
+  stageStart = micros();
+  int64_t tickSecond = tickEdgeUs / 1000000;
+  char timeWithSeconds[24];
+  // Count up/down while a target is set, otherwise the time of day.
+  formatDisplay(&displayCounters, &localZone, tickSecond, countupdownTimestamp, twelveHour, colonVisible, timeWithSeconds);
+  renderFrame(timeWithSeconds);
+  metricsRecord(&metricsRender, micros() - stageStart);
+  tickLatencyUs = timeNowUs() - tickEdgeUs;
+  if (tickLatencyUs > tickLatencyMaxUs) {
+    tickLatencyMaxUs = tickLatencyUs;
+  }
+  if (colonVisible) {
+    ssePush(tickSecond);
+  }
   yield();
 }
\ No newline at end of file
@@ -0,0 +1,447 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// The Arduino core for the native env: the parts of the ESP32 core the
+// firmware and its libraries use, running on the virtual clock of
+// sim_board.h. Serial output is dropped unless SIM_SERIAL is set.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <string>
+#include "sim_board.h"
+
+using std::max;
+using std::min;
+
+// ArduinoJson reads PROGMEM through pgm_read_ptr(), which has no meaning here.
+#define ARDUINOJSON_ENABLE_PROGMEM 0
+
+#define PROGMEM
+#define PSTR(s)             (s)
+#define F(s)                (s)
+#define IRAM_ATTR
+#define pgm_read_byte(p)    (*(const uint8_t *)(p))
+#define pgm_read_word(p)    (*(const uint16_t *)(p))
+#define pgm_read_dword(p)   (*(const uint32_t *)(p))
+#define memcpy_P            memcpy
+#define strcmp_P            strcmp
+#define strcpy_P            strcpy
+#define strlen_P            strlen
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define DEC 10
+#define HEX 16
+#define LOW     0
+#define HIGH    1
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+#define digitalPinToInterrupt(p) (p)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// glibc has them from 2.38
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+inline size_t strlcat(char *dst, const char *src, size_t size) {
+    size_t used = strnlen(dst, size);
+    return used + strlcpy(dst + used, src, size - used);
+}
+#endif
+
+// --- Time, on the virtual clock ---
+inline unsigned long millis() { return (unsigned long)(uint32_t)(simReadClock() / 1000); }
+inline unsigned long micros() { return (unsigned long)(uint32_t)simReadClock(); }
+inline uint64_t micros64() { return (uint64_t)simReadClock(); }
+inline void delay(uint32_t ms) { simSleep((int64_t)ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { simAdvance(us); }
+inline void yield() { simYield(); }
+
+// newlib's clock. settimeofday() would set the host's, so the board keeps
+// it instead, running on the ESP timer from where it was set.
+inline int simSetTimeOfDay(const struct timeval *tv, const void *) {
+    SimBoard *b = simBoard();
+    b->systemClockUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    b->systemClockSetUs = b->monoUs;
+    b->systemClockSets++;
+    return 0;
+}
+#define settimeofday simSetTimeOfDay
+
+inline int64_t simSystemClockUs() {
+    SimBoard *b = simBoard();
+    return b->systemClockUs + (b->monoUs - b->systemClockSetUs);
+}
+
+inline uint32_t esp_random() {
+    static uint32_t state = 0x9E3779B9;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+inline long random(long high) { return high > 0 ? (long)(esp_random() % (uint32_t)high) : 0; }
+inline long random(long low, long high) { return low + random(high - low); }
+// FreeRTOS tasks: the loop's, unless a test poses as another one through
+// simCurrentTask.
+struct tskTaskControlBlock {
+    const char *name;
+    int         core;  // Where it runs right now
+};
+typedef tskTaskControlBlock *TaskHandle_t;
+inline tskTaskControlBlock simLoopTask = {"loopTask", 1};
+inline TaskHandle_t simCurrentTask = &simLoopTask;
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return simCurrentTask; }
+inline char *pcTaskGetName(TaskHandle_t task) { return (char *)(task ? task : simCurrentTask)->name; }
+inline int xPortGetCoreID() { return simCurrentTask->core; }
+
+// FreeRTOS critical sections. The simulated firmware is single threaded, so
+// they only check that entries and exits pair up.
+typedef struct {
+    int32_t depth;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+inline void portENTER_CRITICAL(portMUX_TYPE *mux) { mux->depth++; }
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) {
+    if (--mux->depth < 0) {
+        abort();
+    }
+}
+
+// --- GPIO, only the SQW interrupt is wired ---
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int) {
+    if ((int32_t)pin == simBoard()->rtcSqwPin) {
+        simSqwIsr() = isr;
+    }
+}
+inline void detachInterrupt(uint8_t pin) {
+    if ((int32_t)pin == simBoard()->rtcSqwPin) {
+        simSqwIsr() = nullptr;
+    }
+}
+
+// --- String ---
+class String {
+public:
+    String() {}
+    String(const char *s) { if (s) s_ = s; }
+    String(const char *s, size_t n) : s_(s, n) {}
+    String(const String &other) = default;
+    String(String &&other) = default;
+    explicit String(char c) : s_(1, c) {}
+    explicit String(int n, unsigned char base = 10) { fromNumber(n < 0, n < 0 ? 0ULL - (unsigned long long)n : n, base); }
+    explicit String(unsigned int n, unsigned char base = 10) { fromNumber(false, n, base); }
+    explicit String(long n, unsigned char base = 10) { fromNumber(n < 0, n < 0 ? 0ULL - (unsigned long long)n : n, base); }
+    explicit String(unsigned long n, unsigned char base = 10) { fromNumber(false, n, base); }
+    explicit String(long long n, unsigned char base = 10) { fromNumber(n < 0, n < 0 ? 0ULL - (unsigned long long)n : n, base); }
+    explicit String(unsigned long long n, unsigned char base = 10) { fromNumber(false, n, base); }
+    explicit String(double n, unsigned int digits = 2) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", digits, n);
+        s_ = buf;
+    }
+
+    String &operator=(const String &other) = default;
+    String &operator=(String &&other) = default;
+    String &operator=(const char *s) {
+        if (s) s_ = s; else s_.clear();
+        return *this;
+    }
+
+    const char *c_str() const { return s_.c_str(); }
+    size_t length() const { return s_.size(); }
+    bool isEmpty() const { return s_.empty(); }
+    bool reserve(size_t size) { s_.reserve(size); return true; }
+
+    bool concat(const String &s) { s_ += s.s_; return true; }
+    bool concat(const char *s) { if (!s) return false; s_ += s; return true; }
+    bool concat(const char *s, size_t n) { if (!s) return false; s_.append(s, n); return true; }
+    bool concat(char c) { s_ += c; return true; }
+    bool concat(int n) { return concat(String(n)); }
+    bool concat(unsigned int n) { return concat(String(n)); }
+    bool concat(long n) { return concat(String(n)); }
+    bool concat(unsigned long n) { return concat(String(n)); }
+    bool concat(long long n) { return concat(String(n)); }
+    bool concat(unsigned long long n) { return concat(String(n)); }
+    bool concat(double n) { return concat(String(n)); }
+    template <typename T>
+    String &operator+=(const T &v) { concat(v); return *this; }
+
+    bool equals(const String &s) const { return s_ == s.s_; }
+    bool equals(const char *s) const { return s_ == (s ? s : ""); }
+    bool operator==(const String &s) const { return equals(s); }
+    bool operator==(const char *s) const { return equals(s); }
+    bool operator!=(const String &s) const { return !equals(s); }
+    bool operator!=(const char *s) const { return !equals(s); }
+    bool operator<(const String &s) const { return s_ < s.s_; }
+
+    char charAt(size_t i) const { return i < s_.size() ? s_[i] : 0; }
+    char operator[](size_t i) const { return charAt(i); }
+    int indexOf(char c, size_t from = 0) const {
+        size_t i = s_.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int indexOf(const char *s, size_t from = 0) const {
+        size_t i = s_.find(s, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    bool startsWith(const char *s) const { return s_.compare(0, strlen(s), s) == 0; }
+    bool endsWith(const char *s) const {
+        size_t n = strlen(s);
+        return n <= s_.size() && s_.compare(s_.size() - n, n, s) == 0;
+    }
+    String substring(size_t from) const { return substring(from, s_.size()); }
+    String substring(size_t from, size_t to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= s_.size()) return String();
+        return String(s_.c_str() + from, std::min(to, s_.size()) - from);
+    }
+    long toInt() const { return atol(s_.c_str()); }
+    float toFloat() const { return (float)atof(s_.c_str()); }
+    void trim() {
+        size_t b = s_.find_first_not_of(" \t\r\n");
+        size_t e = s_.find_last_not_of(" \t\r\n");
+        s_ = b == std::string::npos ? std::string() : s_.substr(b, e - b + 1);
+    }
+    void toLowerCase() { for (char &c : s_) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (char &c : s_) c = toupper((unsigned char)c); }
+
+private:
+    void fromNumber(bool negative, unsigned long long n, unsigned char base) {
+        char buf[66];
+        char *p = buf + sizeof(buf);
+        *--p = '\0';
+        do {
+            int d = n % base;
+            *--p = d < 10 ? '0' + d : 'a' + d - 10;
+            n /= base;
+        } while (n);
+        if (negative) {
+            *--p = '-';
+        }
+        s_ = p;
+    }
+
+    std::string s_;
+};
+
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String &s) : String(s) {}
+    StringSumHelper(const char *s) : String(s) {}
+};
+
+template <typename T>
+inline StringSumHelper operator+(const StringSumHelper &lhs, const T &rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const String &lhs, const char *rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const String &lhs, const String &rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const char *lhs, const String &rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+// --- Print / Stream ---
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual void flush() {}
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (n < 0) {
+            return 0;
+        }
+        if ((size_t)n < sizeof(buf)) {
+            return write((const uint8_t *)buf, n);
+        }
+        char *big = (char *)malloc(n + 1);
+        va_start(args, format);
+        vsnprintf(big, n + 1, format, args);
+        va_end(args);
+        size_t written = write((const uint8_t *)big, n);
+        free(big);
+        return written;
+    }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(const Printable &p) { return p.printTo(*this); }
+    size_t print(long long n, int base = DEC) { return printNumber(n < 0, n < 0 ? 0ULL - (unsigned long long)n : n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return printNumber(false, n, base); }
+    size_t print(int n, int base = DEC) { return print((long long)n, base); }
+    size_t print(long n, int base = DEC) { return print((long long)n, base); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long long)n, base); }
+    size_t print(unsigned long n, int base = DEC) { return print((unsigned long long)n, base); }
+    size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+    template <typename T>
+    size_t println(const T &v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(const T &v, int format) { return print(v, format) + println(); }
+    size_t println() { return write((const uint8_t *)"\r\n", 2); }
+
+private:
+    size_t printNumber(bool negative, unsigned long long n, int base) {
+        char buf[66];
+        char *p = buf + sizeof(buf);
+        *--p = '\0';
+        do {
+            int d = n % base;
+            *--p = d < 10 ? '0' + d : 'A' + d - 10;
+            n /= base;
+        } while (n);
+        if (negative) {
+            *--p = '-';
+        }
+        return write(p);
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long) {}
+    virtual size_t readBytes(char *buffer, size_t length) {
+        size_t n = 0;
+        int c;
+        while (n < length && (c = read()) >= 0) {
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+};
+
+// --- IPAddress ---
+class IPAddress : public Printable {
+public:
+    IPAddress() : addr_(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr_((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    IPAddress(uint32_t addr) : addr_(addr) {}
+    operator uint32_t() const { return addr_; }
+    uint8_t operator[](int i) const { return (uint8_t)(addr_ >> (8 * i)); }
+    bool operator==(const IPAddress &o) const { return addr_ == o.addr_; }
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(buf);
+    }
+    size_t printTo(Print &p) const override { return p.print(toString().c_str()); }
+
+private:
+    uint32_t addr_;
+};
+
+// --- Serial ---
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    size_t write(uint8_t c) override {
+        if (simBoard()->serialEcho) {
+            fputc(c, stdout);
+        }
+        return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        if (simBoard()->serialEcho) {
+            fwrite(buffer, 1, size, stdout);
+        }
+        return size;
+    }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+// --- ESP ---
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getMinFreeHeap() { return 160000; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return (uint32_t)(simBoard()->monoUs * 240); }
+    // The firmware's process ends here; the simulator powers the board up
+    // again (see test/support/sim.h).
+    [[noreturn]] void restart() {
+        simBoard()->restarts++;
+        fflush(stdout);
+        _Exit(SIM_EXIT_RESTART);
+    }
+};
+
+inline EspClass ESP;
+
+#endif // ARDUINO_H
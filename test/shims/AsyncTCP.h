@@ -0,0 +1,6 @@
+#ifndef ASYNCTCP_H
+#define ASYNCTCP_H
+
+// Nothing to do: the ESPAsyncWebServer shim has no connections.
+
+#endif // ASYNCTCP_H
@@ -0,0 +1,24 @@
+#ifndef DNSSERVER_H
+#define DNSSERVER_H
+
+#include "Arduino.h"
+
+// The captive portal's DNS server, without clients asking it anything.
+class DNSServer {
+public:
+    bool start(const uint16_t &port, const String &domainName, const IPAddress &resolvedIP) {
+        (void)port;
+        (void)domainName;
+        (void)resolvedIP;
+        running_ = true;
+        return true;
+    }
+    void stop() { running_ = false; }
+    void processNextRequest() {}
+    bool running() const { return running_; }
+
+private:
+    bool running_ = false;
+};
+
+#endif // DNSSERVER_H
@@ -0,0 +1,489 @@
+#ifndef ESPASYNCWEBSERVER_H
+#define ESPASYNCWEBSERVER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Arduino.h"
+#include "sim_board.h"
+
+// ESPAsyncWebServer without sockets: a test hands a request to
+// server.simRequest(), which runs the matching handler right away (where
+// the real server runs it in the async_tcp task) and returns what was sent.
+// Responses allocate what the library's do, so the heap a route costs can
+// be measured: send() with a body copies it into a String, a response
+// given a buffer reads it when it goes out, after the handler returned.
+
+typedef enum {
+    HTTP_GET     = 0b00000001,
+    HTTP_POST    = 0b00000010,
+    HTTP_DELETE  = 0b00000100,
+    HTTP_PUT     = 0b00001000,
+    HTTP_PATCH   = 0b00010000,
+    HTTP_HEAD    = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY     = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+class AsyncEventSourceClient;
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<void(AsyncEventSourceClient *client)> ArEventHandlerFunction;
+
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String &name, const String &value) : name_(name), value_(value) {}
+    const String &name() const { return name_; }
+    const String &value() const { return value_; }
+
+private:
+    String name_;
+    String value_;
+};
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const String &name, const String &value, bool form) : name_(name), value_(value), form_(form) {}
+    const String &name() const { return name_; }
+    const String &value() const { return value_; }
+    size_t size() const { return value_.length(); }
+    bool isPost() const { return form_; }
+    bool isFile() const { return false; }
+
+private:
+    String name_;
+    String value_;
+    bool   form_;
+};
+
+// --- Responses ---
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(int code, const String &contentType) : code_(code), contentType_(contentType) {}
+    virtual ~AsyncWebServerResponse() {}
+    bool addHeader(const char *name, const char *value) {
+        headers_.emplace_back(String(name), String(value));
+        return true;
+    }
+    bool addHeader(const String &name, const String &value) { return addHeader(name.c_str(), value.c_str()); }
+    void setCode(int code) { code_ = code; }
+    int code() const { return code_; }
+    const String &contentType() const { return contentType_; }
+    const std::vector<AsyncWebHeader> &headers() const { return headers_; }
+    // What goes out on the connection, read when the response is sent.
+    virtual std::string body() const { return std::string(); }
+
+private:
+    int                         code_;
+    String                      contentType_;
+    std::vector<AsyncWebHeader> headers_;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+public:
+    AsyncBasicResponse(int code, const String &contentType = String(), const String &content = String())
+        : AsyncWebServerResponse(code, contentType), content_(content) {}
+    std::string body() const override { return std::string(content_.c_str(), content_.length()); }
+
+private:
+    String content_;
+};
+
+// A buffer the caller keeps alive until the response is sent.
+class AsyncProgmemResponse : public AsyncWebServerResponse {
+public:
+    AsyncProgmemResponse(int code, const String &contentType, const uint8_t *content, size_t len)
+        : AsyncWebServerResponse(code, contentType), content_(content), len_(len) {}
+    std::string body() const override { return std::string((const char *)content_, len_); }
+
+private:
+    const uint8_t *content_;
+    size_t         len_;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+    AsyncResponseStream(const String &contentType) : AsyncWebServerResponse(200, contentType) {}
+    size_t write(uint8_t c) override {
+        content_.push_back((char)c);
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t len) override {
+        content_.append((const char *)data, len);
+        return len;
+    }
+    using Print::write;
+    std::string body() const override { return content_; }
+
+private:
+    std::string content_;
+};
+
+// What a simulated request got back.
+struct SimHttpResponse {
+    int         code = 0;
+    std::string contentType;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    const char *header(const char *name) const {
+        for (const auto &h : headers) {
+            if (strcasecmp(h.first.c_str(), name) == 0) {
+                return h.second.c_str();
+            }
+        }
+        return nullptr;
+    }
+};
+
+// --- Requests ---
+class AsyncWebServerRequest {
+public:
+    AsyncWebServerRequest(WebRequestMethodComposite method, const String &url) : method_(method), url_(url) {}
+    ~AsyncWebServerRequest() {
+        if (_tempObject) {
+            free(_tempObject);
+        }
+    }
+
+    void *_tempObject = nullptr;
+
+    WebRequestMethodComposite method() const { return method_; }
+    const String &url() const { return url_; }
+    size_t contentLength() const { return contentLength_; }
+
+    size_t params() const { return params_.size(); }
+    const AsyncWebParameter *getParam(size_t i) const { return i < params_.size() ? &params_[i] : nullptr; }
+    const AsyncWebParameter *getParam(const char *name, bool post = false, bool file = false) const {
+        (void)file;
+        for (const AsyncWebParameter &p : params_) {
+            if (p.isPost() == post && p.name() == name) {
+                return &p;
+            }
+        }
+        return nullptr;
+    }
+    const AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const { return getParam(name.c_str(), post, file); }
+    bool hasParam(const char *name, bool post = false, bool file = false) const { return getParam(name, post, file) != nullptr; }
+    bool hasParam(const String &name, bool post = false, bool file = false) const { return hasParam(name.c_str(), post, file); }
+
+    const AsyncWebHeader *getHeader(const char *name) const {
+        for (const AsyncWebHeader &h : headers_) {
+            if (strcasecmp(h.name().c_str(), name) == 0) {
+                return &h;
+            }
+        }
+        return nullptr;
+    }
+    bool hasHeader(const char *name) const { return getHeader(name) != nullptr; }
+
+    // HTTP basic authentication only.
+    bool authenticate(const char *username, const char *password, const char *realm = nullptr, bool passwordIsHash = false) const {
+        (void)realm;
+        (void)passwordIsHash;
+        const AsyncWebHeader *h = getHeader("Authorization");
+        return h && h->value() == simBasicAuth(username, password).c_str();
+    }
+    void requestAuthentication(const char *realm = nullptr, bool isDigest = true) {
+        (void)isDigest;
+        AsyncWebServerResponse *r = beginResponse(401);
+        String value = String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"";
+        r->addHeader("WWW-Authenticate", value);
+        send(r);
+    }
+
+    void onDisconnect(ArDisconnectHandler fn) { onDisconnect_ = fn; }
+
+    AsyncWebServerResponse *beginResponse(int code, const char *contentType = "", const char *content = "") {
+        return new AsyncBasicResponse(code, contentType, content);
+    }
+    AsyncWebServerResponse *beginResponse(int code, const String &contentType, const String &content = String()) {
+        return new AsyncBasicResponse(code, contentType, content);
+    }
+    AsyncWebServerResponse *beginResponse(int code, const char *contentType, const uint8_t *content, size_t len) {
+        return new AsyncProgmemResponse(code, contentType, content, len);
+    }
+    AsyncWebServerResponse *beginResponse(int code, const String &contentType, const uint8_t *content, size_t len) {
+        return new AsyncProgmemResponse(code, contentType, content, len);
+    }
+    AsyncWebServerResponse *beginResponse_P(int code, const String &contentType, const uint8_t *content, size_t len) {
+        return new AsyncProgmemResponse(code, contentType, content, len);
+    }
+    AsyncResponseStream *beginResponseStream(const char *contentType, size_t bufferSize = 1460) {
+        (void)bufferSize;
+        return new AsyncResponseStream(contentType);
+    }
+
+    void send(AsyncWebServerResponse *response) {
+        if (response_) {
+            delete response;  // The library keeps the first
+            return;
+        }
+        response_ = response;
+    }
+    void send(int code, const char *contentType = "", const char *content = "") { send(beginResponse(code, contentType, content)); }
+    void send(int code, const String &contentType, const String &content = String()) { send(beginResponse(code, contentType, content)); }
+
+    // --- For the server shim ---
+    static std::string simBasicAuth(const char *username, const char *password) {
+        static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string in = std::string(username) + ":" + password;
+        std::string out = "Basic ";
+        for (size_t i = 0; i < in.size(); i += 3) {
+            uint32_t n = (uint8_t)in[i] << 16;
+            if (i + 1 < in.size()) n |= (uint8_t)in[i + 1] << 8;
+            if (i + 2 < in.size()) n |= (uint8_t)in[i + 2];
+            out += digits[n >> 18 & 63];
+            out += digits[n >> 12 & 63];
+            out += i + 1 < in.size() ? digits[n >> 6 & 63] : '=';
+            out += i + 2 < in.size() ? digits[n & 63] : '=';
+        }
+        return out;
+    }
+    void simAddParam(const String &name, const String &value, bool form) { params_.emplace_back(name, value, form); }
+    void simAddHeader(const String &name, const String &value) { headers_.emplace_back(name, value); }
+    void simSetContentLength(size_t len) { contentLength_ = len; }
+    AsyncWebServerResponse *simResponse() const { return response_; }
+    // The response went out and the client hung up.
+    SimHttpResponse simFinish() {
+        SimHttpResponse out;
+        if (response_) {
+            out.code = response_->code();
+            out.contentType = response_->contentType().c_str();
+            out.body = response_->body();
+            for (const AsyncWebHeader &h : response_->headers()) {
+                out.headers.emplace_back(h.name().c_str(), h.value().c_str());
+            }
+            delete response_;
+            response_ = nullptr;
+        } else {
+            out.code = 500;  // The library answers a request without a response on disconnect
+        }
+        if (onDisconnect_) {
+            onDisconnect_();
+        }
+        return out;
+    }
+
+private:
+    WebRequestMethodComposite      method_;
+    String                         url_;
+    size_t                         contentLength_ = 0;
+    std::vector<AsyncWebParameter> params_;
+    std::vector<AsyncWebHeader>    headers_;
+    AsyncWebServerResponse        *response_ = nullptr;
+    ArDisconnectHandler            onDisconnect_;
+};
+
+// --- Handlers ---
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest *request) const = 0;
+    virtual void handleRequest(AsyncWebServerRequest *request) = 0;
+    virtual void handleBody(AsyncWebServerRequest *, uint8_t *, size_t, size_t, size_t) {}
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    void setUri(const String &uri) { uri_ = uri; }
+    void setMethod(WebRequestMethodComposite method) { method_ = method; }
+    void onRequest(ArRequestHandlerFunction fn) { onRequest_ = fn; }
+    void onUpload(ArUploadHandlerFunction fn) { onUpload_ = fn; }
+    void onBody(ArBodyHandlerFunction fn) { onBody_ = fn; }
+
+    bool canHandle(AsyncWebServerRequest *request) const override {
+        return (request->method() & method_) && request->url() == uri_;
+    }
+    void handleRequest(AsyncWebServerRequest *request) override {
+        if (onRequest_) {
+            onRequest_(request);
+        } else {
+            request->send(500);
+        }
+    }
+    void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override {
+        if (onBody_) {
+            onBody_(request, data, len, index, total);
+        }
+    }
+
+private:
+    String                    uri_;
+    WebRequestMethodComposite method_ = HTTP_ANY;
+    ArRequestHandlerFunction  onRequest_;
+    ArUploadHandlerFunction   onUpload_;
+    ArBodyHandlerFunction     onBody_;
+};
+
+// --- Server-Sent Events ---
+// What a client received, for the tests.
+struct SimEvent {
+    std::string event;
+    std::string data;
+    uint32_t    id;
+};
+
+class AsyncEventSourceClient {
+public:
+    void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        (void)reconnect;
+        if (connected_) {
+            received.push_back({event ? event : "", message ? message : "", id});
+        }
+    }
+    void close() { connected_ = false; }
+    bool connected() const { return connected_; }
+    size_t packetsWaiting() const { return 0; }
+
+    std::vector<SimEvent> received;
+
+private:
+    bool connected_ = true;
+};
+
+class AsyncEventSource : public AsyncWebHandler {
+public:
+    AsyncEventSource(const char *url) : url_(url) {}
+    const char *url() const { return url_.c_str(); }
+    void onConnect(ArEventHandlerFunction cb) { onConnect_ = cb; }
+    void close() {
+        for (auto &c : clients_) {
+            c->close();
+        }
+    }
+    size_t count() const {
+        size_t n = 0;
+        for (const auto &c : clients_) {
+            n += c->connected();
+        }
+        return n;
+    }
+    size_t avgPacketsWaiting() const { return 0; }
+    void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        for (auto &c : clients_) {
+            c->send(message, event, id, reconnect);
+        }
+    }
+
+    bool canHandle(AsyncWebServerRequest *) const override { return false; }
+    void handleRequest(AsyncWebServerRequest *) override {}
+
+    // A browser opens /events.
+    AsyncEventSourceClient *simConnect() {
+        clients_.emplace_back(new AsyncEventSourceClient());
+        AsyncEventSourceClient *c = clients_.back().get();
+        if (onConnect_) {
+            onConnect_(c);
+        }
+        return c;
+    }
+
+private:
+    String                                               url_;
+    ArEventHandlerFunction                               onConnect_;
+    std::vector<std::unique_ptr<AsyncEventSourceClient>> clients_;
+};
+
+// --- Server ---
+class AsyncWebServer {
+public:
+    AsyncWebServer(uint16_t port) : port_(port) {}
+    ~AsyncWebServer() {
+        for (AsyncCallbackWebHandler *h : owned_) {
+            delete h;
+        }
+    }
+
+    void begin() { begun_ = true; }
+    void end() { begun_ = false; }
+    void reset() { handlers_.clear(); }
+
+    AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload = nullptr, ArBodyHandlerFunction onBody = nullptr) {
+        AsyncCallbackWebHandler *h = new AsyncCallbackWebHandler();
+        h->setUri(uri);
+        h->setMethod(method);
+        h->onRequest(onRequest);
+        h->onUpload(onUpload);
+        h->onBody(onBody);
+        owned_.push_back(h);
+        handlers_.push_back(h);
+        return *h;
+    }
+    AsyncCallbackWebHandler &on(const char *uri, ArRequestHandlerFunction onRequest) { return on(uri, HTTP_ANY, onRequest); }
+    AsyncWebHandler &addHandler(AsyncWebHandler *handler) {
+        handlers_.push_back(handler);
+        return *handler;
+    }
+    void onNotFound(ArRequestHandlerFunction fn) { notFound_ = fn; }
+
+    // One request, from arrival to the client hanging up. The url may carry
+    // a query; form holds the url-encoded POST fields, body a raw body.
+    SimHttpResponse simRequest(WebRequestMethodComposite method, const char *url,
+                               const std::vector<std::pair<std::string, std::string>> &form = {},
+                               const std::string &body = std::string(),
+                               const std::vector<std::pair<std::string, std::string>> &headers = {}) {
+        simBoard()->httpRequests++;
+        std::string path = url;
+        std::string query;
+        size_t q = path.find('?');
+        if (q != std::string::npos) {
+            query = path.substr(q + 1);
+            path.resize(q);
+        }
+        AsyncWebServerRequest request(method, path.c_str());
+        while (!query.empty()) {
+            size_t amp = query.find('&');
+            std::string pair = query.substr(0, amp);
+            size_t eq = pair.find('=');
+            request.simAddParam(pair.substr(0, eq).c_str(), eq == std::string::npos ? "" : pair.substr(eq + 1).c_str(), false);
+            query = amp == std::string::npos ? std::string() : query.substr(amp + 1);
+        }
+        for (const auto &f : form) {
+            request.simAddParam(f.first.c_str(), f.second.c_str(), true);
+        }
+        for (const auto &h : headers) {
+            request.simAddHeader(h.first.c_str(), h.second.c_str());
+        }
+        request.simSetContentLength(body.size());
+
+        AsyncWebHandler *handler = nullptr;
+        for (AsyncWebHandler *h : handlers_) {
+            if (h->canHandle(&request)) {
+                handler = h;
+                break;
+            }
+        }
+        if (!handler) {
+            if (notFound_) {
+                notFound_(&request);
+            } else {
+                request.send(404);
+            }
+            return request.simFinish();
+        }
+        if (!body.empty()) {
+            std::vector<uint8_t> data(body.begin(), body.end());
+            handler->handleBody(&request, data.data(), data.size(), 0, data.size());
+        }
+        handler->handleRequest(&request);
+        return request.simFinish();
+    }
+
+private:
+    uint16_t                               port_;
+    bool                                   begun_ = false;
+    std::vector<AsyncWebHandler *>         handlers_;
+    std::vector<AsyncCallbackWebHandler *> owned_;
+    ArRequestHandlerFunction               notFound_;
+};
+
+#endif // ESPASYNCWEBSERVER_H
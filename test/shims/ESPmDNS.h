@@ -0,0 +1,23 @@
+#ifndef ESPMDNS_H
+#define ESPMDNS_H
+
+#include "Arduino.h"
+
+// mDNS that only remembers its host name.
+class MDNSResponder {
+public:
+    bool begin(const char *hostName) {
+        strlcpy(hostName_, hostName, sizeof(hostName_));
+        return hostName_[0] != '\0';
+    }
+    void end() { hostName_[0] = '\0'; }
+    bool addService(const char *, const char *, uint16_t) { return true; }
+    const char *hostName() const { return hostName_; }
+
+private:
+    char hostName_[64] = "";
+};
+
+inline MDNSResponder MDNS;
+
+#endif // ESPMDNS_H
@@ -0,0 +1,34 @@
+#ifndef ELEGANTOTA_H
+#define ELEGANTOTA_H
+
+#include "ESPAsyncWebServer.h"
+
+// ElegantOTA without updates: /update answers, nothing is ever flashed.
+class ElegantOTAClass {
+public:
+    void setAuth(const char *username, const char *password) {
+        username_ = username;
+        password_ = password;
+    }
+    void begin(AsyncWebServer *server, const char *username = "", const char *password = "") {
+        if (*username) {
+            setAuth(username, password);
+        }
+        server->on("/update", HTTP_GET, [this](AsyncWebServerRequest *request) {
+            if (*username_ && !request->authenticate(username_, password_)) {
+                request->requestAuthentication();
+                return;
+            }
+            request->send(200, "text/html", "ElegantOTA");
+        });
+    }
+    void loop() {}
+
+private:
+    const char *username_ = "";
+    const char *password_ = "";
+};
+
+inline ElegantOTAClass ElegantOTA;
+
+#endif // ELEGANTOTA_H
@@ -0,0 +1,275 @@
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <functional>
+#include <string>
+#include "Arduino.h"
+#include "flash_wear.h"
+#include "sim_board.h"
+
+// LittleFS on a directory of the host (the board's fsRoot, a fresh temp dir
+// unless set), so what the firmware stores survives its restarts like flash
+// does. Every write session is counted on the board and charged virtual
+// time through the flash_wear.h model: what littlefs would program and
+// erase, at typical SPI NOR timings.
+
+#define SIM_FS_OPEN_US      250   // Path lookup in the metadata
+#define SIM_FS_READ_KB_US   110   // 40 MHz quad reads, with littlefs' caching
+#define SIM_FS_PROG_US      400   // One FLASH_PROG_SIZE page program
+#define SIM_FS_ERASE_US     45000 // One FLASH_BLOCK_SIZE erase
+
+inline std::string simFsPath(const char *path) {
+    SimBoard *b = simBoard();
+    if (!b->fsRoot[0]) {
+        char dir[] = "/tmp/chronoclock-fs-XXXXXX";
+        if (mkdtemp(dir)) {
+            strlcpy(b->fsRoot, dir, sizeof(b->fsRoot));
+        }
+    }
+    return std::string(b->fsRoot) + (path[0] == '/' ? "" : "/") + path;
+}
+
+// Empty the flash, like erasing the filesystem partition.
+inline void simFsErase() {
+    SimBoard *b = simBoard();
+    std::string root = simFsPath("");
+    DIR *dir = opendir(root.c_str());
+    if (dir) {
+        struct dirent *e;
+        while ((e = readdir(dir)) != nullptr) {
+            if (e->d_name[0] != '.') {
+                unlink((root + e->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    memset(&b->fsWear, 0, sizeof(b->fsWear));
+}
+
+// Virtual time of the flash operations the model estimates since before.
+inline void simFsCharge(const FlashWear *before) {
+    const FlashWear *after = &simBoard()->fsWear;
+    simAdvance((int64_t)(after->erases - before->erases) * SIM_FS_ERASE_US +
+               (int64_t)((after->physicalBytes - before->physicalBytes) / FLASH_PROG_SIZE) * SIM_FS_PROG_US);
+}
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+public:
+    File() {}
+    File(FILE *f, const std::string &name, bool writing, size_t offset) : f_(f), name_(name), writing_(writing), offset_(offset) {}
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+    File(File &&other) { *this = static_cast<File &&>(other); }
+    File &operator=(File &&other) {
+        if (this != &other) {
+            close();
+            f_ = other.f_;
+            name_ = other.name_;
+            writing_ = other.writing_;
+            offset_ = other.offset_;
+            written_ = other.written_;
+            other.f_ = nullptr;
+        }
+        return *this;
+    }
+    ~File() { close(); }
+
+    explicit operator bool() const { return f_ != nullptr; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        if (!f_ || !writing_) {
+            return 0;
+        }
+        size_t n = fwrite(buffer, 1, size, f_);
+        written_ += n;
+        return n;
+    }
+    using Print::write;
+
+    int available() override {
+        if (!f_) {
+            return 0;
+        }
+        long pos = ftell(f_);
+        return (int)(size() - (size_t)pos);
+    }
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    size_t read(uint8_t *buffer, size_t size) {
+        if (!f_) {
+            return 0;
+        }
+        size_t n = fread(buffer, 1, size, f_);
+        simAdvance((int64_t)n * SIM_FS_READ_KB_US / 1024);
+        return n;
+    }
+    size_t readBytes(char *buffer, size_t length) override { return read((uint8_t *)buffer, length); }
+    int peek() override {
+        if (!f_) {
+            return -1;
+        }
+        int c = fgetc(f_);
+        if (c != EOF) {
+            ungetc(c, f_);
+        }
+        return c == EOF ? -1 : c;
+    }
+    void flush() override {
+        if (f_) {
+            fflush(f_);
+        }
+    }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+        return f_ && fseek(f_, pos, mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END) == 0;
+    }
+    size_t position() const { return f_ ? (size_t)ftell(f_) : 0; }
+    size_t size() const {
+        if (!f_) {
+            return 0;
+        }
+        fflush(f_);
+        struct stat st;
+        return fstat(fileno(f_), &st) == 0 ? (size_t)st.st_size : 0;
+    }
+    const char *name() const { return name_.c_str(); }
+
+    // Closing a written file ends its write session.
+    void close() {
+        if (!f_) {
+            return;
+        }
+        fclose(f_);
+        f_ = nullptr;
+        if (writing_) {
+            SimBoard *b = simBoard();
+            FlashWear before = b->fsWear;
+            flashWearWrite(&b->fsWear, (uint8_t)(std::hash<std::string>()(name_) % 32), offset_, written_);
+            b->fsBytesWritten += written_;
+            b->fsFilesWritten++;
+            simFsCharge(&before);
+        }
+    }
+
+private:
+    FILE       *f_       = nullptr;
+    std::string name_;
+    bool        writing_ = false;
+    size_t      offset_  = 0;   // Size of the file when an append started
+    size_t      written_ = 0;
+};
+
+class FS {
+public:
+    File open(const char *path, const char *mode = "r") {
+        simAdvance(SIM_FS_OPEN_US);
+        if (!mounted_) {
+            return File();
+        }
+        std::string full = simFsPath(path);
+        struct stat st;
+        bool exists = stat(full.c_str(), &st) == 0;
+        if (mode[0] == 'r' && !exists) {
+            return File();
+        }
+        bool writing = mode[0] != 'r' || strchr(mode, '+');
+        size_t offset = mode[0] == 'a' && exists ? (size_t)st.st_size : 0;
+        std::string m = std::string(mode) + "b";
+        FILE *f = fopen(full.c_str(), m.c_str());
+        if (!f) {
+            return File();
+        }
+        return File(f, path, writing, offset);
+    }
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+
+    bool exists(const char *path) {
+        simAdvance(SIM_FS_OPEN_US);
+        struct stat st;
+        return mounted_ && stat(simFsPath(path).c_str(), &st) == 0;
+    }
+    bool exists(const String &path) { return exists(path.c_str()); }
+
+    bool remove(const char *path) {
+        if (!mounted_ || unlink(simFsPath(path).c_str()) != 0) {
+            return false;
+        }
+        commit();
+        simBoard()->fsRemoves++;
+        return true;
+    }
+    bool rename(const char *from, const char *to) {
+        if (!mounted_ || ::rename(simFsPath(from).c_str(), simFsPath(to).c_str()) != 0) {
+            return false;
+        }
+        commit();
+        simBoard()->fsRenames++;
+        return true;
+    }
+
+    size_t totalBytes() { return simBoard()->fsTotalBytes; }
+    size_t usedBytes() {
+        size_t used = 0;
+        std::string root = simFsPath("");
+        DIR *dir = opendir(root.c_str());
+        if (dir) {
+            struct dirent *e;
+            while ((e = readdir(dir)) != nullptr) {
+                struct stat st;
+                if (e->d_name[0] != '.' && stat((root + e->d_name).c_str(), &st) == 0) {
+                    used += flashRoundUp((uint32_t)st.st_size, FLASH_BLOCK_SIZE);
+                }
+            }
+            closedir(dir);
+        }
+        return used;
+    }
+
+protected:
+    void commit() {
+        SimBoard *b = simBoard();
+        FlashWear before = b->fsWear;
+        flashWearCommit(&b->fsWear);
+        simFsCharge(&before);
+    }
+
+    bool mounted_ = false;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+
+class LittleFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false, const char * = "/littlefs", uint8_t = 10, const char * = "spiffs") {
+        (void)formatOnFail;
+        simAdvance(20000);  // Mount scans the superblock and metadata pairs
+        mkdir(simFsPath("").c_str(), 0700);
+        mounted_ = !simBoard()->fsBroken;
+        return mounted_;
+    }
+    void end() { mounted_ = false; }
+    bool format() {
+        simFsErase();
+        return true;
+    }
+};
+
+inline LittleFSFS LittleFS;
+
+#endif // LITTLEFS_H
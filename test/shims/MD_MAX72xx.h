@@ -0,0 +1,101 @@
+#ifndef MD_MAX72XX_H
+#define MD_MAX72XX_H
+
+#include <stdint.h>
+#include <string.h>
+#include "sim_board.h"
+
+// MD_MAX72XX driver on a simulated matrix. The column buffer is the
+// library's; update() shows it, counting the modules whose columns changed
+// (the SPI traffic the real driver sends) and folding every new picture into
+// the board's display hash, so a run's frames can be compared cheaply.
+
+#define COL_SIZE 8
+#define ROW_SIZE 8
+#define SIM_MAX_MODULES 8
+
+class MD_MAX72XX {
+public:
+    enum moduleType_t { PAROLA_HW, GENERIC_HW, ICSTATION_HW, FC16_HW, DR0CR0RR0_HW, DR1CR0RR0_HW };
+    enum controlRequest_t { SHUTDOWN, SCANLIMIT, INTENSITY, TEST, DECODE, UPDATE, WRAPAROUND };
+    enum controlValue_t { OFF = 0, ON = 1 };
+    typedef uint8_t fontType_t;
+
+    MD_MAX72XX(moduleType_t, uint8_t, uint8_t, uint8_t, uint8_t numDevices = 1)
+        : devices_(numDevices < SIM_MAX_MODULES ? numDevices : SIM_MAX_MODULES) {}
+
+    bool begin() {
+        memset(columns_, 0, sizeof(columns_));
+        memset(shown_, 0, sizeof(shown_));
+        return true;
+    }
+    bool control(controlRequest_t mode, int value) {
+        if (mode == UPDATE) {
+            autoUpdate_ = value == ON;
+        } else if (mode == INTENSITY) {
+            simBoard()->intensity = (uint8_t)value;
+        }
+        return true;
+    }
+    bool control(uint8_t, controlRequest_t mode, int value) { return control(mode, value); }
+
+    uint16_t getColumnCount() { return devices_ * COL_SIZE; }
+    uint8_t getDeviceCount() { return devices_; }
+
+    bool setColumn(uint8_t dev, uint8_t c, uint8_t value) {
+        if (dev >= devices_ || c >= COL_SIZE) {
+            return false;
+        }
+        columns_[dev * COL_SIZE + c] = value;
+        if (autoUpdate_) {
+            update();
+        }
+        return true;
+    }
+    bool setColumn(uint16_t c, uint8_t value) { return setColumn(c / COL_SIZE, c % COL_SIZE, value); }
+    uint8_t getColumn(uint8_t dev, uint8_t c) { return dev < devices_ && c < COL_SIZE ? columns_[dev * COL_SIZE + c] : 0; }
+    uint8_t getColumn(uint8_t c) { return getColumn(c / COL_SIZE, c % COL_SIZE); }
+
+    void clear() {
+        memset(columns_, 0, sizeof(columns_));
+        if (autoUpdate_) {
+            update();
+        }
+    }
+
+    void update() {
+        SimBoard *b = simBoard();
+        uint8_t changed = 0;
+        for (uint8_t dev = 0; dev < devices_; dev++) {
+            if (memcmp(&columns_[dev * COL_SIZE], &shown_[dev * COL_SIZE], COL_SIZE) != 0) {
+                changed++;
+            }
+        }
+        if (changed == 0) {
+            return;
+        }
+        memcpy(shown_, columns_, sizeof(shown_));
+        b->displayUpdates++;
+        b->displayModules += changed;
+        memcpy(b->displayColumns, shown_, sizeof(b->displayColumns) < sizeof(shown_) ? sizeof(b->displayColumns) : sizeof(shown_));
+        uint64_t hash = b->displayHash ? b->displayHash : 0xcbf29ce484222325ULL;
+        for (uint16_t i = 0; i < devices_ * COL_SIZE; i++) {
+            hash = (hash ^ shown_[i]) * 0x100000001b3ULL;
+        }
+        b->displayHash = hash;
+    }
+    void update(controlValue_t mode) {
+        autoUpdate_ = mode == ON;
+        if (autoUpdate_) {
+            update();
+        }
+    }
+
+private:
+    uint8_t devices_;
+    bool    autoUpdate_ = true;
+    uint8_t columns_[SIM_MAX_MODULES * COL_SIZE];
+    uint8_t shown_[SIM_MAX_MODULES * COL_SIZE];
+};
+
+#endif // MD_MAX72XX_H
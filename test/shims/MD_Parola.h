@@ -0,0 +1,32 @@
+#ifndef MD_PAROLA_H
+#define MD_PAROLA_H
+
+#include "MD_MAX72xx.h"
+
+// MD_Parola as far as the firmware uses it: a holder of the MD_MAX72XX
+// driver, which the firmware draws on directly, and the brightness.
+
+enum textPosition_t { PA_LEFT, PA_CENTER, PA_RIGHT };
+enum textEffect_t { PA_NO_EFFECT, PA_PRINT };
+
+class MD_Parola {
+public:
+    MD_Parola(MD_MAX72XX::moduleType_t mod, uint8_t dataPin, uint8_t clkPin, uint8_t csPin, uint8_t numDevices = 1)
+        : mx_(mod, dataPin, clkPin, csPin, numDevices) {}
+
+    bool begin() { return mx_.begin(); }
+    MD_MAX72XX *getGraphicObject() { return &mx_; }
+    void setIntensity(uint8_t intensity) { mx_.control(MD_MAX72XX::INTENSITY, intensity); }
+    void displayClear() { mx_.clear(); }
+    void displaySuspend(bool) {}
+    bool displayAnimate() { return true; }
+    void setTextAlignment(textPosition_t) {}
+    void setCharSpacing(uint8_t) {}
+    void setFont(const uint8_t *) {}
+    void print(const char *) {}
+
+private:
+    MD_MAX72XX mx_;
+};
+
+#endif // MD_PAROLA_H
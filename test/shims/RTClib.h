@@ -0,0 +1,114 @@
+#ifndef RTCLIB_H
+#define RTCLIB_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Wire.h"
+#include "sim_board.h"
+
+// RTClib's DateTime and RTC_DS3231 on the simulated DS3231: the time
+// registers hold the board's RTC model (its own crystal error and aging
+// offset), with the bus transactions the library makes for each call.
+
+#define SECONDS_FROM_1970_TO_2000 946684800
+
+class DateTime {
+public:
+    DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000) : t_(t) {}
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0) {
+        struct tm tm = {};
+        tm.tm_year = (year < 100 ? year + 2000 : year) - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = min;
+        tm.tm_sec = sec;
+        t_ = (uint32_t)timegm(&tm);
+    }
+    // __DATE__ ("Jun 15 2025") and __TIME__ ("15:06:40")
+    DateTime(const char *date, const char *time) {
+        static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        char month[4] = {date[0], date[1], date[2], '\0'};
+        const char *found = strstr(months, month);
+        *this = DateTime((uint16_t)atoi(date + 7), found ? (uint8_t)((found - months) / 3 + 1) : 1, (uint8_t)atoi(date + 4),
+                         (uint8_t)atoi(time), (uint8_t)atoi(time + 3), (uint8_t)atoi(time + 6));
+    }
+
+    uint32_t unixtime() const { return t_; }
+    uint32_t secondstime() const { return t_ - SECONDS_FROM_1970_TO_2000; }
+    uint16_t year() const { return fields().tm_year + 1900; }
+    uint8_t month() const { return fields().tm_mon + 1; }
+    uint8_t day() const { return fields().tm_mday; }
+    uint8_t hour() const { return fields().tm_hour; }
+    uint8_t minute() const { return fields().tm_min; }
+    uint8_t second() const { return fields().tm_sec; }
+    uint8_t dayOfTheWeek() const { return fields().tm_wday; }
+
+private:
+    struct tm fields() const {
+        time_t t = t_;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        return tm;
+    }
+
+    uint32_t t_;
+};
+
+enum Ds3231SqwPinMode {
+    DS3231_OFF            = 0x1C,
+    DS3231_SquareWave1Hz  = 0x00,
+    DS3231_SquareWave1kHz = 0x08,
+    DS3231_SquareWave4kHz = 0x10,
+    DS3231_SquareWave8kHz = 0x18
+};
+
+class RTC_DS3231 {
+public:
+    bool begin(TwoWire * = &Wire) {
+        simI2c(0);  // Address probe
+        return simBoard()->rtcPresent;
+    }
+    bool lostPower() {
+        simI2c(1);
+        simI2c(1);
+        return simBoard()->rtcStopped;
+    }
+    // Writing the seconds register restarts the RTC's second, so the new
+    // time is exact from this moment.
+    void adjust(const DateTime &dt) {
+        simI2c(7);
+        simRtcSet((int64_t)dt.unixtime() * 1000000);
+        simI2c(1);  // Clear the oscillator stop flag, read-modify-write
+        simI2c(1);
+        simI2c(2);
+        simBoard()->rtcStopped = false;
+    }
+    DateTime now() {
+        simI2c(1);
+        DateTime dt((uint32_t)(simRtcNowUs() / 1000000));
+        simI2c(7);
+        return dt;
+    }
+    void writeSqwPinMode(Ds3231SqwPinMode mode) {
+        simI2c(1);
+        simI2c(1);
+        SimBoard *b = simBoard();
+        b->rtcControl = (b->rtcControl & ~0x1C) | mode;
+        simI2c(2);
+    }
+    Ds3231SqwPinMode readSqwPinMode() {
+        simI2c(1);
+        simI2c(1);
+        return (Ds3231SqwPinMode)(simBoard()->rtcControl & 0x1C);
+    }
+    float getTemperature() {
+        simI2c(1);
+        simI2c(2);
+        return 25.0f;
+    }
+};
+
+#endif // RTCLIB_H
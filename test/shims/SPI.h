@@ -0,0 +1,14 @@
+#ifndef SPI_H
+#define SPI_H
+
+// The matrix is driven through MD_MAX72xx.h, which doesn't need a bus here.
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+};
+
+inline SPIClass SPI;
+
+#endif // SPI_H
@@ -0,0 +1,267 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <functional>
+#include <vector>
+#include "Arduino.h"
+#include "sim_board.h"
+
+// ESP32 WiFi on the simulated network. A scan finds the board's networks
+// after a scan's time, begin() gets an address from one of them (or fails,
+// if it isn't in range) a little later, and the results arrive as events
+// from delay()/yield(), as they do from the ESP32's event task. So do the
+// answers of lookups that don't wait.
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef wifi_mode_t WiFiMode_t;
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+
+typedef struct {
+    uint8_t reason;
+} arduino_event_info_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+
+#define WIFI_SCAN_RUNNING  (-1)
+#define WIFI_SCAN_FAILED   (-2)
+#define WIFI_AUTH_WPA2_PSK 3
+
+#define SIM_WIFI_SCAN_US    2100000  // Active scan of all channels
+#define SIM_WIFI_CONNECT_US 1500000  // Association, handshake and DHCP
+#define SIM_WIFI_FAIL_US    5000000  // Until an absent network is given up
+#define SIM_DNS_US          3000     // A lookup at the router
+
+class WiFiClass {
+public:
+    WiFiClass() {
+        simHooks().poll = [] { WiFi_().poll(); };
+    }
+
+    bool mode(wifi_mode_t m) {
+        mode_ = m;
+        if (!(m & WIFI_STA)) {
+            connected_ = false;
+        }
+        return true;
+    }
+    wifi_mode_t getMode() { return mode_; }
+
+    bool disconnect(bool = false, bool = false) {
+        cancel(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        cancel(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        if (connected_) {
+            connected_ = false;
+            queue(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, 5000);
+        }
+        return true;
+    }
+
+    int onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+        handlers_.push_back({event, cb});
+        return (int)handlers_.size();
+    }
+
+    int16_t scanNetworks(bool async = false) {
+        scanResult_ = WIFI_SCAN_RUNNING;
+        cancel(ARDUINO_EVENT_WIFI_SCAN_DONE);
+        if (!async) {
+            simAdvance(SIM_WIFI_SCAN_US);
+            scanResult_ = simBoard()->networkCount;
+            return scanResult_;
+        }
+        queue(ARDUINO_EVENT_WIFI_SCAN_DONE, SIM_WIFI_SCAN_US);
+        return WIFI_SCAN_RUNNING;
+    }
+    int16_t scanComplete() { return scanResult_; }
+    void scanDelete() { scanResult_ = WIFI_SCAN_FAILED; }
+    bool getNetworkInfo(uint8_t i, String &ssid, uint8_t &encType, int32_t &rssi, uint8_t *&bssid, int32_t &channel) {
+        SimBoard *b = simBoard();
+        if (scanResult_ <= 0 || i >= scanResult_ || i >= b->networkCount) {
+            return false;
+        }
+        static uint8_t mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+        ssid = b->networks[i];
+        encType = WIFI_AUTH_WPA2_PSK;
+        rssi = -55 - 5 * i;
+        bssid = mac;
+        channel = 1 + 5 * i;
+        return true;
+    }
+
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr) {
+        (void)passphrase;
+        cancel(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        cancel(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        connected_ = false;
+        if (inRange(ssid)) {
+            queue(ARDUINO_EVENT_WIFI_STA_GOT_IP, SIM_WIFI_CONNECT_US);
+        } else {
+            queue(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, SIM_WIFI_FAIL_US);
+        }
+        return WL_DISCONNECTED;
+    }
+    wl_status_t status() { return connected_ ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool isConnected() { return connected_; }
+
+    bool softAP(const char *ssid, const char *passphrase = nullptr) {
+        (void)ssid;
+        (void)passphrase;
+        mode_ = (wifi_mode_t)(mode_ | WIFI_AP);
+        return true;
+    }
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    IPAddress localIP() { return connected_ ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+    int8_t RSSI() { return connected_ ? -55 : 0; }
+
+    int hostByName(const char *host, IPAddress &ip) {
+        simAdvance(connected_ ? SIM_DNS_US : 0);
+        if (!connected_ || !host || !*host) {
+            return 0;
+        }
+        simBoard()->dnsLookups++;
+        ip = simAddress(host);
+        return 1;
+    }
+
+    // Address of a name on the simulated network: the board's ntpHosts are
+    // 192.0.2.1 and up, any other name is the built-in NTP server.
+    IPAddress simAddress(const char *host) {
+        SimBoard *b = simBoard();
+        for (uint8_t i = 0; i < SIM_MAX_NTP_SERVERS; i++) {
+            if (b->ntpHosts[i][0] && strcmp(b->ntpHosts[i], host) == 0) {
+                return IPAddress(192, 0, 2, 1 + i);
+            }
+        }
+        return IPAddress(192, 0, 2, 123);
+    }
+
+    // A lookup without waiting (lwip/dns.h): done gets the address from
+    // delay()/yield() after SIM_DNS_US, like from the tcpip task.
+    void simLookup(const char *host, std::function<void(IPAddress)> done) {
+        simBoard()->dnsLookups++;
+        lookups_.push_back({simBoard()->monoUs + SIM_DNS_US, simAddress(host), done});
+    }
+
+    // Deliver the events that are due.
+    void poll() {
+        int64_t now = simBoard()->monoUs;
+        for (size_t i = 0; i < pending_.size();) {
+            if (pending_[i].dueUs > now) {
+                i++;
+                continue;
+            }
+            arduino_event_id_t event = pending_[i].event;
+            pending_.erase(pending_.begin() + i);
+            if (event == ARDUINO_EVENT_WIFI_SCAN_DONE) {
+                scanResult_ = simBoard()->networkCount;
+            } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+                connected_ = true;
+            } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+                connected_ = false;
+            }
+            arduino_event_info_t info = {};
+            std::vector<Handler> handlers = handlers_;  // A handler may register more
+            for (const Handler &h : handlers) {
+                if (h.event == event || h.event == ARDUINO_EVENT_MAX) {
+                    h.cb(event, info);
+                }
+            }
+            i = 0;
+        }
+        for (size_t i = 0; i < lookups_.size();) {
+            if (lookups_[i].dueUs > now) {
+                i++;
+                continue;
+            }
+            Lookup lookup = lookups_[i];
+            lookups_.erase(lookups_.begin() + i);
+            lookup.done(lookup.ip);
+        }
+    }
+
+    // The access point went away (or came back, after a scan and begin()).
+    void simDrop() {
+        if (connected_) {
+            connected_ = false;
+            queue(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, 0);
+        }
+    }
+
+private:
+    struct Handler {
+        arduino_event_id_t event;
+        WiFiEventFuncCb    cb;
+    };
+    struct Pending {
+        int64_t            dueUs;
+        arduino_event_id_t event;
+    };
+    struct Lookup {
+        int64_t                        dueUs;
+        IPAddress                      ip;
+        std::function<void(IPAddress)> done;
+    };
+
+    static WiFiClass &WiFi_();
+
+    bool inRange(const char *ssid) {
+        SimBoard *b = simBoard();
+        for (uint8_t i = 0; i < b->networkCount; i++) {
+            if (strcmp(b->networks[i], ssid) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    void queue(arduino_event_id_t event, int64_t afterUs) {
+        pending_.push_back({simBoard()->monoUs + afterUs, event});
+    }
+    void cancel(arduino_event_id_t event) {
+        for (size_t i = 0; i < pending_.size();) {
+            if (pending_[i].event == event) {
+                pending_.erase(pending_.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    wifi_mode_t          mode_       = WIFI_OFF;
+    bool                 connected_  = false;
+    int16_t              scanResult_ = WIFI_SCAN_FAILED;
+    std::vector<Handler> handlers_;
+    std::vector<Pending> pending_;
+    std::vector<Lookup>  lookups_;
+};
+
+inline WiFiClass WiFi;
+
+inline WiFiClass &WiFiClass::WiFi_() {
+    return WiFi;
+}
+
+#endif // WIFI_H
@@ -0,0 +1,166 @@
+#ifndef WIFIUDP_H
+#define WIFIUDP_H
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "Arduino.h"
+#include "WiFi.h"
+#include "ntp_packet.h"
+#include "sim_board.h"
+
+// WiFiUDP with an NTP server on the simulated network. A client request
+// sent to port 123 while connected is answered from true time: stamped on
+// arrival after the way out (half the board's round trip plus its
+// asymmetry), readable by parsePacket() after the way back. Requests to
+// the address of a running test/support/ntp_server.h server go to it over
+// a localhost socket instead; the firmware waits for its answer without
+// virtual time passing, and reads it after the same round trip.
+
+#define SIM_NTP_PROCESSING_US 30
+
+class WiFiUDP : public Stream {
+public:
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(uint16_t port) {
+        port_ = port;
+        replies_.clear();
+        return 1;
+    }
+    void stop() {
+        port_ = 0;
+        replies_.clear();
+        current_.clear();
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int beginPacket(IPAddress ip, uint16_t port) {
+        toIp_ = ip;
+        toPort_ = port;
+        out_.clear();
+        return 1;
+    }
+    int beginPacket(const char *host, uint16_t port) {
+        IPAddress ip;
+        return WiFi.hostByName(host, ip) ? beginPacket(ip, port) : 0;
+    }
+    size_t write(uint8_t c) override {
+        out_.push_back(c);
+        return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        out_.insert(out_.end(), buffer, buffer + size);
+        return size;
+    }
+    using Print::write;
+    int endPacket() {
+        SimBoard *b = simBoard();
+        if (!port_ || !WiFi.isConnected()) {
+            return 0;
+        }
+        uint16_t serverPort = 0;
+        if (toIp_[0] == 192 && toIp_[1] == 0 && toIp_[2] == 2 && toIp_[3] >= 1 && toIp_[3] <= SIM_MAX_NTP_SERVERS) {
+            serverPort = b->ntpServerPorts[toIp_[3] - 1];
+        }
+        if (toPort_ == NTP_PORT && serverPort && b->ntpUp) {
+            b->ntpQueries++;
+            sendToServer(serverPort);
+        } else if (toPort_ == NTP_PORT && out_.size() == NTP_PACKET_SIZE && (out_[0] & 0x07) == 3 && b->ntpUp) {
+            b->ntpQueries++;
+            int64_t outUs = b->ntpDelayUs / 2 + b->ntpAsymmetryUs;
+            int64_t backUs = b->ntpDelayUs - b->ntpDelayUs / 2;
+            Reply r;
+            r.readyMonoUs = b->monoUs + outUs + SIM_NTP_PROCESSING_US + backUs;
+            r.data.assign(NTP_PACKET_SIZE, 0);
+            int64_t receiveUs = b->trueUs + outUs;
+            r.data[0] = 0x24;   // LI 0, VN 4, mode 4
+            r.data[1] = 1;      // Stratum 1
+            r.data[2] = 6;
+            r.data[3] = 0xEC;   // 2^-20 s precision
+            memcpy(&r.data[12], "GPS", 3);
+            ntpWriteTimestamp(&r.data[16], receiveUs - 8000000);
+            memcpy(&r.data[24], &out_[40], 8);
+            ntpWriteTimestamp(&r.data[32], receiveUs);
+            ntpWriteTimestamp(&r.data[40], receiveUs + SIM_NTP_PROCESSING_US);
+            replies_.push_back(r);
+        }
+        out_.clear();
+        return 1;
+    }
+
+    int parsePacket() {
+        current_.clear();
+        pos_ = 0;
+        simYield();
+        for (size_t i = 0; i < replies_.size(); i++) {
+            if (replies_[i].readyMonoUs <= simBoard()->monoUs) {
+                current_ = replies_[i].data;
+                replies_.erase(replies_.begin() + i);
+                return (int)current_.size();
+            }
+        }
+        return 0;
+    }
+    int available() override { return (int)(current_.size() - pos_); }
+    int read() override { return pos_ < current_.size() ? current_[pos_++] : -1; }
+    int read(uint8_t *buffer, size_t len) {
+        size_t n = std::min(len, current_.size() - pos_);
+        memcpy(buffer, current_.data() + pos_, n);
+        pos_ += n;
+        return (int)n;
+    }
+    int read(char *buffer, size_t len) { return read((uint8_t *)buffer, len); }
+    int peek() override { return pos_ < current_.size() ? current_[pos_] : -1; }
+    void flush() override {}
+    IPAddress remoteIP() { return IPAddress(192, 0, 2, 123); }
+    uint16_t remotePort() { return NTP_PORT; }
+
+private:
+    struct Reply {
+        int64_t              readyMonoUs;
+        std::vector<uint8_t> data;
+    };
+
+    void sendToServer(uint16_t serverPort) {
+        if (fd_ < 0) {
+            fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        }
+        sockaddr_in to = {};
+        to.sin_family = AF_INET;
+        to.sin_port = htons(serverPort);
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (sendto(fd_, out_.data(), out_.size(), 0, (sockaddr *)&to, sizeof(to)) < 0) {
+            return;
+        }
+        pollfd p = {fd_, POLLIN, 0};
+        if (poll(&p, 1, 1000) <= 0) {  // Host milliseconds
+            return;
+        }
+        Reply r;
+        r.data.resize(512);
+        ssize_t n = recv(fd_, r.data.data(), r.data.size(), 0);
+        if (n <= 0) {
+            return;
+        }
+        r.data.resize(n);
+        r.readyMonoUs = simBoard()->monoUs + simBoard()->ntpDelayUs + SIM_NTP_PROCESSING_US;
+        replies_.push_back(r);
+    }
+
+    int                  fd_     = -1;  // Socket to the test servers
+    uint16_t             port_   = 0;
+    IPAddress            toIp_;
+    uint16_t             toPort_ = 0;
+    std::vector<uint8_t> out_;
+    std::vector<Reply>   replies_;
+    std::vector<uint8_t> current_;
+    size_t               pos_    = 0;
+};
+
+#endif // WIFIUDP_H
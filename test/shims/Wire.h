@@ -0,0 +1,106 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stdint.h>
+#include "sim_board.h"
+
+// I2C bus with the DS3231 on it. Only the registers the firmware reaches
+// directly are backed: control (0x0E) and aging offset (0x10); the time
+// registers are read and written through RTClib.h. Every transaction is
+// counted and takes its time on the bus.
+
+#define SIM_DS3231_ADDRESS 0x68
+
+class TwoWire {
+public:
+    bool begin() { return true; }
+    bool begin(int, int, uint32_t = 0) { return true; }
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t address) {
+        address_ = address;
+        txLength_ = 0;
+    }
+    size_t write(uint8_t data) {
+        if (txLength_ < sizeof(tx_)) {
+            tx_[txLength_++] = data;
+        }
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            write(data[i]);
+        }
+        return length;
+    }
+    uint8_t endTransmission(bool = true) {
+        simI2c(txLength_);
+        if (!present(address_)) {
+            return 2;  // NACK on the address
+        }
+        if (txLength_ > 0) {
+            pointer_ = tx_[0];
+        }
+        for (uint8_t i = 1; i < txLength_; i++) {
+            writeRegister(pointer_++, tx_[i]);
+        }
+        return 0;
+    }
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool = true) {
+        simI2c(quantity);
+        rxLength_ = rxPos_ = 0;
+        if (!present(address)) {
+            return 0;
+        }
+        for (uint8_t i = 0; i < quantity && rxLength_ < sizeof(rx_); i++) {
+            rx_[rxLength_++] = readRegister(pointer_++);
+        }
+        return rxLength_;
+    }
+    uint8_t requestFrom(int address, int quantity) {
+        return requestFrom((uint8_t)address, (uint8_t)quantity);
+    }
+    int available() { return rxLength_ - rxPos_; }
+    int read() { return rxPos_ < rxLength_ ? rx_[rxPos_++] : -1; }
+
+private:
+    static bool present(uint8_t address) {
+        return address == SIM_DS3231_ADDRESS && simBoard()->rtcPresent;
+    }
+    static uint8_t readRegister(uint8_t reg) {
+        SimBoard *b = simBoard();
+        switch (reg) {
+            case 0x0E: return b->rtcControl;
+            case 0x0F: return b->rtcStopped ? 0x80 : 0x00;
+            case 0x10: return (uint8_t)b->rtcAging;
+            default:   return 0;
+        }
+    }
+    static void writeRegister(uint8_t reg, uint8_t value) {
+        SimBoard *b = simBoard();
+        switch (reg) {
+            case 0x0E:
+                b->rtcControl = value & ~0x20;  // CONV clears itself once the conversion is done
+                break;
+            case 0x0F:
+                b->rtcStopped = b->rtcStopped && (value & 0x80);
+                break;
+            case 0x10:
+                simRtcSet(simRtcNowUs());  // The new rate applies from here
+                b->rtcAging = (int8_t)value;
+                break;
+        }
+    }
+
+    uint8_t address_ = 0;
+    uint8_t pointer_ = 0;
+    uint8_t tx_[32];
+    uint8_t txLength_ = 0;
+    uint8_t rx_[32];
+    uint8_t rxLength_ = 0;
+    uint8_t rxPos_ = 0;
+};
+
+inline TwoWire Wire;
+
+#endif // WIRE_H
@@ -0,0 +1,6 @@
+#pragma once
+
+// Credentials of the native env, in place of the include/auth.h each board
+// build is given (see include/example auth.h).
+const char *ELEGANT_USER = "test";
+const char *ELEGANT_PASS = "secret";
@@ -0,0 +1,11 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include "sim_board.h"
+
+// Microseconds since power on, on the virtual clock.
+inline int64_t esp_timer_get_time() {
+    return simReadClock();
+}
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,45 @@
+#ifndef LWIP_DNS_H
+#define LWIP_DNS_H
+
+#include <arpa/inet.h>
+#include <string>
+#include "WiFi.h"
+
+// lwIP's resolver on the simulated network (WiFi.simLookup()). An address
+// answers at once, a name later through the callback, and without a
+// connection there is no DNS server to ask.
+
+typedef int8_t err_t;
+#define ERR_OK          0
+#define ERR_INPROGRESS -5
+#define ERR_VAL        -6
+#define ERR_ARG       -16
+
+typedef struct {
+    uint32_t addr;  // Network order, like IPAddress
+} ip_addr_t;
+#define ip_addr_get_ip4_u32(ipaddr) ((ipaddr) != NULL ? (ipaddr)->addr : 0)
+
+typedef void (*dns_found_callback)(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
+
+inline err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg) {
+    if (!hostname || !*hostname || !found) {
+        return ERR_ARG;
+    }
+    struct in_addr in;
+    if (inet_pton(AF_INET, hostname, &in) == 1) {
+        addr->addr = in.s_addr;
+        return ERR_OK;
+    }
+    if (!WiFi.isConnected()) {
+        return ERR_VAL;
+    }
+    std::string name = hostname;
+    WiFi.simLookup(hostname, [name, found, callback_arg](IPAddress ip) {
+        ip_addr_t answer = {(uint32_t)ip};
+        found(name.c_str(), &answer, callback_arg);
+    });
+    return ERR_INPROGRESS;
+}
+
+#endif // LWIP_DNS_H
@@ -0,0 +1,8 @@
+#ifndef LWIP_TCPIP_H
+#define LWIP_TCPIP_H
+
+// lwIP's core lock. The simulated network runs in the firmware's thread.
+#define LOCK_TCPIP_CORE()
+#define UNLOCK_TCPIP_CORE()
+
+#endif // LWIP_TCPIP_H
@@ -0,0 +1,220 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "flash_wear.h"
+
+// State of the simulated board behind the library shims in this directory:
+// a virtual clock, the DS3231, the WiFi network with an NTP server on it,
+// and counters of what the firmware did to the hardware.
+//
+// Time only moves when the firmware sleeps (delay(), yield()) or reads a
+// clock, each read costing SIM_CLOCK_READ_US, so busy waits end. Bus
+// transfers cost what they would at the bus speed. The ESP crystal and the
+// DS3231 run off true time at their own error, so drift and its correction
+// can be observed.
+//
+// The board lives in shared memory: test/support/sim.h runs each power on
+// of the firmware in a child process, and the board (with the RTC, the
+// flash contents and the counters) outlives it like the hardware would.
+
+#define SIM_CLOCK_READ_US   1         // Virtual cost of one clock read
+#define SIM_I2C_BYTE_US     90        // 9 bits at 100 kHz
+#define SIM_UTC_DEFAULT_US  1750000000000000LL  // 2025-06-15 15:06:40 UTC
+#define SIM_MAX_NETWORKS    4
+#define SIM_MAX_NTP_SERVERS 2
+#define SIM_EXIT_RESTART    75        // Exit status of a firmware process calling ESP.restart()
+
+typedef void (*SimIsr)();
+
+typedef struct {
+    // Clocks
+    int64_t  monoUs;           // ESP timer, since power on
+    int64_t  trueUs;           // True UTC
+    int32_t  espPpb;           // ESP crystal error, positive runs fast
+    int64_t  espErrorPpb;      // Accumulated fraction of a microsecond, in ppb
+    int64_t  systemClockUs;    // newlib's clock as settimeofday() last set it
+    int64_t  systemClockSetUs; // monoUs at that
+    bool     powered;
+
+    // DS3231
+    bool     rtcPresent;
+    bool     rtcBattery;       // Keeps time while the board is off
+    bool     rtcStopped;       // Oscillator stop flag, set by a power loss without battery
+    int32_t  rtcPpb;           // Crystal error at 25C before the aging offset
+    int8_t   rtcAging;         // Aging offset register, about 0.1 ppm per LSB, positive slows it
+    uint8_t  rtcControl;       // Control register
+    int64_t  rtcBaseUs;        // RTC reading at rtcBaseTrueUs
+    int64_t  rtcBaseTrueUs;
+    int32_t  rtcSqwPin;        // Pin the SQW output is wired to, -1 for none
+    int64_t  rtcLastSqwS;      // Last RTC second the SQW edge was delivered for
+
+    // Network
+    char     networks[SIM_MAX_NETWORKS][32];  // SSIDs in range
+    uint8_t  networkCount;
+    bool     ntpUp;
+    int32_t  ntpDelayUs;       // Round trip, split evenly between the directions
+    int32_t  ntpAsymmetryUs;   // Added to the way out only
+    char     ntpHosts[SIM_MAX_NTP_SERVERS][64];    // Names of the servers in test/support/ntp_server.h
+    uint16_t ntpServerPorts[SIM_MAX_NTP_SERVERS];  // Their localhost ports, 0 while not running
+
+    // Counters
+    uint64_t i2cTransactions;
+    uint64_t fsBytesWritten;   // Handed to LittleFS, all files
+    uint32_t fsFilesWritten;   // Files closed after writing
+    FlashWear fsWear;          // What littlefs programmed and erased for them
+    uint32_t fsRenames;
+    uint32_t fsRemoves;
+    uint64_t displayUpdates;   // MD_MAX72XX::update() calls that changed the matrix
+    uint64_t displayModules;   // Modules whose columns changed
+    uint64_t displayHash;      // FNV-1a over every displayed matrix
+    uint8_t  displayColumns[64];
+    uint8_t  intensity;
+    uint32_t ntpQueries;
+    uint32_t dnsLookups;
+    uint32_t httpRequests;
+    uint32_t boots;
+    uint32_t restarts;         // ESP.restart() calls
+    uint32_t systemClockSets;  // settimeofday() calls
+
+    // Flash
+    char     fsRoot[128];      // Directory holding the LittleFS files
+    uint32_t fsTotalBytes;
+    bool     fsBroken;         // Mounting fails
+
+    bool     serialEcho;       // Serial output to stdout
+} SimBoard;
+
+// A new board: RTC and true time at their defaults, nothing counted yet.
+inline void simBoardDefaults(SimBoard *board) {
+    memset(board, 0, sizeof(SimBoard));
+    board->trueUs = SIM_UTC_DEFAULT_US;
+    board->powered = true;
+    board->rtcPresent = true;
+    board->rtcBattery = true;
+    board->rtcBaseUs = SIM_UTC_DEFAULT_US;
+    board->rtcBaseTrueUs = SIM_UTC_DEFAULT_US;
+    board->rtcControl = 0x1C;  // INTCN set, no square wave
+    board->rtcSqwPin = -1;
+    board->ntpUp = true;
+    board->ntpDelayUs = 20000;
+    board->fsTotalBytes = 1441792;  // ESP32 default partition table
+    board->serialEcho = getenv("SIM_SERIAL") != nullptr;
+    strcpy(board->networks[0], "simnet");
+    board->networkCount = 1;
+}
+
+inline SimBoard *simBoard() {
+    static SimBoard *board = nullptr;
+    if (!board) {
+        void *p = mmap(nullptr, sizeof(SimBoard), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        board = (SimBoard *)(p == MAP_FAILED ? calloc(1, sizeof(SimBoard)) : p);
+        simBoardDefaults(board);
+    }
+    return board;
+}
+
+// Pending work for the shims that wraps time: WiFi events, UDP replies and
+// the SQW interrupt. Registered by the shims that own them.
+typedef struct {
+    void (*poll)();  // Called from delay() and yield(), like a task switch
+} SimHooks;
+
+inline SimHooks &simHooks() {
+    static SimHooks hooks = {};
+    return hooks;
+}
+
+inline SimIsr &simSqwIsr() {
+    static SimIsr isr = nullptr;
+    return isr;
+}
+
+// --- DS3231 time model ---
+inline int64_t simRtcRatePpb() {
+    SimBoard *b = simBoard();
+    return b->rtcPpb - (int64_t)b->rtcAging * 100;
+}
+
+inline int64_t simRtcAt(int64_t trueUs) {
+    SimBoard *b = simBoard();
+    int64_t elapsed = trueUs - b->rtcBaseTrueUs;
+    return b->rtcBaseUs + elapsed + elapsed * simRtcRatePpb() / 1000000000;
+}
+
+inline int64_t simRtcNowUs() {
+    return simRtcAt(simBoard()->trueUs);
+}
+
+// Re-anchor the RTC at the current moment, e.g. before its rate changes.
+inline void simRtcSet(int64_t rtcUs) {
+    SimBoard *b = simBoard();
+    b->rtcBaseUs = rtcUs;
+    b->rtcBaseTrueUs = b->trueUs;
+    b->rtcLastSqwS = rtcUs / 1000000;
+}
+
+// --- Virtual clock ---
+inline void simAdvanceRaw(int64_t us) {
+    SimBoard *b = simBoard();
+    b->monoUs += us;
+    b->espErrorPpb += us * (int64_t)b->espPpb;
+    int64_t error = b->espErrorPpb / 1000000000;
+    b->espErrorPpb -= error * 1000000000;
+    b->trueUs += us - error;
+}
+
+// Let us of ESP time pass, firing the SQW interrupt on every RTC second
+// edge on the way, with the clock stopped right at the edge.
+inline void simAdvance(int64_t us) {
+    SimBoard *b = simBoard();
+    SimIsr isr = simSqwIsr();
+    if (!isr || b->rtcSqwPin < 0 || (b->rtcControl & 0x1C) != 0) {  // 1 Hz needs INTCN and RS1/2 clear
+        simAdvanceRaw(us);
+        return;
+    }
+    while (us > 0) {
+        int64_t nextEdgeUs = (simRtcNowUs() / 1000000 + 1) * 1000000;
+        int64_t step = nextEdgeUs - simRtcNowUs();
+        if (step > us) {
+            simAdvanceRaw(us);
+            return;
+        }
+        simAdvanceRaw(step > 0 ? step : 1);
+        us -= step > 0 ? step : 1;
+        if (simRtcNowUs() / 1000000 > b->rtcLastSqwS) {
+            b->rtcLastSqwS = simRtcNowUs() / 1000000;
+            isr();
+        }
+    }
+}
+
+// A clock read by the firmware: the current time, then time moves on.
+inline int64_t simReadClock() {
+    int64_t now = simBoard()->monoUs;
+    simAdvance(SIM_CLOCK_READ_US);
+    return now;
+}
+
+// The firmware gives up the CPU: other tasks and event callbacks run.
+inline void simYield() {
+    if (simHooks().poll) {
+        simHooks().poll();
+    }
+}
+
+inline void simSleep(int64_t us) {
+    simAdvance(us);
+    simYield();
+}
+
+// An I2C transaction of bytes data bytes (the address byte is added).
+inline void simI2c(uint32_t bytes) {
+    simBoard()->i2cTransactions++;
+    simAdvance((int64_t)(bytes + 1) * SIM_I2C_BYTE_US + 10);
+}
+
+#endif // SIM_BOARD_H
@@ -0,0 +1,58 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Microbenchmarks for the native tests. A body runs in batches until
+// BENCH_MIN_NS of host time passed; the result is the time per call, and
+// each benchmark prints one "BENCH" line so the runs can be compared with
+// grep. Host numbers only rank alternatives, they are no ESP timings.
+
+#define BENCH_MIN_NS 200000000LL  // 0.2 s per measurement
+
+inline int64_t benchNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// CPU time of this process, for work that sleeps or waits in between.
+inline int64_t benchCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Results go here so the compiler can't drop the work that produced them.
+inline volatile uint64_t benchSink;
+
+// Nanoseconds per call of body(i), i counting calls.
+template <typename Body>
+double benchRun(const char *name, Body body) {
+    uint64_t calls = 0;
+    uint64_t batch = 1;
+    int64_t start = benchNowNs();
+    int64_t elapsed = 0;
+    while (elapsed < BENCH_MIN_NS) {
+        for (uint64_t i = 0; i < batch; i++) {
+            body(calls + i);
+        }
+        calls += batch;
+        batch *= 2;
+        elapsed = benchNowNs() - start;
+    }
+    double ns = (double)elapsed / (double)calls;
+    printf("BENCH %s: %.1f ns/op (%llu ops)\n", name, ns, (unsigned long long)calls);
+    return ns;
+}
+
+// Prints how much faster than before now is, and returns the factor.
+inline double benchSpeedup(const char *name, double beforeNs, double nowNs) {
+    double factor = beforeNs / nowNs;
+    printf("BENCH %s: %.2fx\n", name, factor);
+    return factor;
+}
+
+#endif // BENCH_H
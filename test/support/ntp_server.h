@@ -0,0 +1,139 @@
+#ifndef NTP_SERVER_H
+#define NTP_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <WiFiUdp.h>
+#include "ntp_packet.h"
+#include "sim_board.h"
+
+// A stand-in NTP server for the firmware on the simulated board: a real UDP
+// socket on a localhost port, answering from its own thread. It keeps the
+// board's true time plus offsetUs and polices its clients like the public
+// servers do: a query closer than rateLimitUs to the previous one gets a
+// RATE kiss-o'-death, and with kiss set every query gets that code. It
+// records the shortest interval it saw between queries.
+//
+// simNtpServe() starts it under a name the firmware resolves to it. Start
+// it inside the simPowerOn() scenario, threads don't survive the fork.
+
+struct SimNtpServer {
+    int64_t     offsetUs    = 0;
+    uint8_t     stratum     = 1;
+    int64_t     rateLimitUs = 4000000;  // NIST: no more than one query per 4 s
+    const char *kiss        = nullptr;  // "DENY", "RSTR", ... for every query
+
+    std::atomic<uint32_t> queries{0};
+    std::atomic<uint32_t> kisses{0};
+    std::atomic<int64_t>  minIntervalUs{INT64_MAX};  // True time between queries
+
+    uint16_t port = 0;
+
+    bool start() {
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (fd_ < 0 || bind(fd_, (sockaddr *)&addr, sizeof(addr)) != 0 || getsockname(fd_, (sockaddr *)&addr, &len) != 0) {
+            return false;
+        }
+        port = ntohs(addr.sin_port);
+        stop_ = false;
+        thread_ = std::thread([this] { serve(); });
+        return true;
+    }
+
+    void stop() {
+        stop_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    ~SimNtpServer() { stop(); }
+
+private:
+    void serve() {
+        while (!stop_) {
+            pollfd p = {fd_, POLLIN, 0};
+            if (poll(&p, 1, 20) <= 0) {
+                continue;
+            }
+            uint8_t req[NTP_PACKET_SIZE];
+            sockaddr_in from = {};
+            socklen_t fromLen = sizeof(from);
+            ssize_t n = recvfrom(fd_, req, sizeof(req), 0, (sockaddr *)&from, &fromLen);
+            if (n != NTP_PACKET_SIZE || (req[0] & 0x07) != 3) {
+                continue;
+            }
+            uint8_t reply[NTP_PACKET_SIZE];
+            answer(req, reply);
+            sendto(fd_, reply, sizeof(reply), 0, (sockaddr *)&from, fromLen);
+        }
+    }
+
+    // The firmware waits for the answer, so the board's clock stands still.
+    void answer(const uint8_t *req, uint8_t *reply) {
+        SimBoard *b = simBoard();
+        int64_t trueUs = b->trueUs + b->ntpDelayUs / 2 + b->ntpAsymmetryUs;
+        queries++;
+        const char *code = kiss;
+        if (lastUs_ != 0) {
+            int64_t interval = trueUs - lastUs_;
+            if (interval < minIntervalUs) {
+                minIntervalUs = interval;
+            }
+            if (interval < rateLimitUs && !code) {
+                code = "RATE";
+            }
+        }
+        lastUs_ = trueUs;
+
+        int64_t receiveUs = trueUs + offsetUs;
+        memset(reply, 0, NTP_PACKET_SIZE);
+        memcpy(&reply[24], &req[40], 8);
+        ntpWriteTimestamp(&reply[32], receiveUs);
+        ntpWriteTimestamp(&reply[40], receiveUs + SIM_NTP_PROCESSING_US);
+        if (code) {
+            kisses++;
+            reply[0] = 0xE4;  // LI 3 (unsynchronized), VN 4, mode 4
+            memcpy(&reply[12], code, 4);
+            return;
+        }
+        reply[0] = 0x24;      // LI 0, VN 4, mode 4
+        reply[1] = stratum;
+        reply[3] = 0xEC;      // 2^-20 s precision
+        memcpy(&reply[12], "GPS", 3);
+        ntpWriteTimestamp(&reply[16], receiveUs - 8000000);
+    }
+
+    int               fd_     = -1;
+    std::thread       thread_;
+    std::atomic<bool> stop_{false};
+    int64_t           lastUs_ = 0;
+};
+
+// Start server as the board's NTP server ix, reached under host.
+inline bool simNtpServe(uint8_t ix, const char *host, SimNtpServer &server) {
+    if (ix >= SIM_MAX_NTP_SERVERS || !server.start()) {
+        return false;
+    }
+    SimBoard *b = simBoard();
+    strlcpy(b->ntpHosts[ix], host, sizeof(b->ntpHosts[ix]));
+    b->ntpServerPorts[ix] = server.port;
+    return true;
+}
+
+#endif // NTP_SERVER_H
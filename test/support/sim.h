@@ -0,0 +1,191 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <LittleFS.h>
+#include <RTClib.h>
+#include <unity.h>
+#include "bench.h"
+#include "sim_board.h"
+
+// The firmware (src/main.cpp) on the simulated board, for tests that run
+// it for hours or months of virtual time. Each power on runs in a child
+// process, so it starts from the firmware's initial globals like a real
+// boot, while the board in shared memory (clocks, RTC, flash, counters)
+// carries over. ESP.restart() ends the child with SIM_EXIT_RESTART and the
+// board is powered on again; between power ons the test can change the
+// board or leave it off for a while, the RTC running on its battery.
+//
+// Every frame the firmware renders is recorded with its virtual time, and
+// also written to the file SIM_FRAMES names, if set. simReport() gives the
+// cost of a stretch of running: host CPU per simulated second, flash bytes
+// per simulated day and I2C transactions per second.
+
+#define SIM_BOOT_US 300000  // ROM and second stage bootloader
+
+void setup();
+void loop();
+extern char lastFrame[24];
+extern AsyncWebServer server;
+
+typedef struct {
+    int64_t monoUs;
+    int64_t trueUs;
+    char    text[24];
+} SimFrame;
+
+typedef struct {
+    int64_t  monoUs;
+    int64_t  cpuNs;
+    uint64_t fsBytes;
+    uint64_t programmedBytes;
+    uint32_t erases;
+    uint64_t i2c;
+    size_t   frames;
+} SimSnapshot;
+
+typedef struct {
+    double simSeconds;
+    double cpuUsPerSimSecond;     // Host CPU, firmware and shims
+    double flashBytesPerDay;      // Handed to LittleFS
+    double programmedBytesPerDay; // What littlefs programs for that (flash_wear.h model)
+    double erasesPerDay;
+    double i2cPerSecond;
+    size_t frames;
+} SimReport;
+
+inline std::vector<SimFrame> &simFrames() {
+    static std::vector<SimFrame> frames;
+    return frames;
+}
+
+inline void simRecordFrame() {
+    static char last[24] = "";
+    if (strcmp(last, lastFrame) == 0) {
+        return;
+    }
+    strlcpy(last, lastFrame, sizeof(last));
+    SimFrame f;
+    f.monoUs = simBoard()->monoUs;
+    f.trueUs = simBoard()->trueUs;
+    strlcpy(f.text, lastFrame, sizeof(f.text));
+    simFrames().push_back(f);
+    static FILE *log = getenv("SIM_FRAMES") ? fopen(getenv("SIM_FRAMES"), "a") : nullptr;
+    if (log) {
+        fprintf(log, "%lld %lld %s\n", (long long)f.trueUs, (long long)f.monoUs, f.text);
+    }
+}
+
+// Run the firmware's loop for us of virtual time.
+inline void simRunFor(int64_t us) {
+    SimBoard *b = simBoard();
+    int64_t end = b->monoUs + us;
+    while (b->monoUs < end) {
+        loop();
+        simRecordFrame();
+    }
+}
+
+// Index of the first frame from from on showing text, with a blinking colon
+// read as shown (' ' as ':', '^' as '+'). -1 if none did.
+inline int simFindFrame(const char *text, size_t from = 0) {
+    const std::vector<SimFrame> &frames = simFrames();
+    for (size_t i = from; i < frames.size(); i++) {
+        char shown[24];
+        strlcpy(shown, frames[i].text, sizeof(shown));
+        for (char *p = shown; *p; p++) {
+            *p = *p == ' ' ? ':' : *p == '^' ? '+' : *p;
+        }
+        if (strcmp(shown, text) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+inline SimSnapshot simSnapshot() {
+    SimBoard *b = simBoard();
+    return {b->monoUs, benchCpuNs(), b->fsBytesWritten, b->fsWear.physicalBytes, b->fsWear.erases,
+            b->i2cTransactions, simFrames().size()};
+}
+
+// What running since from cost, printed as one SIM line.
+inline SimReport simReport(const char *name, const SimSnapshot &from) {
+    SimSnapshot now = simSnapshot();
+    SimReport r;
+    r.simSeconds = (now.monoUs - from.monoUs) / 1e6;
+    double days = r.simSeconds / 86400;
+    r.cpuUsPerSimSecond = (now.cpuNs - from.cpuNs) / 1e3 / r.simSeconds;
+    r.flashBytesPerDay = (now.fsBytes - from.fsBytes) / days;
+    r.programmedBytesPerDay = (now.programmedBytes - from.programmedBytes) / days;
+    r.erasesPerDay = (now.erases - from.erases) / days;
+    r.i2cPerSecond = (now.i2c - from.i2c) / r.simSeconds;
+    r.frames = now.frames - from.frames;
+    printf("SIM %s: %.0f s simulated, %.1f us CPU/s, %.0f B/day written (%.0f B/day programmed, %.0f erases/day), "
+           "%.3f I2C/s, %zu frames\n",
+           name, r.simSeconds, r.cpuUsPerSimSecond, r.flashBytesPerDay, r.programmedBytesPerDay, r.erasesPerDay,
+           r.i2cPerSecond, r.frames);
+    fflush(stdout);
+    return r;
+}
+
+// Leave the board off for us: true time and the RTC go on, the ESP timer
+// starts over at the next power on. Without its battery the RTC stops and
+// reports the power loss.
+inline void simPowerOff(int64_t us) {
+    SimBoard *b = simBoard();
+    b->trueUs += us;
+    if (!b->rtcBattery) {
+        simRtcSet((int64_t)SECONDS_FROM_1970_TO_2000 * 1000000);
+        b->rtcStopped = true;
+    }
+}
+
+// Power the board on: setup(), then scenario(boot) drives the loop with
+// simRunFor(); boot counts the power ons of the board. A restart powers it
+// on again, up to maxBoots. Returns the exit status of the last power on:
+// 0 when the scenario returned, 1 when an assertion in it failed.
+inline int simPowerOn(void (*scenario)(uint32_t boot), uint32_t maxBoots = 4) {
+    for (;;) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            SimBoard *b = simBoard();
+            b->boots++;
+            b->monoUs = 0;
+            simAdvanceRaw(SIM_BOOT_US);
+            int status = 1;
+            if (TEST_PROTECT()) {
+                setup();
+                scenario(b->boots);
+                status = 0;
+            }
+            fflush(stdout);
+            _Exit(status);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        if (code != SIM_EXIT_RESTART || simBoard()->boots >= maxBoots) {
+            return code;
+        }
+    }
+}
+
+// A new board, with its flash erased.
+inline void simBoardReset() {
+    SimBoard *b = simBoard();
+    simFsErase();
+    char fsRoot[sizeof(b->fsRoot)];
+    strlcpy(fsRoot, b->fsRoot, sizeof(fsRoot));
+    simBoardDefaults(b);
+    strlcpy(b->fsRoot, fsRoot, sizeof(b->fsRoot));
+}
+
+#endif // SIM_H
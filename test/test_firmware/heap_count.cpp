@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+
+// The global allocation functions, counting the bytes handed out while
+// heapCounting is set. In a file of their own, so their malloc() and
+// free() aren't inlined into code GCC sees allocate with new.
+uint64_t heapBytes;
+bool     heapCounting;
+
+void *operator new(size_t size) {
+    if (heapCounting) {
+        heapBytes += size;
+    }
+    void *p = malloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
@@ -0,0 +1,303 @@
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <LittleFS.h>
+#include <unity.h>
+#include <unistd.h>
+#include "bench.h"
+#include "flash_wear.h"
+#include "metrics.h"
+
+// The firmware itself (src/main.cpp, linked in by test_build_src) booted
+// once on the shims, then exercised through its loop and web server.
+
+void setup();
+void loop();
+extern char lastFrame[24];
+extern AsyncWebServer server;
+extern uint32_t ticksMissed;
+extern portMUX_TYPE timeSourceMux;
+extern FlashWear flashWear;
+
+void setUp() {}
+void tearDown() {}
+
+static void runFor(int64_t us) {
+    int64_t end = simBoard()->monoUs + us;
+    while (simBoard()->monoUs < end) {
+        loop();
+    }
+}
+
+// The RTC keeps time from the board's default, 2025-06-15 15:06:40 UTC.
+void test_boot_shows_rtc_time() {
+    runFor(3000000);
+    char expected[24];
+    time_t now = (time_t)(simBoard()->trueUs / 1000000);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    strftime(expected, sizeof(expected), "%H:%M:%S", &tm);
+    TEST_ASSERT_EQUAL_STRING(expected, lastFrame);
+    TEST_ASSERT_GREATER_THAN(0, simBoard()->displayUpdates);
+}
+
+void test_health_and_config() {
+    SimHttpResponse r = server.simRequest(HTTP_GET, "/health");
+    TEST_ASSERT_EQUAL(204, r.code);
+    r = server.simRequest(HTTP_GET, "/config.json");
+    TEST_ASSERT_EQUAL(200, r.code);
+    TEST_ASSERT_NOT_NULL(strstr(r.body.c_str(), "\"ntpServer1\":\"pool.ntp.org\""));
+    TEST_ASSERT_NOT_NULL(r.header("ETag"));
+    r = server.simRequest(HTTP_GET, "/config.json", {}, "", {{"If-None-Match", r.header("ETag")}});
+    TEST_ASSERT_EQUAL(304, r.code);
+    TEST_ASSERT_EQUAL(404, server.simRequest(HTTP_GET, "/nope").code);
+}
+
+// A change answers at once and reaches flash after configWriteDelay.
+void test_setting_is_saved() {
+    uint32_t files = simBoard()->fsFilesWritten;
+    SimHttpResponse r = server.simRequest(HTTP_POST, "/set_brightness", {{"value", "3"}});
+    TEST_ASSERT_EQUAL(200, r.code);
+    TEST_ASSERT_NOT_NULL(strstr(r.body.c_str(), "\"brightness\":3"));
+    TEST_ASSERT_EQUAL_UINT8(3, simBoard()->intensity);
+    TEST_ASSERT_EQUAL_UINT32(files, simBoard()->fsFilesWritten);
+    runFor(2500000);
+    TEST_ASSERT_GREATER_THAN(files, simBoard()->fsFilesWritten);
+    TEST_ASSERT_EQUAL(400, server.simRequest(HTTP_POST, "/set_brightness").code);
+}
+
+void test_countdown() {
+    TEST_ASSERT_EQUAL(409, server.simRequest(HTTP_POST, "/add_seconds", {{"seconds", "90"}}).code);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/start").code);
+    int64_t target = simBoard()->trueUs / 1000000 + 90;
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/add_seconds", {{"seconds", "90"}}).code);
+    runFor(1700000);
+    char expected[24];
+    snprintf(expected, sizeof(expected), "0:01:%02d", (int)(target - simBoard()->trueUs / 1000000 - 60));
+    char shown[24];
+    strlcpy(shown, lastFrame, sizeof(shown));
+    std::replace(shown, shown + strlen(shown), ' ', ':');  // The colon blinks
+    TEST_ASSERT_EQUAL_STRING(expected, shown);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/stop").code);
+}
+
+static void setTime(int64_t epochUs) {
+    char epochMs[24];
+    snprintf(epochMs, sizeof(epochMs), "%lld", (long long)(epochUs / 1000));
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/set_time", {{"epochMs", epochMs}}).code);
+}
+
+// Edges a step jumps over were never due, unlike edges a busy loop let pass.
+void test_clock_step_is_no_missed_tick() {
+    uint32_t missed = ticksMissed;
+    setTime(simBoard()->trueUs + 86400000000LL);
+    runFor(2000000);
+    setTime(simBoard()->trueUs);
+    runFor(2000000);
+    TEST_ASSERT_EQUAL_UINT32(missed, ticksMissed);
+}
+
+int64_t timeNowUs();
+
+// newlib's clock follows the time source, set at a step and kept up once a
+// minute, for time() and the libraries' timestamps.
+void test_system_clock_follows_time_source() {
+    setTime(simBoard()->trueUs + 5000000);
+    TEST_ASSERT_INT64_WITHIN(1000, timeNowUs(), simSystemClockUs());
+    uint32_t sets = simBoard()->systemClockSets;
+    runFor(61000000);
+    TEST_ASSERT_GREATER_THAN(sets, simBoard()->systemClockSets);
+    TEST_ASSERT_INT64_WITHIN(1000, timeNowUs(), simSystemClockUs());
+    setTime(simBoard()->trueUs);
+}
+
+// Handlers run on the async_tcp task on the ESP32, every time access of
+// theirs has to leave the time source unlocked again.
+void test_time_source_lock_released() {
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/start").code);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/add_seconds", {{"seconds", "60"}}).code);
+    setTime(simBoard()->trueUs);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/stats").code);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/stop").code);
+    runFor(1000000);
+    TEST_ASSERT_EQUAL_INT32(0, timeSourceMux.depth);
+}
+
+// Without erases there is no rate to project a lifetime from.
+void test_wear_lifetime_unknown() {
+    FlashWear saved = flashWear;
+    flashWear = {};
+    SimHttpResponse r = server.simRequest(HTTP_GET, "/wear");
+    flashWear = saved;
+    TEST_ASSERT_EQUAL(200, r.code);
+    TEST_ASSERT_TRUE(r.body.find("\"files\":0,\"sessions\":0,") != std::string::npos);
+    TEST_ASSERT_TRUE(r.body.find("\"lifetimeYears\":null}") != std::string::npos);
+}
+
+// The settings as a boot reads them and a save writes them: the binary
+// record against the config.json backend, which stays the default until a
+// board shows the gain. A save costs flash too, what littlefs programs for
+// it is printed along.
+bool loadConfigBinary();
+void loadConfigJson();
+String saveConfigBinary();
+String saveConfigJson();
+
+// Board time one load or save takes, the flash reads and writes the shims
+// charge for.
+static int64_t boardUsFor(void (*body)()) {
+    int64_t before = simBoard()->monoUs;
+    body();
+    return simBoard()->monoUs - before;
+}
+
+void bench_config_load() {
+    saveConfigJson();
+    double json = benchRun("config load, config.json", [](uint64_t) { loadConfigJson(); });
+    double binary = benchRun("config load, binary record", [](uint64_t) { benchSink += loadConfigBinary(); });
+    benchSpeedup("config load", json, binary);
+    printf("BENCH config load on the board: %lld us config.json, %lld us binary record\n",
+           (long long)boardUsFor([] { loadConfigJson(); }), (long long)boardUsFor([] { loadConfigBinary(); }));
+}
+
+// Bytes littlefs programs for one save.
+static uint64_t programmedBy(String (*save)()) {
+    uint64_t before = simBoard()->fsWear.physicalBytes;
+    save();
+    return simBoard()->fsWear.physicalBytes - before;
+}
+
+void bench_config_save() {
+    double json = benchRun("config save, config.json", [](uint64_t) { benchSink += saveConfigJson().length(); });
+    double binary = benchRun("config save, binary record", [](uint64_t) { benchSink += saveConfigBinary().length(); });
+    benchSpeedup("config save", json, binary);
+    printf("BENCH config save programs: %llu B config.json, %llu B binary record\n",
+           (unsigned long long)programmedBy(saveConfigJson), (unsigned long long)programmedBy(saveConfigBinary));
+    printf("BENCH config save on the board: %lld us config.json, %lld us binary record\n",
+           (long long)boardUsFor([] { saveConfigJson(); }), (long long)boardUsFor([] { saveConfigBinary(); }));
+}
+
+extern MetricsHistogram metricsLoop;
+
+// The loop histogram is the work of the iterations, not the sleeping and
+// spinning until the next edge that takes up most of the clock's time.
+void test_loop_metrics_leave_out_the_wait() {
+    MetricsHistogram before = metricsLoop;
+    runFor(10000000);
+    uint64_t loopUs = metricsLoop.sumUs - before.sumUs;
+    TEST_ASSERT_GREATER_THAN(before.count, metricsLoop.count);
+    TEST_ASSERT_LESS_THAN(500000, loopUs);
+}
+
+struct SaveKey;
+const SaveKey *findSaveKey(const char *name, int *index);
+
+// The fields the settings page posts to /save.
+static const char *const saveFields[] = {
+    "ssid0", "password0", "ssid1", "password1", "ssid2", "password2", "ssid3", "password3", "ssid4", "password4",
+    "ssid5", "password5", "ssid6", "password6", "ssid7", "password7", "ssid8", "password8", "ssid9", "password9",
+    "mdns", "apSsid", "apPassword", "timeZone", "brightness", "flipDisplay", "twelveHour", "ntpServer1",
+    "ntpServer2", "countupdownDate", "countupdownTime",
+};
+const size_t saveFieldCount = sizeof(saveFields) / sizeof(saveFields[0]);
+
+// How /save told its fields apart before the key table: both copied into
+// Strings, the name compared down an if/else ladder.
+static int saveLadder(const char *name, const char *value) {
+    String n = name;
+    String v = value;
+    if (n == "brightness") return 0;
+    else if (n == "flipDisplay") return 1;
+    else if (n == "twelveHour") return 2;
+    else if (n == "password0" || n == "password1" || n == "password2" || n == "password3" || n == "password4" ||
+             n == "password5" || n == "password6" || n == "password7" || n == "password8" || n == "password9")
+        return 10 + n.substring(8).toInt() + (int)v.length();
+    else if (n == "ssid0" || n == "ssid1" || n == "ssid2" || n == "ssid3" || n == "ssid4" ||
+             n == "ssid5" || n == "ssid6" || n == "ssid7" || n == "ssid8" || n == "ssid9")
+        return 20 + n.substring(4).toInt() + (int)v.length();
+    else if (n == "ntpServer1") return 3;
+    else if (n == "ntpServer2") return 4;
+    else if (n == "timeZone") return 5;
+    else if (n == "mdns") return 6;
+    else if (n == "countupdownDate") return 7;
+    else if (n == "countupdownTime") return 8;
+    else if (n == "apSsid") return 9;
+    else if (n == "apPassword") return 30;
+    return -1;
+}
+
+void bench_save_keys() {
+    int index = -1;
+    for (const char *field : saveFields) {
+        TEST_ASSERT_NOT_NULL_MESSAGE(findSaveKey(field, &index), field);
+    }
+    TEST_ASSERT_NULL(findSaveKey("ssid", &index));
+    TEST_ASSERT_NULL(findSaveKey("brightness0", &index));
+    double ladder = benchRun("save field, if/else ladder", [](uint64_t i) {
+        benchSink += saveLadder(saveFields[i % saveFieldCount], "value");
+    });
+    double table = benchRun("save field, sorted key table", [&](uint64_t i) {
+        benchSink += (uintptr_t)findSaveKey(saveFields[i % saveFieldCount], &index);
+    });
+    benchSpeedup("save field lookup", ladder, table);
+}
+
+// Heap bytes handed out (heap_count.cpp), for what a request costs the
+// ESP's heap. The shims allocate too, so only differences between runs
+// mean something.
+extern uint64_t heapBytes;
+extern bool heapCounting;
+
+extern uint8_t stateBuffersTaken;
+
+static uint64_t heapBytesFor(const char *url) {
+    uint64_t before = heapBytes;
+    heapCounting = true;
+    int code = server.simRequest(HTTP_POST, url, {{"value", "0"}}).code;
+    heapCounting = false;
+    TEST_ASSERT_EQUAL(200, code);
+    return heapBytes - before;
+}
+
+// A control request sending the state from a state buffer against the
+// copy its response made before, which is still what happens with all
+// buffers taken.
+void bench_state_heap() {
+    uint64_t buffered = heapBytesFor("/set_lock");
+    TEST_ASSERT_EQUAL_UINT8(0, stateBuffersTaken);
+    stateBuffersTaken = 0x0F;
+    uint64_t copied = heapBytesFor("/set_lock");
+    stateBuffersTaken = 0;
+    printf("BENCH state response heap: %llu B per request copied, %llu B from a state buffer\n",
+           (unsigned long long)copied, (unsigned long long)buffered);
+    TEST_ASSERT_LESS_THAN(copied, buffered);
+}
+
+// Host time for a simulated second of the running clock.
+void bench_loop() {
+    int64_t start = benchNowNs();
+    runFor(60000000);
+    printf("BENCH firmware loop: %.1f us host time per simulated second\n", (benchNowNs() - start) / 60.0 / 1000);
+}
+
+int main() {
+    setup();
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_shows_rtc_time);
+    RUN_TEST(test_health_and_config);
+    RUN_TEST(test_setting_is_saved);
+    RUN_TEST(test_countdown);
+    RUN_TEST(test_clock_step_is_no_missed_tick);
+    RUN_TEST(test_system_clock_follows_time_source);
+    RUN_TEST(test_time_source_lock_released);
+    RUN_TEST(test_wear_lifetime_unknown);
+    RUN_TEST(test_loop_metrics_leave_out_the_wait);
+    RUN_TEST(bench_save_keys);
+    RUN_TEST(bench_state_heap);
+    RUN_TEST(bench_config_load);
+    RUN_TEST(bench_config_save);
+    RUN_TEST(bench_loop);
+    int failures = UNITY_END();
+    simFsErase();
+    rmdir(simFsPath("").c_str());
+    return failures;
+}
@@ -0,0 +1,83 @@
+#include <unity.h>
+#include "bench.h"
+#include "form_parse.h"
+#include "json_writer.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_nesting_and_commas() {
+    char buf[128];
+    JsonWriter w;
+    jsonInit(&w, buf, sizeof(buf));
+    jsonObjectBegin(&w);
+    jsonInt(&w, "a", -5);
+    jsonArrayBegin(&w, "b");
+    jsonBool(&w, nullptr, true);
+    jsonString(&w, nullptr, "x");
+    jsonObjectBegin(&w);
+    jsonObjectEnd(&w);
+    jsonArrayEnd(&w);
+    jsonString(&w, "c", "");
+    jsonObjectEnd(&w);
+    TEST_ASSERT_FALSE(w.overflow);
+    TEST_ASSERT_EQUAL_STRING("{\"a\":-5,\"b\":[true,\"x\",{}],\"c\":\"\"}", buf);
+}
+
+void test_escapes() {
+    char buf[64];
+    JsonWriter w;
+    jsonInit(&w, buf, sizeof(buf));
+    jsonString(&w, nullptr, "a\"b\\c\nd\x01");
+    TEST_ASSERT_EQUAL_STRING("\"a\\\"b\\\\c\\nd\\u0001\"", buf);
+}
+
+void test_overflow_truncates() {
+    char buf[8];
+    JsonWriter w;
+    jsonInit(&w, buf, sizeof(buf));
+    jsonString(&w, "key", "value");
+    TEST_ASSERT_TRUE(w.overflow);
+    TEST_ASSERT_EQUAL_STRING("\"key\":\"", buf);
+}
+
+void test_form_values() {
+    TEST_ASSERT_TRUE(formBool("on"));
+    TEST_ASSERT_TRUE(formBool("true"));
+    TEST_ASSERT_FALSE(formBool("off"));
+    struct tm tm;
+    TEST_ASSERT_TRUE(parseLocalDateTime("2025-06-15T15:06", &tm));
+    TEST_ASSERT_EQUAL(125, tm.tm_year);
+    TEST_ASSERT_EQUAL(5, tm.tm_mon);
+    TEST_ASSERT_EQUAL(0, tm.tm_sec);
+    TEST_ASSERT_TRUE(parseLocalDateTime("2025-06-15 15:06:40", &tm));
+    TEST_ASSERT_EQUAL(40, tm.tm_sec);
+    TEST_ASSERT_FALSE(parseLocalDateTime("2025-13-15 15:06", &tm));
+    TEST_ASSERT_FALSE(parseLocalDateTime("2025-06-15 15:06:4", &tm));
+    TEST_ASSERT_FALSE(parseLocalDateTime("2025-06-15 15:06x", &tm));
+}
+
+void bench_state_json() {
+    char buf[160];
+    JsonWriter w;
+    benchRun("JsonWriter, state object", [&](uint64_t i) {
+        jsonInit(&w, buf, sizeof(buf));
+        jsonObjectBegin(&w);
+        jsonInt(&w, "brightness", (int64_t)(i & 15));
+        jsonBool(&w, "flipDisplay", i & 1);
+        jsonBool(&w, "twelveHour", true);
+        jsonInt(&w, "countUpDownTarget", 1750000000 + (int64_t)i);
+        jsonObjectEnd(&w);
+        benchSink += w.len;
+    });
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nesting_and_commas);
+    RUN_TEST(test_escapes);
+    RUN_TEST(test_overflow_truncates);
+    RUN_TEST(test_form_values);
+    RUN_TEST(bench_state_json);
+    return UNITY_END();
+}
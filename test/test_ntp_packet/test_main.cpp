@@ -0,0 +1,102 @@
+#include <unity.h>
+#include "bench.h"
+#include "ntp_packet.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void serverReply(uint8_t *reply, const uint8_t *request, int64_t receiveUs, int64_t transmitUs, uint8_t stratum) {
+    memset(reply, 0, NTP_PACKET_SIZE);
+    reply[0] = 0x24;  // LI 0, VN 4, mode 4
+    reply[1] = stratum;
+    memcpy(&reply[24], &request[40], 8);
+    ntpWriteTimestamp(&reply[32], receiveUs);
+    ntpWriteTimestamp(&reply[40], transmitUs);
+}
+
+void test_timestamp_round_trip() {
+    const int64_t times[] = {0, 1750000000123456LL, 2085978495999999LL, 2085978496000000LL, 2500000000000001LL};
+    for (int64_t t : times) {
+        uint8_t p[8];
+        ntpWriteTimestamp(p, t);
+        TEST_ASSERT_EQUAL_INT64(t, ntpReadTimestamp(p));
+    }
+}
+
+void test_request() {
+    uint8_t req[NTP_PACKET_SIZE];
+    ntpBuildRequest(req, 1750000000000000LL);
+    TEST_ASSERT_EQUAL_HEX8(0x23, req[0]);
+    TEST_ASSERT_EQUAL_INT64(1750000000000000LL, ntpReadTimestamp(&req[40]));
+}
+
+// Server 300 ms ahead, 40 ms each way, 1 ms processing.
+void test_offset_and_delay() {
+    uint8_t req[NTP_PACKET_SIZE], reply[NTP_PACKET_SIZE];
+    int64_t t1 = 1750000000000000LL;
+    ntpBuildRequest(req, t1);
+    serverReply(reply, req, t1 + 40000 + 300000, t1 + 41000 + 300000, 2);
+    NtpSample s;
+    TEST_ASSERT_TRUE(ntpParseReply(reply, sizeof(reply), req, t1, t1 + 81000, &s));
+    TEST_ASSERT_EQUAL_INT64(300000, s.offsetUs);
+    TEST_ASSERT_EQUAL_INT64(80000, s.delayUs);
+    TEST_ASSERT_EQUAL_UINT8(2, s.stratum);
+}
+
+void test_rejects_bad_replies() {
+    uint8_t req[NTP_PACKET_SIZE], reply[NTP_PACKET_SIZE];
+    int64_t t1 = 1750000000000000LL;
+    ntpBuildRequest(req, t1);
+    NtpSample s;
+    serverReply(reply, req, t1, t1, 0);  // Kiss-o'-death
+    TEST_ASSERT_FALSE(ntpParseReply(reply, sizeof(reply), req, t1, t1 + 1000, &s));
+    serverReply(reply, req, t1, t1, 1);
+    reply[0] = 0xE4;                     // Unsynchronized
+    TEST_ASSERT_FALSE(ntpParseReply(reply, sizeof(reply), req, t1, t1 + 1000, &s));
+    serverReply(reply, req, t1, t1, 1);
+    reply[31]++;                         // Answers another request
+    reply[47]++;
+    reply[24] ^= 1;
+    TEST_ASSERT_FALSE(ntpParseReply(reply, sizeof(reply), req, t1, t1 + 1000, &s));
+    serverReply(reply, req, t1, t1, 1);
+    TEST_ASSERT_FALSE(ntpParseReply(reply, NTP_PACKET_SIZE - 1, req, t1, t1 + 1000, &s));
+}
+
+void bench_parse_reply() {
+    uint8_t req[NTP_PACKET_SIZE], reply[NTP_PACKET_SIZE];
+    int64_t t1 = 1750000000000000LL;
+    ntpBuildRequest(req, t1);
+    serverReply(reply, req, t1 + 20000, t1 + 20030, 1);
+    NtpSample s;
+    benchRun("ntpParseReply", [&](uint64_t i) {
+        benchSink += ntpParseReply(reply, sizeof(reply), req, t1, t1 + 40030 + (int64_t)(i & 1023), &s);
+    });
+}
+
+void test_kiss_of_death() {
+    uint8_t req[NTP_PACKET_SIZE], reply[NTP_PACKET_SIZE];
+    int64_t t1 = 1750000000000000LL;
+    ntpBuildRequest(req, t1);
+    char code[5];
+    serverReply(reply, req, t1, t1, 0);
+    reply[0] = 0xE4;  // LI 3, as servers send it
+    memcpy(&reply[12], "RATE", 4);
+    TEST_ASSERT_TRUE(ntpIsKiss(reply, sizeof(reply), req, code));
+    TEST_ASSERT_EQUAL_STRING("RATE", code);
+    serverReply(reply, req, t1, t1, 2);
+    TEST_ASSERT_FALSE(ntpIsKiss(reply, sizeof(reply), req, code));
+    serverReply(reply, req, t1, t1, 0);
+    reply[24] ^= 1;   // Someone else's
+    TEST_ASSERT_FALSE(ntpIsKiss(reply, sizeof(reply), req, code));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_timestamp_round_trip);
+    RUN_TEST(test_request);
+    RUN_TEST(test_offset_and_delay);
+    RUN_TEST(test_rejects_bad_replies);
+    RUN_TEST(test_kiss_of_death);
+    RUN_TEST(bench_parse_reply);
+    return UNITY_END();
+}
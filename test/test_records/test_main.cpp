@@ -0,0 +1,250 @@
+#include <ArduinoJson.h>
+#include <unity.h>
+#include "bench.h"
+#include "config_store.h"
+#include "crc32.h"
+#include "flash_wear.h"
+#include "runtime_journal.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_crc32_check_value() {
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32Compute("123456789", 9));
+    uint32_t split = crc32Compute("12345", 5);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32Compute("6789", 4, split));
+}
+
+// A test layout: a number, a string and a flag, packed in that order.
+struct TestSettings {
+    int32_t brightness;
+    char    timeZone[64];
+    uint8_t flip;
+};
+
+static void packTest(ConfigRecord *rec, const TestSettings &s, int fields = 3) {
+    ConfigPacker pk = configPacker(rec);
+    configPackBytes(&pk, &s.brightness, sizeof(s.brightness));
+    if (fields > 1) configPackString(&pk, s.timeZone, sizeof(s.timeZone));
+    if (fields > 2) configPackBytes(&pk, &s.flip, sizeof(s.flip));
+    configRecordSeal(rec, configPacked(&pk));
+}
+
+static bool unpackTest(const ConfigRecord *rec, TestSettings *s) {
+    memset(s, 0xAA, sizeof(*s));
+    ConfigUnpacker u = configUnpacker(rec);
+    configUnpackBytes(&u, &s->brightness, sizeof(s->brightness));
+    configUnpackString(&u, s->timeZone, sizeof(s->timeZone));
+    configUnpackBytes(&u, &s->flip, sizeof(s->flip));
+    return !u.torn;
+}
+
+void test_config_record_round_trip() {
+    static ConfigRecord rec;
+    TestSettings s = {7, "Europe/Berlin", 1};
+    packTest(&rec, s);
+    size_t length = configRecordLength(&rec);
+    TEST_ASSERT_EQUAL(CONFIG_HEADER_SIZE + 4 + 1 + 13 + 1, length);  // Strings take their length
+    TEST_ASSERT_TRUE(configRecordValid(&rec, length));
+    TEST_ASSERT_FALSE(configRecordValid(&rec, length - 1));  // Torn write
+    TestSettings out;
+    TEST_ASSERT_TRUE(unpackTest(&rec, &out));
+    TEST_ASSERT_EQUAL_INT32(7, out.brightness);
+    TEST_ASSERT_EQUAL_STRING("Europe/Berlin", out.timeZone);
+    TEST_ASSERT_EQUAL_UINT8(1, out.flip);
+    rec.payload[0] = 8;
+    TEST_ASSERT_FALSE(configRecordValid(&rec, length));       // Corrupted
+}
+
+// A record from a firmware that packed fewer fields unpacks with a zero tail.
+void test_config_record_older_version() {
+    static ConfigRecord rec;
+    TestSettings s = {3, "UTC0", 1};
+    packTest(&rec, s, 1);
+    TEST_ASSERT_TRUE(configRecordValid(&rec, configRecordLength(&rec)));
+    TestSettings out;
+    TEST_ASSERT_TRUE(unpackTest(&rec, &out));
+    TEST_ASSERT_EQUAL_INT32(3, out.brightness);
+    TEST_ASSERT_EQUAL_STRING("", out.timeZone);
+    TEST_ASSERT_EQUAL_UINT8(0, out.flip);
+}
+
+// A payload ending inside a field, or a string longer than its field, is a
+// layout this firmware can't read even with a valid CRC.
+void test_config_record_other_layout() {
+    static ConfigRecord rec;
+    TestSettings s = {3, "UTC0", 1};
+    packTest(&rec, s, 2);
+    rec.size -= 2;
+    rec.crc = configRecordCrc(&rec);
+    TestSettings out;
+    TEST_ASSERT_FALSE(unpackTest(&rec, &out));
+    TEST_ASSERT_EQUAL_STRING("", out.timeZone);
+    char longZone[100];
+    memset(longZone, 'x', sizeof(longZone) - 1);
+    longZone[sizeof(longZone) - 1] = '\0';
+    ConfigPacker pk = configPacker(&rec);
+    configPackBytes(&pk, &s.brightness, sizeof(s.brightness));
+    configPackString(&pk, longZone, sizeof(longZone));
+    configRecordSeal(&rec, configPacked(&pk));
+    TEST_ASSERT_FALSE(unpackTest(&rec, &out));
+}
+
+void test_journal_record() {
+    JournalRecord rec;
+    journalRecordInit(&rec, 7, JOURNAL_COUNTUPDOWN, 0, -1234567890123LL);
+    TEST_ASSERT_EQUAL(20, sizeof(rec));
+    TEST_ASSERT_TRUE(journalRecordValid(&rec));
+    TEST_ASSERT_EQUAL_INT64(-1234567890123LL, journalRecordValue(&rec));
+    rec.valueHi ^= 1;
+    TEST_ASSERT_FALSE(journalRecordValid(&rec));
+}
+
+// littlefs copies the partly written last block on every reopened append.
+void test_flash_wear_append_copies_tail() {
+    FlashWear w = {};
+    flashWearWrite(&w, 0, 0, 300);
+    TEST_ASSERT_EQUAL_UINT64(FLASH_PROG_SIZE * 3, w.physicalBytes);  // Data and commit
+    TEST_ASSERT_EQUAL_UINT32(1, w.erases);
+    flashWearWrite(&w, 0, 4000, 20);
+    TEST_ASSERT_EQUAL_UINT64(FLASH_PROG_SIZE * 3 + 4096 + FLASH_PROG_SIZE, w.physicalBytes);
+    TEST_ASSERT_EQUAL_UINT32(2, w.erases);  // A fresh block for the copy and the 20 bytes
+    flashWearWrite(&w, 0, 4090, 20);
+    TEST_ASSERT_EQUAL_UINT32(4, w.erases);  // Now they need two
+    TEST_ASSERT_EQUAL_UINT64(340, w.logicalBytes);
+    TEST_ASSERT_EQUAL_UINT32(3, w.sessions);
+    TEST_ASSERT_EQUAL_UINT8(1, flashWearFiles(&w));  // All to the same file
+    flashWearWrite(&w, 5, 0, 20);
+    TEST_ASSERT_EQUAL_UINT8(2, flashWearFiles(&w));
+}
+
+// A small file written whole lives in its metadata, no data block of its own.
+void test_flash_wear_small_file_inline() {
+    FlashWear w = {};
+    flashWearWrite(&w, 0, 0, FLASH_INLINE_SIZE);
+    TEST_ASSERT_EQUAL_UINT64(FLASH_PROG_SIZE * 2, w.physicalBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, w.erases);
+    flashWearWrite(&w, 0, 0, FLASH_INLINE_SIZE + 1);
+    TEST_ASSERT_EQUAL_UINT32(1, w.erases);
+}
+
+void test_flash_wear_lifetime() {
+    FlashWear w = {};
+    TEST_ASSERT_EQUAL(0, flashWearLifetimeDays(&w, 86400, 1 << 20));
+    w.erases = 256;
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 100000.0, flashWearLifetimeDays(&w, 86400, 1 << 20));
+}
+
+void bench_crc32() {
+    static uint8_t record[180];  // About the typical settings below, packed
+    benchRun("crc32Compute, config record", [&](uint64_t i) {
+        record[0] = (uint8_t)i;
+        benchSink += crc32Compute(record, sizeof(record));
+    });
+}
+
+// A typical config.json, as saveConfigJson() writes it.
+static const char configJson[] = R"({
+  "mdns": "clock",
+  "apSsid": "Clock-Setup",
+  "apPassword": "clocksetup",
+  "ssids": ["home", "office", "", "", "", "", "", "", "", ""],
+  "passwords": ["correct horse", "battery staple", "", "", "", "", "", "", "", ""],
+  "timeZone": "Europe/Berlin",
+  "ntpServer1": "pool.ntp.org",
+  "ntpServer2": "time.nist.gov",
+  "brightness": 7,
+  "flipDisplay": false,
+  "twelveHour": false,
+  "lockCountUpDown": false,
+  "clockRatePpb": 0
+})";
+
+// The typical settings above, packed as saveConfigBinary() does.
+static int32_t brightness = 7, clockRatePpb;
+static uint8_t flags[3];
+static char mdns[64] = "clock", apSsid[32] = "Clock-Setup", apPassword[64] = "clocksetup", timeZone[64] = "Europe/Berlin";
+static char ntpServer1[128] = "pool.ntp.org", ntpServer2[128] = "time.nist.gov";
+static char ssids[10][32] = {"home", "office"}, passwords[10][64] = {"correct horse", "battery staple"};
+
+static void packSettings(ConfigRecord *rec) {
+    ConfigPacker pk = configPacker(rec);
+    configPackBytes(&pk, &brightness, sizeof(brightness));
+    configPackBytes(&pk, &clockRatePpb, sizeof(clockRatePpb));
+    configPackBytes(&pk, flags, sizeof(flags));
+    configPackString(&pk, mdns, sizeof(mdns));
+    configPackString(&pk, apSsid, sizeof(apSsid));
+    configPackString(&pk, apPassword, sizeof(apPassword));
+    configPackString(&pk, timeZone, sizeof(timeZone));
+    configPackString(&pk, ntpServer1, sizeof(ntpServer1));
+    configPackString(&pk, ntpServer2, sizeof(ntpServer2));
+    for (int i = 0; i < 10; i++) {
+        configPackString(&pk, ssids[i], sizeof(ssids[i]));
+        configPackString(&pk, passwords[i], sizeof(passwords[i]));
+    }
+    configRecordSeal(rec, configPacked(&pk));
+}
+
+static bool unpackSettings(const ConfigRecord *rec) {
+    ConfigUnpacker u = configUnpacker(rec);
+    configUnpackBytes(&u, &brightness, sizeof(brightness));
+    configUnpackBytes(&u, &clockRatePpb, sizeof(clockRatePpb));
+    configUnpackBytes(&u, flags, sizeof(flags));
+    configUnpackString(&u, mdns, sizeof(mdns));
+    configUnpackString(&u, apSsid, sizeof(apSsid));
+    configUnpackString(&u, apPassword, sizeof(apPassword));
+    configUnpackString(&u, timeZone, sizeof(timeZone));
+    configUnpackString(&u, ntpServer1, sizeof(ntpServer1));
+    configUnpackString(&u, ntpServer2, sizeof(ntpServer2));
+    for (int i = 0; i < 10; i++) {
+        configUnpackString(&u, ssids[i], sizeof(ssids[i]));
+        configUnpackString(&u, passwords[i], sizeof(passwords[i]));
+    }
+    return !u.torn;
+}
+
+// The CPU side of a boot's load and a save: parsing or printing config.json
+// against checking and unpacking or packing and sealing the binary record.
+// Flash time comes on top, less of it for the smaller record.
+void bench_config_codec() {
+    JsonDocument doc;
+    double json = benchRun("config decode, parse config.json", [&](uint64_t) {
+        benchSink += deserializeJson(doc, configJson) == DeserializationError::Ok;
+    });
+    static ConfigRecord rec;
+    packSettings(&rec);
+    size_t length = configRecordLength(&rec);
+    printf("BENCH config sizes: %u B config.json, %u B binary record\n", (unsigned)strlen(configJson), (unsigned)length);
+    TEST_ASSERT_LESS_OR_EQUAL(FLASH_INLINE_SIZE, length);
+    double binary = benchRun("config decode, unpack binary record", [&](uint64_t) {
+        benchSink += configRecordValid(&rec, length) && unpackSettings(&rec);
+    });
+    benchSpeedup("config decode", json, binary);
+    TEST_ASSERT_EQUAL_STRING("correct horse", passwords[0]);
+
+    static char out[2048];
+    json = benchRun("config encode, print config.json", [&](uint64_t) {
+        benchSink += serializeJsonPretty(doc, out, sizeof(out));
+    });
+    binary = benchRun("config encode, pack binary record", [&](uint64_t i) {
+        brightness = (int32_t)(i & 15);
+        packSettings(&rec);
+        benchSink += rec.crc;
+    });
+    benchSpeedup("config encode", json, binary);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_config_record_round_trip);
+    RUN_TEST(test_config_record_older_version);
+    RUN_TEST(test_config_record_other_layout);
+    RUN_TEST(test_journal_record);
+    RUN_TEST(test_flash_wear_append_copies_tail);
+    RUN_TEST(test_flash_wear_small_file_inline);
+    RUN_TEST(test_flash_wear_lifetime);
+    RUN_TEST(bench_crc32);
+    RUN_TEST(bench_config_codec);
+    return UNITY_END();
+}
@@ -0,0 +1,253 @@
+#include <unity.h>
+#include <unistd.h>
+#include "ntp_server.h"
+#include "sim.h"
+#include "time_format.h"
+
+// Months of the clock's life in seconds: the firmware fast-forwarded on
+// the simulated board across the display's formatting thresholds, a DST
+// change, restarts, power cuts and a day of NTP refreshes.
+
+extern time_t countupdownTimestamp;
+
+void setUp() {
+    simBoardReset();
+}
+void tearDown() {}
+
+// 15 days and 5 s to go: D+HH:MM gives way to H:MM:SS.
+static void countdownScenario(uint32_t) {
+    simRunFor(1000000);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/start").code);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/add_seconds", {{"seconds", "1296005"}}).code);
+    simFrames().clear();
+    simRunFor(10000000);
+    int days = simFindFrame("15+00:00");
+    TEST_ASSERT_GREATER_OR_EQUAL(0, days);
+    TEST_ASSERT_GREATER_THAN(days, simFindFrame("359:59:59", days));
+    TEST_ASSERT_GREATER_THAN(days, simFindFrame("359:59:55", days));
+}
+
+void test_countdown_crosses_fifteen_days() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(countdownScenario));
+}
+
+// Counting up for a year less 9 s: D+HH:MM gives way to Y+D.
+static void countUpScenario(uint32_t) {
+    simRunFor(1000000);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/start").code);
+    simRunFor(1000000);
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/add_seconds", {{"seconds", "31557590"}}).code);
+    simFrames().clear();
+    simRunFor(12000000);
+    int days = simFindFrame("365+05:59");
+    TEST_ASSERT_GREATER_OR_EQUAL(0, days);
+    TEST_ASSERT_GREATER_THAN(days, simFindFrame("1+0", days));
+}
+
+void test_count_up_crosses_a_year() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(countUpScenario));
+}
+
+// Central European Summer Time ends at 01:00 UTC, 03:00 local goes back to 02:00.
+static void dstScenario(uint32_t) {
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/save", {{"timeZone", "Europe/Berlin"}}).code);
+    simFrames().clear();
+    simRunFor(15000000);
+    int before = simFindFrame("02:59:59");
+    TEST_ASSERT_GREATER_OR_EQUAL(0, before);
+    TEST_ASSERT_EQUAL(before + 1, simFindFrame("02:00:00", before));
+    TEST_ASSERT_EQUAL(-1, simFindFrame("03:00:00"));
+}
+
+void test_dst_ends() {
+    simBoard()->trueUs = 1761440400LL * 1000000 - 8000000;  // 2025-10-26 00:59:52 UTC
+    simRtcSet(simBoard()->trueUs);
+    TEST_ASSERT_EQUAL(0, simPowerOn(dstScenario));
+}
+
+// The countdown survives a restart and three weeks without power.
+static void poweredScenario(uint32_t boot) {
+    if (boot == 1) {
+        TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_GET, "/start").code);
+        TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/add_seconds", {{"seconds", "2592000"}}).code);
+        simRunFor(3000000);
+        server.simRequest(HTTP_GET, "/restart");
+        simRunFor(1000000);
+        TEST_FAIL_MESSAGE("No restart");
+    }
+    simRunFor(2000000);
+    TEST_ASSERT_NOT_EQUAL(0, countupdownTimestamp);
+    char expected[24];
+    TimeCounters tc = {};
+    formatCountUpDown(&tc, countupdownTimestamp - simBoard()->trueUs / 1000000, true, expected);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, simFindFrame(expected));
+}
+
+void test_countdown_survives_restart_and_power_cut() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(poweredScenario));
+    TEST_ASSERT_EQUAL_UINT32(2, simBoard()->boots);
+    TEST_ASSERT_EQUAL_UINT32(1, simBoard()->restarts);
+    simPowerOff(21LL * 86400 * 1000000);
+    TEST_ASSERT_EQUAL(0, simPowerOn(poweredScenario));
+}
+
+// A day on WiFi: NTP every hour, the RTC checked every minute, the uptime
+// journal every hour. The per day costs go into the SIM line.
+static void dayScenario(uint32_t) {
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/save", {{"ssid0", "simnet"}, {"password0", "secret"}}).code);
+    simRunFor(60000000);
+    uint32_t queries = simBoard()->ntpQueries;
+    TEST_ASSERT_GREATER_THAN(0, queries);
+    SimSnapshot start = simSnapshot();
+    simRunFor(86400LL * 1000000);
+    SimReport r = simReport("day on WiFi", start);
+    TEST_ASSERT_GREATER_OR_EQUAL(24, (int)(simBoard()->ntpQueries - queries));
+    TEST_ASSERT_INT_WITHIN(10, 86400, r.frames);  // One a second
+    TEST_ASSERT_LESS_THAN(5, r.i2cPerSecond);
+    TEST_ASSERT_LESS_THAN(1000000, r.flashBytesPerDay);
+    TEST_ASSERT_LESS_THAN(100000, r.programmedBytesPerDay);  // 680960 when the uptime went out every 5 minutes
+    // config.json, the settings record, the journal and its compaction
+    // file, written to many more times than that.
+    SimHttpResponse wear = server.simRequest(HTTP_GET, "/wear");
+    TEST_ASSERT_EQUAL(200, wear.code);
+    TEST_ASSERT_TRUE(wear.body.find("\"files\":4,") != std::string::npos);
+    TEST_ASSERT_TRUE(wear.body.find("\"lifetimeYears\":null") == std::string::npos);
+}
+
+// Without SQW or WiFi the seconds follow the RTC's, not the ESP crystal's.
+static void rtcPhaseScenario(uint32_t) {
+    simRunFor(3600000000LL);
+    simFrames().clear();
+    simRunFor(120000000);
+    TEST_ASSERT_GREATER_THAN(100, simFrames().size());
+    int64_t worstUs = 0;
+    for (const SimFrame &f : simFrames()) {
+        int64_t errUs = (f.trueUs + 500000) % 1000000 - 500000;
+        worstUs = std::max(worstUs, errUs < 0 ? -errUs : errUs);
+    }
+    printf("SIM rtc phase without SQW: worst frame %lld us off the second\n", (long long)worstUs);
+    TEST_ASSERT_LESS_THAN(5000, worstUs);
+}
+
+void test_rtc_phase_without_sqw() {
+    simBoard()->espPpb = 50000;  // 50 ppm fast, 180 ms an hour
+    TEST_ASSERT_EQUAL(0, simPowerOn(rtcPhaseScenario));
+}
+
+// Two real NTP servers, 250 ms ahead of true time: each sync alternates
+// between them no closer than 4 s apart, and their names are looked up
+// once, not on every sync.
+static void ntpServersScenario(uint32_t) {
+    SimNtpServer pool, nist;
+    pool.offsetUs = nist.offsetUs = 250000;
+    TEST_ASSERT_TRUE(simNtpServe(0, "pool.ntp.org", pool));
+    TEST_ASSERT_TRUE(simNtpServe(1, "time.nist.gov", nist));
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/save", {{"ssid0", "simnet"}, {"password0", "secret"}}).code);
+    simRunFor(13LL * 3600 * 1000000);
+    SimHttpResponse r = server.simRequest(HTTP_GET, "/ntp_status");
+    TEST_ASSERT_NOT_NULL(strstr(r.body.c_str(), "\"state\":\"success\""));
+    long long offsetUs = 0;
+    sscanf(strstr(r.body.c_str(), "\"offsetUs\":"), "\"offsetUs\":%lld", &offsetUs);
+    TEST_ASSERT_INT_WITHIN(5000, 0, offsetUs);  // Corrected by the first sync
+    std::vector<int64_t> errUs;  // Frames go out 250 ms before true seconds now
+    for (size_t i = simFrames().size() - 60; i < simFrames().size(); i++) {
+        errUs.push_back((simFrames()[i].trueUs + 250000 + 500000) % 1000000 - 500000);
+    }
+    std::sort(errUs.begin(), errUs.end());
+    printf("SIM two NTP servers: %u + %u queries, %.1f s + %.1f s apart at least, %u DNS lookups, frames %lld us off\n",
+           pool.queries.load(), nist.queries.load(), pool.minIntervalUs / 1e6, nist.minIntervalUs / 1e6,
+           simBoard()->dnsLookups, (long long)errUs[errUs.size() / 2]);
+    TEST_ASSERT_EQUAL_UINT32(12, pool.queries.load());  // Bursts of 4 at boot, 6 h and 12 h
+    TEST_ASSERT_EQUAL_UINT32(12, nist.queries.load());
+    TEST_ASSERT_EQUAL_UINT32(0, pool.kisses.load() + nist.kisses.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(4000000, pool.minIntervalUs.load());
+    TEST_ASSERT_GREATER_OR_EQUAL(4000000, nist.minIntervalUs.load());
+    TEST_ASSERT_EQUAL_UINT32(2, simBoard()->dnsLookups);
+    TEST_ASSERT_INT_WITHIN(5000, 0, errUs[errUs.size() / 2]);
+}
+
+void test_ntp_servers() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(ntpServersScenario));
+}
+
+// A server answering DENY gets one query, the other one does the sync.
+static void ntpKissScenario(uint32_t) {
+    SimNtpServer pool, nist;
+    pool.kiss = "DENY";
+    TEST_ASSERT_TRUE(simNtpServe(0, "pool.ntp.org", pool));
+    TEST_ASSERT_TRUE(simNtpServe(1, "time.nist.gov", nist));
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/save", {{"ssid0", "simnet"}, {"password0", "secret"}}).code);
+    simRunFor(60000000);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.queries.load());
+    TEST_ASSERT_EQUAL_UINT32(4, nist.queries.load());
+    SimHttpResponse r = server.simRequest(HTTP_GET, "/ntp_status");
+    TEST_ASSERT_NOT_NULL(strstr(r.body.c_str(), "\"state\":\"success\""));
+    TEST_ASSERT_NOT_NULL(strstr(r.body.c_str(), "\"server\":\"time.nist.gov\""));
+    TEST_ASSERT_NOT_NULL(strstr(r.body.c_str(), "\"kisses\":1"));
+}
+
+void test_ntp_kiss_of_death() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(ntpKissScenario));
+}
+
+// A DS3231 5 ppm fast without SQW: the first NTP syncs measure it through
+// the timeline locked to it, and its aging offset trims it.
+static void agingScenario(uint32_t) {
+    TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/save", {{"ssid0", "simnet"}, {"password0", "secret"}}).code);
+    simRunFor(8LL * 3600 * 1000000);
+    printf("SIM aging without SQW: offset %d, RTC now %lld ppb off\n", simBoard()->rtcAging, (long long)simRtcRatePpb());
+    TEST_ASSERT_NOT_EQUAL(0, simBoard()->rtcAging);
+    TEST_ASSERT_INT_WITHIN(500, 0, simRtcRatePpb());
+}
+
+void test_rtc_aging_without_sqw() {
+    simBoard()->rtcPpb = 5000;
+    TEST_ASSERT_EQUAL(0, simPowerOn(agingScenario));
+}
+
+void test_day_of_operation() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(dayScenario));
+}
+
+// /restore goes back one save from the last change, counting one still
+// waiting for its write, and nothing is saved over the restored settings
+// before the restart, not even a change that came in meanwhile.
+static void restoreScenario(uint32_t boot) {
+    if (boot == 1) {
+        for (const char *value : {"3", "5"}) {
+            TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/set_brightness", {{"value", value}}).code);
+            simRunFor(3000000);
+        }
+        TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/set_brightness", {{"value", "9"}}).code);
+        TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/restore").code);
+        TEST_ASSERT_EQUAL(200, server.simRequest(HTTP_POST, "/set_brightness", {{"value", "12"}}).code);
+        simRunFor(1000000);
+        TEST_FAIL_MESSAGE("No restart");
+    }
+    simRunFor(1000000);
+    TEST_ASSERT_EQUAL_UINT8(5, simBoard()->intensity);
+}
+
+void test_restore_previous_save() {
+    TEST_ASSERT_EQUAL(0, simPowerOn(restoreScenario));
+    TEST_ASSERT_EQUAL_UINT32(1, simBoard()->restarts);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_countdown_crosses_fifteen_days);
+    RUN_TEST(test_count_up_crosses_a_year);
+    RUN_TEST(test_dst_ends);
+    RUN_TEST(test_countdown_survives_restart_and_power_cut);
+    RUN_TEST(test_rtc_phase_without_sqw);
+    RUN_TEST(test_ntp_servers);
+    RUN_TEST(test_ntp_kiss_of_death);
+    RUN_TEST(test_rtc_aging_without_sqw);
+    RUN_TEST(test_day_of_operation);
+    RUN_TEST(test_restore_previous_save);
+    int failures = UNITY_END();
+    simFsErase();
+    rmdir(simFsPath("").c_str());
+    return failures;
+}
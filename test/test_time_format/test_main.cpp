@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <time.h>
+#include <unity.h>
+#include "bench.h"
+#include "clock_display.h"
+#include "time_format.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const char *countText(int64_t seconds, bool colon = true) {
+    static TimeCounters tc;
+    static char out[24];
+    tc.valid = false;
+    formatCountUpDown(&tc, seconds, colon, out);
+    return out;
+}
+
+static const char *clockText(int64_t localSeconds, bool twelveHour) {
+    static TimeCounters tc;
+    static char out[24];
+    tc.valid = false;
+    formatClock(&tc, localSeconds, twelveHour, out);
+    return out;
+}
+
+void test_count_up_down_ranges() {
+    TEST_ASSERT_EQUAL_STRING("0:00:00", countText(0));
+    TEST_ASSERT_EQUAL_STRING("0:00:59", countText(59));
+    TEST_ASSERT_EQUAL_STRING("1:01:01", countText(3661));
+    TEST_ASSERT_EQUAL_STRING("359:59:59", countText(FIFTEEN_DAYS - 1));
+    TEST_ASSERT_EQUAL_STRING("15+00:00", countText(FIFTEEN_DAYS));
+    TEST_ASSERT_EQUAL_STRING("365+05:59", countText(SECONDS_PER_YEAR - 1));
+    TEST_ASSERT_EQUAL_STRING("1+3", countText(SECONDS_PER_YEAR + 3 * SECONDS_PER_DAY));
+    TEST_ASSERT_EQUAL_STRING("12+0", countText(12LL * SECONDS_PER_YEAR));
+}
+
+void test_count_up_down_hidden_colon() {
+    TEST_ASSERT_EQUAL_STRING("1 01 01", countText(3661, false));
+    TEST_ASSERT_EQUAL_STRING("15^00 00", countText(FIFTEEN_DAYS, false));
+    TEST_ASSERT_EQUAL_STRING("1^3", countText(SECONDS_PER_YEAR + 3 * SECONDS_PER_DAY, false));
+}
+
+void test_clock_12_and_24_hour() {
+    TEST_ASSERT_EQUAL_STRING("00:00:00", clockText(0, false));
+    TEST_ASSERT_EQUAL_STRING("12:00:00", clockText(0, true));
+    TEST_ASSERT_EQUAL_STRING("12:30:05", clockText(12 * 3600 + 30 * 60 + 5, true));
+    TEST_ASSERT_EQUAL_STRING("1:00:00", clockText(13 * 3600, true));
+    TEST_ASSERT_EQUAL_STRING("23:59:59", clockText(SECONDS_PER_DAY - 1, false));
+    TEST_ASSERT_EQUAL_STRING("00:00:01", clockText(20000LL * SECONDS_PER_DAY + 1, false));
+}
+
+// Stepping by one second carries exactly like dividing afresh.
+void test_counters_step_like_set() {
+    TimeCounters stepped = {};
+    TimeCounters fresh = {};
+    int64_t start = SECONDS_PER_YEAR - 2 * SECONDS_PER_DAY - 5;
+    timeCountersSet(&stepped, start);
+    for (int64_t t = start + 1; t < start + 3 * SECONDS_PER_DAY; t++) {
+        timeCountersUpdate(&stepped, t);
+        timeCountersSet(&fresh, t);
+        TEST_ASSERT_EQUAL(fresh.sec, stepped.sec);
+        TEST_ASSERT_EQUAL(fresh.min, stepped.min);
+        TEST_ASSERT_EQUAL(fresh.hour, stepped.hour);
+        TEST_ASSERT_EQUAL(fresh.days, stepped.days);
+        TEST_ASSERT_EQUAL(fresh.yearSec, stepped.yearSec);
+        TEST_ASSERT_EQUAL(fresh.years, stepped.years);
+    }
+    for (int64_t t = start + 3 * SECONDS_PER_DAY - 2; t > start - SECONDS_PER_DAY; t--) {
+        timeCountersUpdate(&stepped, t);
+        timeCountersSet(&fresh, t);
+        TEST_ASSERT_EQUAL(fresh.sec, stepped.sec);
+        TEST_ASSERT_EQUAL(fresh.hour, stepped.hour);
+        TEST_ASSERT_EQUAL(fresh.days, stepped.days);
+        TEST_ASSERT_EQUAL(fresh.yearSec, stepped.yearSec);
+        TEST_ASSERT_EQUAL(fresh.years, stepped.years);
+    }
+}
+
+void test_put_digits() {
+    char out[12];
+    const uint32_t values[] = {0, 7, 10, 99, 100, 12345, 4294967295u};
+    for (uint32_t v : values) {
+        char expected[12];
+        snprintf(expected, sizeof(expected), "%u", v);
+        *putDigits(out, v) = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected, out);
+    }
+}
+
+// The display code path before time_format.h: the snprintf chain of the
+// baseline loop(), kept here to check against and to measure.
+static void oldCountUpDown(long timeSeconds, bool colonVisible, char *timeWithSeconds, size_t size) {
+    if (timeSeconds < 0) {
+        timeSeconds = timeSeconds * -1;
+    }
+    if (timeSeconds < 1296000) {
+        if (colonVisible) {
+            snprintf(timeWithSeconds, size, "%ld:%02ld:%02ld", timeSeconds / 3600, (timeSeconds % 3600) / 60, timeSeconds % 60);
+        } else {
+            snprintf(timeWithSeconds, size, "%ld %02ld %02ld", timeSeconds / 3600, (timeSeconds % 3600) / 60, timeSeconds % 60);
+        }
+    } else if (timeSeconds < 31557600) {
+        if (colonVisible) {
+            snprintf(timeWithSeconds, size, "%ld+%02ld:%02ld", timeSeconds / 86400, (timeSeconds % 86400) / 3600, (timeSeconds % 3600) / 60);
+        } else {
+            snprintf(timeWithSeconds, size, "%ld^%02ld %02ld", timeSeconds / 86400, (timeSeconds % 86400) / 3600, (timeSeconds % 3600) / 60);
+        }
+    } else {
+        if (colonVisible) {
+            snprintf(timeWithSeconds, size, "%ld+%ld", timeSeconds / 31557600, (timeSeconds % 31557600) / 86400);
+        } else {
+            snprintf(timeWithSeconds, size, "%ld^%ld", timeSeconds / 31557600, (timeSeconds % 31557600) / 86400);
+        }
+    }
+}
+
+static void oldClock(time_t utcStamp, bool twelveHour, char *timeWithSeconds, size_t size) {
+    struct tm tm;
+    localtime_r(&utcStamp, &tm);
+    if (twelveHour) {
+        uint8_t hour = tm.tm_hour % 12;
+        snprintf(timeWithSeconds, size, "%d:%02d:%02d", hour == 0 ? 12 : hour, tm.tm_min, tm.tm_sec);
+    } else {
+        snprintf(timeWithSeconds, size, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+    }
+}
+
+static const char *berlin = "CET-1CEST,M3.5.0,M10.5.0/3";
+
+// Same text as the old path, second by second across every range boundary
+// and around the DST changes, as the display steps through them.
+void test_same_as_snprintf_chain() {
+    char expected[24], out[24];
+    DisplayCounters counters = {};
+    const int64_t starts[] = {0, 3600 - 30, FIFTEEN_DAYS - 30, SECONDS_PER_YEAR - 30, 10LL * SECONDS_PER_YEAR - 30};
+    for (int64_t start : starts) {
+        for (int64_t s = start; s < start + 60; s++) {
+            for (int colon = 0; colon < 2; colon++) {
+                oldCountUpDown((long)s, colon, expected, sizeof(expected));
+                formatCountUpDown(&counters.countUpDown, s, colon, out);
+                TEST_ASSERT_EQUAL_STRING(expected, out);
+            }
+        }
+    }
+    setenv("TZ", berlin, 1);
+    tzset();
+    TzRules zone;
+    tzParse(&zone, berlin);
+    const int64_t clocks[] = {1743296400 - 30, 1761440400 - 30, 1750000000};  // 2025 DST changes
+    for (int64_t start : clocks) {
+        for (int64_t t = start; t < start + 60; t++) {
+            for (int twelve = 0; twelve < 2; twelve++) {
+                oldClock((time_t)t, twelve, expected, sizeof(expected));
+                formatDisplay(&counters, &zone, t, 0, twelve, true, out);
+                TEST_ASSERT_EQUAL_STRING(expected, out);
+            }
+        }
+    }
+}
+
+// ns per displayed second, the tick's formatting against the old path.
+void bench_format_vs_snprintf() {
+    char out[24];
+    DisplayCounters counters = {};
+    double oldNs = benchRun("countdown, snprintf chain", [&](uint64_t i) {
+        oldCountUpDown(1000000 - (long)(i % 1000000), i & 1, out, sizeof(out));
+        benchSink += out[0];
+    });
+    double newNs = benchRun("countdown, formatCountUpDown", [&](uint64_t i) {
+        benchSink += formatCountUpDown(&counters.countUpDown, 1000000 - (int64_t)(i % 1000000), i & 1, out);
+    });
+    benchSpeedup("countdown formatter", oldNs, newNs);
+
+    setenv("TZ", berlin, 1);
+    tzset();
+    TzRules zone;
+    tzParse(&zone, berlin);
+    oldNs = benchRun("clock, localtime_r and snprintf", [&](uint64_t i) {
+        oldClock((time_t)(1750000000 + i), false, out, sizeof(out));
+        benchSink += out[0];
+    });
+    newNs = benchRun("clock, formatDisplay", [&](uint64_t i) {
+        benchSink += formatDisplay(&counters, &zone, 1750000000 + (int64_t)i, 0, false, true, out);
+    });
+    benchSpeedup("clock formatter", oldNs, newNs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_count_up_down_ranges);
+    RUN_TEST(test_count_up_down_hidden_colon);
+    RUN_TEST(test_clock_12_and_24_hour);
+    RUN_TEST(test_counters_step_like_set);
+    RUN_TEST(test_put_digits);
+    RUN_TEST(test_same_as_snprintf_chain);
+    RUN_TEST(bench_format_vs_snprintf);
+    return UNITY_END();
+}
@@ -0,0 +1,80 @@
+#include <unity.h>
+#include "bench.h"
+#include "time_source.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_first_reference_steps() {
+    TimeSource ts;
+    timeSourceInit(&ts);
+    TEST_ASSERT_EQUAL_INT64(1000000, timeSourceNow(&ts, 1000000));
+    timeSourceSync(&ts, 2000000, 1750000000000000LL, TIME_SOURCE_RTC, TIME_STRATUM_RTC);
+    TEST_ASSERT_EQUAL_UINT32(1, ts.steps);
+    TEST_ASSERT_EQUAL_INT64(1750000000500000LL, timeSourceNow(&ts, 2500000));
+    TEST_ASSERT_EQUAL_STRING("rtc", timeSourceName(ts.source));
+}
+
+// A small correction is run in at TIME_SLEW_PPM, without going backwards.
+void test_small_offset_slews() {
+    TimeSource ts;
+    timeSourceInit(&ts);
+    timeSourceSync(&ts, 0, 1750000000000000LL, TIME_SOURCE_RTC, TIME_STRATUM_RTC);
+    int64_t offset = timeSourceSync(&ts, 10000000, 1750000010000000LL - 100000, TIME_SOURCE_NTP, 2);
+    TEST_ASSERT_EQUAL_INT64(-100000, offset);
+    TEST_ASSERT_EQUAL_UINT32(1, ts.slews);
+    int64_t last = 0;
+    for (int64_t mono = 10000000; mono < 13000000; mono += 1000) {
+        int64_t now = timeSourceNow(&ts, mono);
+        TEST_ASSERT_GREATER_OR_EQUAL(last, now);
+        last = now;
+    }
+    // 100 ms at 5% takes 2 s, after that the reference rate again.
+    TEST_ASSERT_EQUAL_INT64(0, timeSourceSlewRemaining(&ts, 12000000));
+    TEST_ASSERT_EQUAL_INT64(1750000014000000LL - 100000, timeSourceNow(&ts, 14000000));
+}
+
+void test_large_offset_steps_back() {
+    TimeSource ts;
+    timeSourceInit(&ts);
+    timeSourceSync(&ts, 0, 1750000000000000LL, TIME_SOURCE_RTC, TIME_STRATUM_RTC);
+    TEST_ASSERT_EQUAL_INT64(1750000005000000LL, timeSourceNow(&ts, 5000000));
+    timeSourceSync(&ts, 5000000, 1750000000000000LL, TIME_SOURCE_MANUAL, TIME_STRATUM_MANUAL);
+    TEST_ASSERT_EQUAL_UINT32(2, ts.steps);
+    TEST_ASSERT_EQUAL_INT64(1750000000000000LL, timeSourceNow(&ts, 5000000));
+    TEST_ASSERT_EQUAL_INT32(-5000000, ts.lastOffsetUs);
+}
+
+void test_rate_change_is_continuous() {
+    TimeSource ts;
+    timeSourceInit(&ts);
+    timeSourceSync(&ts, 0, 1750000000000000LL, TIME_SOURCE_NTP, 2);
+    timeSourceSync(&ts, 1000000, 1750000001000000LL + 50000, TIME_SOURCE_NTP, 2);
+    int64_t before = timeSourceAt(&ts, 1500000);
+    timeSourceSetRate(&ts, 1500000, 20000);  // 20 ppm fast crystal
+    TEST_ASSERT_EQUAL_INT64(before, timeSourceAt(&ts, 1500000));
+    TEST_ASSERT_EQUAL_INT64(25000, timeSourceSlewRemaining(&ts, 1500000));
+    // 1000 s later: rate applied and the slew done.
+    TEST_ASSERT_EQUAL_INT64(before + 1000000000 + 20000 + 25000, timeSourceAt(&ts, 1001500000));
+}
+
+void bench_time_source_now() {
+    TimeSource ts;
+    timeSourceInit(&ts);
+    timeSourceSync(&ts, 0, 1750000000000000LL, TIME_SOURCE_NTP, 2);
+    timeSourceSync(&ts, 1000000, 1750000001000000LL + 50000, TIME_SOURCE_NTP, 2);
+    timeSourceSetRate(&ts, 1000000, -3500);
+    benchRun("timeSourceNow", [&](uint64_t i) {
+        benchSink += timeSourceNow(&ts, 1000000 + (int64_t)i * 7);
+    });
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_reference_steps);
+    RUN_TEST(test_small_offset_slews);
+    RUN_TEST(test_large_offset_steps_back);
+    RUN_TEST(test_rate_change_is_continuous);
+    RUN_TEST(bench_time_source_now);
+    return UNITY_END();
+}
@@ -0,0 +1,76 @@
+#define TRACE true
+#include <string>
+#include <Arduino.h>
+#include <unity.h>
+#include "trace.h"
+
+// The Chrome trace dump: a thread per task wherever it ran, and time that
+// keeps counting across the cycle counters' wraps.
+
+static tskTaskControlBlock asyncTcp = {"async_tcp", 0};
+
+struct TracePrint : Print {
+    std::string text;
+    size_t write(uint8_t c) override {
+        text.push_back((char)c);
+        return 1;
+    }
+};
+
+void setUp() {
+    traceHead = 0;
+    simCurrentTask = &simLoopTask;
+}
+void tearDown() {
+    simCurrentTask = &simLoopTask;
+}
+
+static std::string dump() {
+    TracePrint out;
+    traceDump(out);
+    return out.text;
+}
+
+static bool has(const std::string &text, const char *part) {
+    return text.find(part) != std::string::npos;
+}
+
+// The web server task moves from core 0 to core 1, where the loop runs: it
+// stays one thread, the loop another.
+void test_threads_are_tasks() {
+    traceEvent("loop", 'B');
+    simCurrentTask = &asyncTcp;
+    traceEvent("/a", 'B');
+    traceEvent("/a", 'E');
+    asyncTcp.core = 1;
+    traceEvent("/b", 'B');
+    traceEvent("/b", 'E');
+    asyncTcp.core = 0;
+    simCurrentTask = &simLoopTask;
+    traceEvent("loop", 'E');
+    std::string text = dump();
+    TEST_ASSERT_TRUE(has(text, "{\"name\":\"/a\",\"ph\":\"B\",\"ts\":0.000,\"pid\":0,\"tid\":2}"));
+    TEST_ASSERT_TRUE(has(text, "{\"name\":\"/b\",\"ph\":\"E\",\"ts\":0.000,\"pid\":0,\"tid\":2}"));
+    TEST_ASSERT_TRUE(has(text, "{\"name\":\"loop\",\"ph\":\"E\",\"ts\":0.000,\"pid\":0,\"tid\":1}"));
+    TEST_ASSERT_TRUE(has(text, "\"tid\":1,\"args\":{\"name\":\"loopTask\"}"));
+    TEST_ASSERT_TRUE(has(text, "\"tid\":2,\"args\":{\"name\":\"async_tcp\"}"));
+}
+
+// At 240 MHz the counter wraps every 17.9 s; events 10 s apart cross it.
+void test_time_unwraps_across_counter_wraps() {
+    for (int i = 0; i < 4; i++) {
+        traceEvent("tick", 'B');
+        simBoard()->monoUs += 10000000;
+    }
+    std::string text = dump();
+    TEST_ASSERT_TRUE(has(text, "\"ts\":10000000.000"));
+    TEST_ASSERT_TRUE(has(text, "\"ts\":20000000.000"));
+    TEST_ASSERT_TRUE(has(text, "\"ts\":30000000.000"));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_threads_are_tasks);
+    RUN_TEST(test_time_unwraps_across_counter_wraps);
+    return UNITY_END();
+}
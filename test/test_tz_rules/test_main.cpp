@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <unity.h>
+#include "bench.h"
+#include "tz_lookup.h"
+#include "tz_rules.h"
+
+void setUp() {}
+void tearDown() {}
+
+// glibc's offset for the POSIX rule at utc.
+static int64_t libcOffset(const char *rule, int64_t utc) {
+    setenv("TZ", rule, 1);
+    tzset();
+    time_t t = (time_t)utc;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    return tm.tm_gmtoff;
+}
+
+void test_fixed_offset() {
+    TzRules tz;
+    TEST_ASSERT_TRUE(tzParse(&tz, "JST-9"));
+    TEST_ASSERT_FALSE(tz.hasDst);
+    TEST_ASSERT_EQUAL_INT64(1750000000 + 9 * 3600, tzLocal(&tz, 1750000000));
+    TEST_ASSERT_TRUE(tzParse(&tz, "<-03>3"));
+    TEST_ASSERT_EQUAL_INT64(1750000000 - 3 * 3600, tzLocal(&tz, 1750000000));
+}
+
+void test_rejects_garbage() {
+    TzRules tz;
+    TEST_ASSERT_FALSE(tzParse(&tz, ""));
+    TEST_ASSERT_FALSE(tzParse(&tz, "CET-1CEST,M3.5"));
+    TEST_ASSERT_FALSE(tzParse(&tz, "CET-1CEST,M13.5.0,M10.5.0/3"));
+}
+
+// Central Europe switches at 01:00 UTC on the last Sundays of March and October.
+void test_transitions_are_exact() {
+    TzRules tz;
+    TEST_ASSERT_TRUE(tzParse(&tz, "CET-1CEST,M3.5.0,M10.5.0/3"));
+    const int64_t spring = 1743296400;  // 2025-03-30 01:00:00 UTC
+    const int64_t autumn = 1761440400;  // 2025-10-26 01:00:00 UTC
+    TEST_ASSERT_EQUAL_INT64(3600, tzLocal(&tz, spring - 1) - (spring - 1));
+    TEST_ASSERT_EQUAL_INT64(7200, tzLocal(&tz, spring) - spring);
+    TEST_ASSERT_EQUAL_INT64(7200, tzLocal(&tz, autumn - 1) - (autumn - 1));
+    TEST_ASSERT_EQUAL_INT64(3600, tzLocal(&tz, autumn) - autumn);
+}
+
+// Every hour of a few years, north and south, with odd rule forms.
+void test_matches_glibc() {
+    const char *rules[] = {
+        "CET-1CEST,M3.5.0,M10.5.0/3",
+        "EST5EDT,M3.2.0,M11.1.0",
+        "AEST-10AEDT,M10.1.0,M4.1.0/3",
+        "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1",
+        "IST-2IDT,M3.4.4/26,M10.5.0",
+        "NZST-12NZDT,M9.5.0,M4.1.0/3",
+        "<+0330>-3:30",
+        "XXX3YYY,J60/2,J300/2",
+        "XXX3YYY,59/2,299/2",
+    };
+    for (const char *rule : rules) {
+        TzRules tz;
+        TEST_ASSERT_TRUE_MESSAGE(tzParse(&tz, rule), rule);
+        for (int64_t utc = 1672531200; utc < 1767225600; utc += 3600) {  // 2023 to 2025
+            TEST_ASSERT_EQUAL_INT64_MESSAGE(libcOffset(rule, utc), tzLocal(&tz, utc) - utc, rule);
+        }
+    }
+}
+
+// Name of zone ix in the generated table.
+static const char *zoneName(size_t ix) {
+    return tz_names + tz_entries[ix].name;
+}
+
+// Zones whose POSIX rule can't follow tzdata: Morocco leaves summer time
+// for Ramadan on dates tzdata lists year by year.
+static bool posixOnly(const char *name) {
+    return strcmp(name, "Africa/Casablanca") == 0 || strcmp(name, "Africa/El_Aaiun") == 0;
+}
+
+// Every zone of the table, every hour of 2026 and 2027: its POSIX rule as
+// tzRules reads it against glibc reading the same rule, and against glibc
+// with the zone's own tzdata file where the host has one.
+void test_every_zone_matches_glibc() {
+    const int64_t from = 1767225600;  // 2026-01-01
+    const int64_t to = 1830297600;    // 2028-01-01
+    size_t withFile = 0;
+    for (size_t ix = 0; ix < TZ_ZONE_COUNT; ix++) {
+        const char *name = zoneName(ix);
+        char posix[TZ_POSIX_MAX + 1];
+        strlcpy(posix, ianaToPosix(name), sizeof(posix));
+        TzRules tz;
+        TEST_ASSERT_TRUE_MESSAGE(tzParse(&tz, posix), name);
+
+        char file[128];
+        snprintf(file, sizeof(file), "/usr/share/zoneinfo/%s", name);
+        bool hasFile = access(file, R_OK) == 0 && !posixOnly(name);
+        withFile += hasFile;
+        for (int64_t utc = from; utc < to; utc += 3600) {
+            int64_t offset = tzLocal(&tz, utc) - utc;
+            TEST_ASSERT_EQUAL_INT64_MESSAGE(libcOffset(posix, utc), offset, name);
+        }
+        if (hasFile) {
+            char zone[132];
+            snprintf(zone, sizeof(zone), ":%s", name);
+            for (int64_t utc = from; utc < to; utc += 3600) {
+                int64_t offset = tzLocal(&tz, utc) - utc;
+                TEST_ASSERT_EQUAL_INT64_MESSAGE(libcOffset(zone, utc), offset, name);
+            }
+        }
+    }
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%zu of %d zones also checked against tzdata", withFile, TZ_ZONE_COUNT);
+    TEST_MESSAGE(msg);
+}
+
+// A miss and a hit, so unknown names are covered too.
+void test_zone_lookup() {
+    TEST_ASSERT_EQUAL_STRING("CET-1CEST,M3.5.0,M10.5.0/3", ianaToPosix("Europe/Berlin"));
+    TEST_ASSERT_EQUAL_STRING("UTC0", ianaToPosix("Europe/Atlantis"));
+    for (size_t ix = 1; ix < TZ_ZONE_COUNT; ix++) {
+        TEST_ASSERT_TRUE_MESSAGE(strcmp(zoneName(ix - 1), zoneName(ix)) < 0, zoneName(ix));
+    }
+}
+
+void test_cache_rebuilds_only_at_transitions() {
+    TzRules tz;
+    TEST_ASSERT_TRUE(tzParse(&tz, "CET-1CEST,M3.5.0,M10.5.0/3"));
+    for (int64_t utc = 1735689600; utc < 1767225600; utc += 60) {  // 2025, every minute
+        tzLocal(&tz, utc);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, tz.rebuilds);  // First use and the two transitions
+}
+
+void bench_tz_local() {
+    TzRules tz;
+    tzParse(&tz, "CET-1CEST,M3.5.0,M10.5.0/3");
+    benchRun("tzLocal, cached", [&](uint64_t i) {
+        benchSink += tzLocal(&tz, 1750000000 + (int64_t)i);
+    });
+    benchRun("tzLocal, rebuilt", [&](uint64_t i) {
+        tz.validUntil = INT64_MIN;
+        benchSink += tzLocal(&tz, 1750000000 + (int64_t)i);
+    });
+}
+
+// The binary search against the linear scan the table had before, over
+// every name in turn.
+void bench_zone_lookup() {
+    double linear = benchRun("zone lookup, linear scan", [&](uint64_t i) {
+        const char *name = zoneName(i % TZ_ZONE_COUNT);
+        for (size_t ix = 0; ix < TZ_ZONE_COUNT; ix++) {
+            if (strcmp_P(name, zoneName(ix)) == 0) {
+                benchSink += tz_entries[ix].posix;
+                break;
+            }
+        }
+    });
+    double binary = benchRun("zone lookup, binary search", [&](uint64_t i) {
+        benchSink += (uintptr_t)ianaToPosix(zoneName(i % TZ_ZONE_COUNT));
+    });
+    benchSpeedup("zone lookup", linear, binary);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_offset);
+    RUN_TEST(test_rejects_garbage);
+    RUN_TEST(test_transitions_are_exact);
+    RUN_TEST(test_matches_glibc);
+    RUN_TEST(test_every_zone_matches_glibc);
+    RUN_TEST(test_zone_lookup);
+    RUN_TEST(test_cache_rebuilds_only_at_transitions);
+    RUN_TEST(bench_tz_local);
+    RUN_TEST(bench_zone_lookup);
+    return UNITY_END();
+}
@@ -0,0 +1,114 @@
+"""Embed the web UI into the firmware as pre-gzipped PROGMEM blobs.
+
+Runs as a PlatformIO pre-build script (extra_scripts in platformio.ini) and
+can also be run by hand: python tools/embed_assets.py
+
+Each asset in ASSETS is minified (HTML: indentation and blank lines only),
+gzipped and written to include/web_assets.h together with a content hash
+ETag and its Cache-Control policy. The header is only rewritten when its
+content changes, so unchanged assets don't trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+# (file in data/, URL, content type, Cache-Control)
+# The page must pick up new firmware right away, so it is always revalidated
+# (a 304 when unchanged). The icon can be cached for a month.
+ASSETS = [
+    ("index.html", "/", "text/html", "no-cache"),
+    ("favicon.ico", "/favicon.ico", "image/x-icon", "max-age=2592000"),
+]
+
+
+def minify_html(text):
+    # Only whitespace at line edges is removed; inline scripts keep their
+    # line structure, so comments and automatic semicolons stay intact.
+    out = []
+    pre = False
+    for line in text.splitlines():
+        if pre:
+            out.append(line)
+        elif line.strip():
+            out.append(line.strip())
+        if re.search(r"<(pre|textarea)\b", line, re.I):
+            pre = True
+        if re.search(r"</(pre|textarea)>", line, re.I):
+            pre = False
+    return "\n".join(out) + "\n"
+
+
+def c_identifier(name):
+    return "asset_" + re.sub(r"\W", "_", name)
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 20):
+        lines.append("    " + ",".join("0x%02x" % b for b in data[i:i + 20]) + ",")
+    return "\n".join(lines)
+
+
+def generate(project_dir):
+    data_dir = os.path.join(project_dir, "data")
+    header = os.path.join(project_dir, "include", "web_assets.h")
+
+    out = []
+    out.append("#ifndef WEB_ASSETS_H")
+    out.append("#define WEB_ASSETS_H")
+    out.append("")
+    out.append("// Generated by tools/embed_assets.py from data/, do not edit.")
+    out.append("")
+    out.append('#include "host_compat.h"')
+    out.append("")
+    out.append("typedef struct {")
+    out.append("    const char    *path;")
+    out.append("    const char    *contentType;")
+    out.append("    const uint8_t *gzip;          // PROGMEM")
+    out.append("    size_t         length;")
+    out.append("    const char    *etag;")
+    out.append("    const char    *cacheControl;")
+    out.append("} WebAsset;")
+    out.append("")
+    table = []
+    total = 0
+    for name, path, content_type, cache_control in ASSETS:
+        with open(os.path.join(data_dir, name), "rb") as f:
+            raw = f.read()
+        if content_type == "text/html":
+            raw = minify_html(raw.decode("utf-8")).encode("utf-8")
+        packed = gzip.compress(raw, 9, mtime=0)
+        etag = '\\"%s\\"' % hashlib.sha256(packed).hexdigest()[:16]
+        ident = c_identifier(name)
+        out.append("// %s: %d bytes minified, %d gzipped" % (name, len(raw), len(packed)))
+        out.append("static const uint8_t %s[] PROGMEM = {" % ident)
+        out.append(c_bytes(packed))
+        out.append("};")
+        out.append("")
+        table.append('    {"%s", "%s", %s, sizeof(%s), "%s", "%s"},' % (path, content_type, ident, ident, etag, cache_control))
+        total += len(packed)
+    out.append("static const WebAsset webAssets[] = {")
+    out.extend(table)
+    out.append("};")
+    out.append("")
+    out.append("#endif // WEB_ASSETS_H")
+    content = "\n".join(out) + "\n"
+
+    try:
+        with open(header) as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+    with open(header, "w", newline="\n") as f:
+        f.write(content)
+    print("embed_assets: %d assets, %d bytes gzipped" % (len(ASSETS), total))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    generate(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    generate(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Project flash wear and lifetime for a usage profile.
+
+Replays a day of the firmware's LittleFS writes (the binary settings record
+of BINARY_CONFIG and the runtime journal, see src/main.cpp) through the same cost estimate the
+device keeps in include/flash_wear.h, and reports bytes and erases per day
+and the years until the filesystem's blocks reach their rated endurance.
+The sizes and limits it needs are read from those sources:
+
+    python tools/flash_wear.py --hours 24 --saves 20 --countdowns 50
+
+Compare the result with what a device reports at GET /wear.
+"""
+
+import argparse
+import os
+import re
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+
+def read_constants():
+    """The sizes and limits the model needs, from the firmware sources."""
+    sources = {name: open(os.path.join(ROOT, name)).read()
+               for name in ("include/flash_wear.h", "include/runtime_journal.h", "src/main.cpp")}
+    patterns = {
+        "FLASH_BLOCK_SIZE": r"#define\s+FLASH_BLOCK_SIZE\s+(\d+)",
+        "FLASH_PROG_SIZE": r"#define\s+FLASH_PROG_SIZE\s+(\d+)",
+        "FLASH_INLINE_SIZE": r"#define\s+FLASH_INLINE_SIZE\s+(\d+)",
+        "FLASH_ENDURANCE": r"#define\s+FLASH_ENDURANCE\s+(\d+)",
+        "JOURNAL_RECORD_SIZE": r"#define\s+JOURNAL_RECORD_SIZE\s+(\d+)",
+        "JOURNAL_COMPACT_SIZE": r"journalCompactSize\s*=\s*(\d+)",
+        "WEAR_ENTRIES": r"flashWearEntryCount\s*=\s*(\d+)",
+        "LOG_SLOTS": r"logRuntimeMs\[(\d+)\]\s*=",
+    }
+    constants = {}
+    for name, pattern in patterns.items():
+        found = [m.group(1) for text in sources.values() for m in [re.search(pattern, text)] if m]
+        if not found:
+            raise SystemExit("flash_wear.py: %s not found in the firmware sources" % name)
+        constants[name] = int(found[0])
+    return constants
+
+
+globals().update(read_constants())
+
+
+def round_up(n, unit):
+    return (n + unit - 1) // unit * unit
+
+
+class FlashWear:
+    def __init__(self):
+        self.logical = 0
+        self.physical = 0
+        self.erases = 0
+        self.sessions = 0
+        self.commits = 0
+        self.files = set()
+
+    def commit(self):
+        self.commits += 1
+        self.physical += FLASH_PROG_SIZE
+        if self.commits % (FLASH_BLOCK_SIZE // FLASH_PROG_SIZE // 2) == 0:
+            self.erases += 1
+
+    def write(self, file, offset, size):
+        self.logical += size
+        self.sessions += 1
+        self.files.add(file)
+        if offset == 0 and size <= FLASH_INLINE_SIZE:
+            self.physical += round_up(size, FLASH_PROG_SIZE)
+        else:
+            tail = offset % FLASH_BLOCK_SIZE
+            self.physical += round_up(tail + size, FLASH_PROG_SIZE)
+            self.erases += round_up(tail + size, FLASH_BLOCK_SIZE) // FLASH_BLOCK_SIZE
+        self.commit()
+
+
+class Device:
+    def __init__(self, config_bytes):
+        self.wear = FlashWear()
+        self.journal_size = 0
+        self.log_slots_used = 0
+        self.uptime_unjournaled = False
+        self.config_bytes = config_bytes
+
+    def journal_compact(self):
+        records = self.log_slots_used + 1 + WEAR_ENTRIES
+        self.wear.write("runtime.tmp", 0, records * JOURNAL_RECORD_SIZE)
+        self.wear.commit()  # remove
+        self.wear.commit()  # rename
+        self.journal_size = records * JOURNAL_RECORD_SIZE
+
+    def journal_append(self, records):
+        size = records * JOURNAL_RECORD_SIZE
+        if self.journal_size + size > JOURNAL_COMPACT_SIZE:
+            self.journal_compact()
+            return
+        self.wear.write("runtime.log", self.journal_size, size)
+        self.journal_size += size
+
+    def uptime_log(self, hourly):
+        # Kept in RAM, journaled hourly with the wear counters
+        self.log_slots_used = min(self.log_slots_used + 1, LOG_SLOTS)
+        self.uptime_unjournaled = not hourly
+        if hourly:
+            self.journal_append(1 + WEAR_ENTRIES)
+
+    def countdown(self):
+        # A pending uptime record goes along
+        self.journal_append(2 if self.uptime_unjournaled else 1)
+        self.uptime_unjournaled = False
+
+    def save_config(self):
+        # The newest record becomes the previous one, the new one is written
+        self.wear.commit()  # rename
+        self.wear.write("config.bin", 0, self.config_bytes)
+
+    def restore(self):
+        self.save_config()
+        # Restart: uptime, countupdown and wear records in one append
+        self.journal_append(2 + WEAR_ENTRIES)
+        self.uptime_unjournaled = False
+
+
+def simulate(args):
+    device = Device(args.config_bytes)
+    slots = int(args.hours * 12)  # 5 minute uptime log records per day
+    events = [("countdown", args.countdowns), ("save", args.saves), ("restore", args.restores)]
+    due = {name: 0.0 for name, _ in events}
+
+    def day():
+        for slot in range(1, slots + 1):
+            device.uptime_log(slot % 12 == 0)
+            for name, per_day in events:
+                due[name] += per_day / max(slots, 1)
+                while due[name] >= 1:
+                    due[name] -= 1
+                    if name == "countdown":
+                        device.countdown()
+                    elif name == "save":
+                        device.save_config()
+                    else:
+                        device.restore()
+
+    # Settle the journal into its compaction cycle, then measure.
+    for _ in range(args.warmup):
+        day()
+    start = vars(device.wear).copy()
+    for _ in range(args.days):
+        day()
+    per_day = {k: (v - start[k]) / args.days for k, v in vars(device.wear).items() if k != "files"}
+    per_day["files"] = len(device.wear.files)
+    return per_day
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--hours", type=float, default=24, help="powered hours per day (default 24)")
+    parser.add_argument("--saves", type=float, default=10, help="settings saves per day (default 10)")
+    parser.add_argument("--countdowns", type=float, default=20, help="countup/down changes per day (default 20)")
+    parser.add_argument("--restores", type=float, default=0, help="/restore calls per day (default 0)")
+    parser.add_argument("--config-bytes", type=int, default=180,
+                        help="settings record size, header and packed strings (default 180)")
+    parser.add_argument("--fs-kb", type=int, default=1024, help="LittleFS partition size in KB (default 1024)")
+    parser.add_argument("--days", type=int, default=30, help="days to average over (default 30)")
+    parser.add_argument("--warmup", type=int, default=7, help="days to run before measuring (default 7)")
+    args = parser.parse_args()
+
+    per_day = simulate(args)
+    blocks = args.fs_kb * 1024 // FLASH_BLOCK_SIZE
+    print("logical bytes/day   %10.0f" % per_day["logical"])
+    print("physical bytes/day  %10.0f  (x%.1f)" % (per_day["physical"], per_day["physical"] / max(per_day["logical"], 1)))
+    print("erases/day          %10.1f" % per_day["erases"])
+    print("write sessions/day  %10.1f  (%d files)" % (per_day["sessions"], per_day["files"]))
+    if per_day["erases"] > 0:
+        years = blocks * FLASH_ENDURANCE / per_day["erases"] / 365.25
+        print("lifetime            %10.1f years (%d blocks, %d cycles each)" % (years, blocks, FLASH_ENDURANCE))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Generate include/tz_lookup.h from the IANA tz database.
+
+Every zone and alias in the database is mapped to the POSIX TZ string found
+in the footer of its compiled TZif file, which describes the zone's current
+rules. Morocco (Africa/Casablanca, Africa/El_Aaiun) is the one zone that
+footer gets wrong: its Ramadan switches are listed year by year in tzdata
+and have no POSIX form, so the clock shows standard time through them.
+The table is written sorted by name so the firmware can binary search
+it, with names and rules packed into PROGMEM string pools.
+
+The database is read from the Python tzdata package when it is installed
+(pip install tzdata), otherwise from the system zoneinfo directory. Rerun
+after tzdata releases and commit the result:
+
+    python tools/gen_tz_table.py
+"""
+
+import os
+import sys
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "tz_lookup.h")
+SYSTEM_ZONEINFO = ["/usr/share/zoneinfo", "/usr/lib/zoneinfo", "/usr/share/lib/zoneinfo"]
+
+
+def find_zoneinfo():
+    try:
+        import tzdata
+        return os.path.join(os.path.dirname(tzdata.__file__), "zoneinfo")
+    except ImportError:
+        pass
+    for path in SYSTEM_ZONEINFO:
+        if os.path.isfile(os.path.join(path, "tzdata.zi")):
+            return path
+    sys.exit("No tz database found, install it with: pip install tzdata")
+
+
+def read_version(root):
+    with open(os.path.join(root, "tzdata.zi")) as f:
+        first = f.readline().split()
+    return first[2] if len(first) == 3 and first[1] == "version" else "unknown"
+
+
+def read_zone_names(root):
+    # tzdata.zi lists every zone (Z) and alias (L), which skips the non-zone
+    # files (posix/, right/, leap tables) found in system directories.
+    names = set()
+    with open(os.path.join(root, "tzdata.zi")) as f:
+        for line in f:
+            fields = line.split()
+            if fields and fields[0] == "Z":
+                names.add(fields[1])
+            elif fields and fields[0] == "L":
+                names.add(fields[2])
+    return names
+
+
+def read_posix_rule(root, name):
+    with open(os.path.join(root, *name.split("/")), "rb") as f:
+        data = f.read()
+    if data[:4] != b"TZif" or data[4:5] < b"2":
+        raise ValueError(name + ": no TZif v2+ footer")
+    footer = data.rstrip(b"\n").rsplit(b"\n", 1)[1].decode("ascii")
+    if not footer:
+        raise ValueError(name + ": empty POSIX rule")
+    return footer
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '\\0"'
+
+
+def main():
+    root = find_zoneinfo()
+    version = read_version(root)
+    zones = {}
+    for name in read_zone_names(root):
+        try:
+            zones[name] = read_posix_rule(root, name)
+        except (OSError, ValueError) as e:
+            print("skipping", e, file=sys.stderr)
+    names = sorted(zones, key=lambda n: n.encode("ascii"))  # strcmp order
+
+    rules = sorted(set(zones.values()))
+    rule_offsets = {}
+    offset = 0
+    for rule in rules:
+        rule_offsets[rule] = offset
+        offset += len(rule) + 1
+    name_offsets = []
+    offset = 0
+    for name in names:
+        name_offsets.append(offset)
+        offset += len(name) + 1
+    if offset > 0xFFFF:
+        sys.exit("Name pool no longer fits 16 bit offsets")
+    posix_max = max(len(r) for r in rules)
+
+    out = []
+    out.append("#ifndef TZ_LOOKUP_H")
+    out.append("#define TZ_LOOKUP_H")
+    out.append("")
+    out.append("// Generated by tools/gen_tz_table.py from tzdata %s, do not edit." % version)
+    out.append("// Every IANA zone and alias mapped to the POSIX TZ string for its current")
+    out.append("// rules. Entries are sorted by name (strcmp order) for a binary search; names")
+    out.append("// and rules live in PROGMEM string pools referenced by offset.")
+    out.append("")
+    out.append('#include "host_compat.h"')
+    out.append("")
+    out.append('#define TZ_DATA_VERSION "%s"' % version)
+    out.append("#define TZ_ZONE_COUNT   %d" % len(names))
+    out.append("#define TZ_POSIX_MAX    %d" % posix_max)
+    out.append("")
+    out.append("typedef struct {")
+    out.append("    uint16_t name;   // Offset into tz_names")
+    out.append("    uint16_t posix;  // Offset into tz_posix")
+    out.append("} TimeZoneEntry;")
+    out.append("")
+    out.append("static const char tz_posix[] PROGMEM =")
+    for rule in rules:
+        out.append("    " + c_string(rule))
+    out[-1] += ";"
+    out.append("")
+    out.append("static const char tz_names[] PROGMEM =")
+    for name in names:
+        out.append("    " + c_string(name))
+    out[-1] += ";"
+    out.append("")
+    out.append("static const TimeZoneEntry tz_entries[TZ_ZONE_COUNT] PROGMEM = {")
+    entries = ["{%d,%d}" % (name_offsets[i], rule_offsets[zones[n]]) for i, n in enumerate(names)]
+    for i in range(0, len(entries), 8):
+        out.append("    " + ",".join(entries[i:i + 8]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("// POSIX TZ string for an IANA zone name, or UTC0 if the name is unknown.")
+    out.append("// The result is copied out of flash into a static buffer that is reused by")
+    out.append("// the next call.")
+    out.append("inline const char* ianaToPosix(const char* iana) {")
+    out.append("    static char posix[TZ_POSIX_MAX + 1];")
+    out.append("    size_t lo = 0;")
+    out.append("    size_t hi = TZ_ZONE_COUNT;")
+    out.append("    while (lo < hi) {")
+    out.append("        size_t mid = (lo + hi) / 2;")
+    out.append("        TimeZoneEntry entry;")
+    out.append("        memcpy_P(&entry, &tz_entries[mid], sizeof(entry));")
+    out.append("        int cmp = strcmp_P(iana, tz_names + entry.name);")
+    out.append("        if (cmp == 0) {")
+    out.append("            strcpy_P(posix, tz_posix + entry.posix);")
+    out.append("            return posix;")
+    out.append("        }")
+    out.append("        if (cmp < 0) {")
+    out.append("            hi = mid;")
+    out.append("        } else {")
+    out.append("            lo = mid + 1;")
+    out.append("        }")
+    out.append("    }")
+    out.append('    return "UTC0"; // fallback')
+    out.append("}")
+    out.append("")
+    out.append("#endif // TZ_LOOKUP_H")
+
+    with open(HEADER, "w", newline="\n") as f:
+        f.write("\n".join(out) + "\n")
+    print("%d zones, %d distinct rules, tzdata %s" % (len(names), len(rules), version))
+
+
+if __name__ == "__main__":
+    main()